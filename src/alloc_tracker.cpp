@@ -0,0 +1,182 @@
+#include "alloc_tracker.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<bool> trackingEnabled{false};
+static std::atomic<uint64_t> tagAllocs[kAllocTagCount];
+static std::atomic<uint64_t> tagBytes[kAllocTagCount];
+// Constant-initialized, so reading it from operator new never allocates.
+static thread_local AllocTag currentTag = AllocTag::other;
+static thread_local bool trapArmed = false;
+
+static void* tracked_malloc(size_t size)
+{
+    if (trackingEnabled.load(std::memory_order_relaxed))
+    {
+        const int tag = static_cast<int>(currentTag);
+        tagAllocs[tag].fetch_add(1, std::memory_order_relaxed);
+        tagBytes[tag].fetch_add(size, std::memory_order_relaxed);
+        if (trapArmed)
+        {
+            trapArmed = false;
+            fprintf(stderr,
+                    "allocation of %zu bytes (tag %s) inside a no-allocation "
+                    "scope\n",
+                    size,
+                    alloc_tag_name(currentTag));
+            abort();
+        }
+    }
+    return malloc(size ? size : 1);
+}
+
+void* operator new(size_t size)
+{
+    if (void* ptr = tracked_malloc(size))
+    {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) { return operator new(size); }
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    return tracked_malloc(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    return tracked_malloc(size);
+}
+
+void operator delete(void* ptr) noexcept { free(ptr); }
+void operator delete[](void* ptr) noexcept { free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { free(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { free(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { free(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept
+{
+    free(ptr);
+}
+
+const char* alloc_tag_name(AllocTag tag)
+{
+    switch (tag)
+    {
+        case AllocTag::other:
+            return "other";
+        case AllocTag::import:
+            return "import";
+        case AllocTag::makeScenes:
+            return "make_scenes";
+        case AllocTag::advance:
+            return "advance";
+        case AllocTag::draw:
+            return "draw";
+        case AllocTag::flush:
+            return "flush";
+        case AllocTag::titleUpdate:
+            return "title_update";
+        case AllocTag::logging:
+            return "logging";
+    }
+    return "unknown";
+}
+
+uint64_t AllocCounts::totalAllocs() const
+{
+    uint64_t total = 0;
+    for (uint64_t count : allocs)
+    {
+        total += count;
+    }
+    return total;
+}
+
+uint64_t AllocCounts::totalBytes() const
+{
+    uint64_t total = 0;
+    for (uint64_t count : bytes)
+    {
+        total += count;
+    }
+    return total;
+}
+
+AllocCounts AllocCounts::operator-(const AllocCounts& earlier) const
+{
+    AllocCounts delta;
+    for (int i = 0; i < kAllocTagCount; ++i)
+    {
+        delta.allocs[i] = allocs[i] - earlier.allocs[i];
+        delta.bytes[i] = bytes[i] - earlier.bytes[i];
+    }
+    return delta;
+}
+
+void alloc_tracking_enable()
+{
+    trackingEnabled.store(true, std::memory_order_relaxed);
+}
+
+bool alloc_tracking_enabled()
+{
+    return trackingEnabled.load(std::memory_order_relaxed);
+}
+
+AllocCounts alloc_counts()
+{
+    AllocCounts counts;
+    for (int i = 0; i < kAllocTagCount; ++i)
+    {
+        counts.allocs[i] = tagAllocs[i].load(std::memory_order_relaxed);
+        counts.bytes[i] = tagBytes[i].load(std::memory_order_relaxed);
+    }
+    return counts;
+}
+
+void print_alloc_counts(const AllocCounts& counts, uint64_t frameCount)
+{
+    const double frames = static_cast<double>(frameCount);
+    printf("allocations%s:\n", frameCount > 0 ? " (and per frame)" : "");
+    for (int i = 0; i <= kAllocTagCount; ++i)
+    {
+        const bool total = i == kAllocTagCount;
+        const uint64_t allocs = total ? counts.totalAllocs() : counts.allocs[i];
+        const uint64_t bytes = total ? counts.totalBytes() : counts.bytes[i];
+        if (allocs == 0 && !total)
+        {
+            continue;
+        }
+        printf("  %-12s %10llu allocs %12llu bytes",
+               total ? "total" : alloc_tag_name(static_cast<AllocTag>(i)),
+               static_cast<unsigned long long>(allocs),
+               static_cast<unsigned long long>(bytes));
+        if (frameCount > 0)
+        {
+            printf("  (%.1f allocs, %.0f bytes)",
+                   allocs / frames,
+                   bytes / frames);
+        }
+        printf("\n");
+    }
+}
+
+AllocTagScope::AllocTagScope(AllocTag tag) : m_previousTag(currentTag)
+{
+    currentTag = tag;
+}
+
+AllocTagScope::~AllocTagScope() { currentTag = m_previousTag; }
+
+AllocTrapScope::AllocTrapScope(bool armed) : m_previouslyArmed(trapArmed)
+{
+    trapArmed = armed;
+}
+
+AllocTrapScope::~AllocTrapScope() { trapArmed = m_previouslyArmed; }
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Counts operator new calls and bytes, attributed to the AllocTag active on
+// the allocating thread. The global operator new/delete are replaced in any
+// executable that calls into this file (lp_common is static, so others keep
+// the default ones); until alloc_tracking_enable() the hook only forwards to
+// malloc/free. C allocations (malloc inside codecs, drivers, stdio) and
+// over-aligned operator new are not seen.
+
+enum class AllocTag : uint8_t
+{
+    other,
+    import,
+    makeScenes,
+    advance,
+    draw,
+    flush,
+    titleUpdate,
+    logging,
+};
+
+constexpr static int kAllocTagCount = 8;
+
+const char* alloc_tag_name(AllocTag);
+
+struct AllocCounts
+{
+    uint64_t allocs[kAllocTagCount] = {};
+    uint64_t bytes[kAllocTagCount] = {};
+
+    uint64_t totalAllocs() const;
+    uint64_t totalBytes() const;
+    // Counts between an earlier snapshot and this one.
+    AllocCounts operator-(const AllocCounts& earlier) const;
+};
+
+void alloc_tracking_enable();
+bool alloc_tracking_enabled();
+// Totals since tracking was enabled.
+AllocCounts alloc_counts();
+// Prints per-tag counts, and per-frame averages when frameCount > 0.
+void print_alloc_counts(const AllocCounts&, uint64_t frameCount);
+
+// Attributes allocations on this thread to `tag` until destroyed.
+class AllocTagScope
+{
+public:
+    explicit AllocTagScope(AllocTag tag);
+    ~AllocTagScope();
+
+    AllocTagScope(const AllocTagScope&) = delete;
+    AllocTagScope& operator=(const AllocTagScope&) = delete;
+
+private:
+    const AllocTag m_previousTag;
+};
+
+// Debug trap for code that must not allocate: while an armed scope is alive,
+// an operator new on this thread prints its size and tag, then aborts so a
+// debugger or core dump shows the caller. Only checked once tracking is
+// enabled.
+class AllocTrapScope
+{
+public:
+    explicit AllocTrapScope(bool armed = true);
+    ~AllocTrapScope();
+
+    AllocTrapScope(const AllocTrapScope&) = delete;
+    AllocTrapScope& operator=(const AllocTrapScope&) = delete;
+
+private:
+    const bool m_previouslyArmed;
+};
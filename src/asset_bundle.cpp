@@ -0,0 +1,204 @@
+#include "asset_bundle.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <thread>
+#include <zlib.h>
+
+// Deflate can't expand data by more than about 1032:1, so a zlib entry that
+// claims more is corrupt; checked before load() sizes a buffer from it.
+constexpr static uint64_t kMaxZlibRatio = 1032;
+
+uint64_t bundle_hash(const void* data, size_t size)
+{
+    uint64_t hash = 0xcbf29ce484222325ull;
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+    }
+    return hash;
+}
+
+std::unique_ptr<AssetBundle> AssetBundle::Open(const std::string& path)
+{
+    std::unique_ptr<AssetBundle> bundle(new AssetBundle());
+    bundle->m_file = MappedFile::Open(path, MappedFile::Access::random);
+    if (!bundle->m_file)
+    {
+        return nullptr;
+    }
+    const uint8_t* data = bundle->m_file->data();
+    const size_t size = bundle->m_file->size();
+
+    BundleHeader header;
+    if (size < sizeof(header))
+    {
+        fprintf(stderr, "%s: not an asset bundle\n", path.c_str());
+        return nullptr;
+    }
+    memcpy(&header, data, sizeof(header));
+    if (memcmp(header.magic, kBundleMagic, sizeof(kBundleMagic)) != 0 ||
+        header.version != kBundleVersion)
+    {
+        fprintf(stderr,
+                "%s: not a version %u asset bundle\n",
+                path.c_str(),
+                kBundleVersion);
+        return nullptr;
+    }
+    const size_t indexEnd =
+        sizeof(header) + size_t(header.entryCount) * sizeof(BundleEntry);
+    if (indexEnd > size)
+    {
+        fprintf(stderr, "%s: truncated index\n", path.c_str());
+        return nullptr;
+    }
+    // The header is 16 bytes and the mapping page aligned, so the index is
+    // suitably aligned to read in place.
+    bundle->m_entries =
+        reinterpret_cast<const BundleEntry*>(data + sizeof(header));
+    bundle->m_entryCount = header.entryCount;
+    bundle->m_names = reinterpret_cast<const char*>(data + indexEnd);
+    for (size_t i = 0; i < bundle->m_entryCount; ++i)
+    {
+        const BundleEntry& entry = bundle->m_entries[i];
+        if (indexEnd + entry.nameOffset + entry.nameLength > size ||
+            entry.dataOffset > size || entry.storedSize > size - entry.dataOffset ||
+            (entry.compression == kBundleStored &&
+             entry.storedSize != entry.size) ||
+            (entry.compression == kBundleZlib &&
+             entry.size > entry.storedSize * kMaxZlibRatio) ||
+            entry.compression > kBundleZlib)
+        {
+            fprintf(stderr, "%s: entry %zu is corrupt\n", path.c_str(), i);
+            return nullptr;
+        }
+        // find() binary-searches the index.
+        if (i > 0 && entry.nameHash < bundle->m_entries[i - 1].nameHash)
+        {
+            fprintf(stderr, "%s: index is not sorted\n", path.c_str());
+            return nullptr;
+        }
+    }
+    return bundle;
+}
+
+std::string_view AssetBundle::name(const BundleEntry& entry) const
+{
+    return {m_names + entry.nameOffset, entry.nameLength};
+}
+
+const BundleEntry* AssetBundle::find(std::string_view entryName) const
+{
+    const uint64_t hash = bundle_hash(entryName.data(), entryName.size());
+    const BundleEntry* end = m_entries + m_entryCount;
+    for (const BundleEntry* entry = std::lower_bound(
+             m_entries,
+             end,
+             hash,
+             [](const BundleEntry& e, uint64_t h) { return e.nameHash < h; });
+         entry != end && entry->nameHash == hash;
+         ++entry)
+    {
+        if (name(*entry) == entryName)
+        {
+            return entry;
+        }
+    }
+    return nullptr;
+}
+
+bool AssetBundle::load(const BundleEntry& entry,
+                       BundleAsset* out,
+                       bool verify) const
+{
+    const uint8_t* stored = m_file->data() + entry.dataOffset;
+    if (entry.compression == kBundleStored)
+    {
+        out->storage.clear();
+        out->bytes = {stored, static_cast<size_t>(entry.size)};
+    }
+    else
+    {
+        out->storage.resize(entry.size);
+        uLongf size = static_cast<uLongf>(entry.size);
+        if (uncompress(out->storage.data(),
+                       &size,
+                       stored,
+                       static_cast<uLong>(entry.storedSize)) != Z_OK ||
+            size != entry.size)
+        {
+            fprintf(stderr,
+                    "asset bundle: failed to decompress %.*s\n",
+                    static_cast<int>(entry.nameLength),
+                    m_names + entry.nameOffset);
+            return false;
+        }
+        out->bytes = {out->storage.data(), out->storage.size()};
+    }
+    if (verify && bundle_hash(out->bytes.data(), out->bytes.size()) !=
+                      entry.contentHash)
+    {
+        fprintf(stderr,
+                "asset bundle: %.*s does not match its hash\n",
+                static_cast<int>(entry.nameLength),
+                m_names + entry.nameOffset);
+        return false;
+    }
+    return true;
+}
+
+bool AssetBundle::loadAll(const std::vector<const BundleEntry*>& entries,
+                          std::vector<BundleAsset>* out,
+                          int threadCount,
+                          bool verify) const
+{
+    out->clear();
+    out->resize(entries.size());
+    if (threadCount <= 0)
+    {
+        threadCount =
+            std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    }
+    threadCount = std::min<int>(threadCount, static_cast<int>(entries.size()));
+
+    // Workers claim entries one at a time, so one large entry doesn't hold up
+    // a fixed share of small ones.
+    std::atomic<size_t> next{0};
+    std::atomic<bool> ok{true};
+    auto work = [&]() {
+        for (size_t i = next++; i < entries.size(); i = next++)
+        {
+            if (!load(*entries[i], &(*out)[i], verify))
+            {
+                ok = false;
+            }
+        }
+    };
+    std::vector<std::thread> workers;
+    for (int i = 1; i < threadCount; ++i)
+    {
+        workers.emplace_back(work);
+    }
+    work();
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+    return ok;
+}
+
+const AssetBundle* getAssetBundle()
+{
+    static const std::unique_ptr<AssetBundle> bundle = []() {
+        const std::string path = getAssetPath("assets.lpb");
+        std::error_code error;
+        return std::filesystem::exists(path, error) ? AssetBundle::Open(path)
+                                                    : nullptr;
+    }();
+    return bundle.get();
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "asset_utils.hpp"
+
+#include "rive/span.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Packed asset bundle, built by lp_pack: every asset in one file, so startup
+// is one open and mmap instead of a filesystem lookup per asset.
+//
+// Layout, in host byte order:
+//   BundleHeader
+//   BundleEntry[entryCount], sorted by nameHash
+//   entry names, back to back (not terminated)
+//   entry data, each zlib-compressed or stored as is
+constexpr static char kBundleMagic[8] = {'L', 'P', 'B', 'U', 'N', 'D', 'L', 'E'};
+constexpr static uint32_t kBundleVersion = 1;
+
+struct BundleHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t entryCount;
+};
+
+enum BundleCompression : uint16_t
+{
+    kBundleStored = 0,
+    kBundleZlib = 1,
+};
+
+struct BundleEntry
+{
+    uint64_t nameHash;
+    uint64_t contentHash; // Of the uncompressed bytes.
+    uint64_t dataOffset;
+    uint64_t storedSize; // Bytes in the bundle.
+    uint64_t size;       // Bytes once decompressed.
+    uint32_t nameOffset;
+    uint16_t nameLength;
+    uint16_t compression;
+};
+
+// 64-bit FNV-1a, for names and contents.
+uint64_t bundle_hash(const void* data, size_t size);
+
+// One loaded entry: a view into the bundle's mapping when the entry is
+// stored, or into `storage` when it had to be decompressed.
+struct BundleAsset
+{
+    rive::Span<const uint8_t> bytes = {nullptr, 0};
+    std::vector<uint8_t> storage;
+};
+
+class AssetBundle
+{
+public:
+    // Prints the reason and returns null if the file is missing or corrupt.
+    static std::unique_ptr<AssetBundle> Open(const std::string& path);
+
+    size_t entryCount() const { return m_entryCount; }
+    const BundleEntry& entry(size_t index) const { return m_entries[index]; }
+    std::string_view name(const BundleEntry&) const;
+    const BundleEntry* find(std::string_view name) const;
+
+    // Views or decompresses one entry. With verify, also checks its content
+    // hash.
+    bool load(const BundleEntry&, BundleAsset* out, bool verify = false) const;
+    // Loads several entries in parallel on up to threadCount threads (0 = one
+    // per core). Fails if any entry does.
+    bool loadAll(const std::vector<const BundleEntry*>& entries,
+                 std::vector<BundleAsset>* out,
+                 int threadCount = 0,
+                 bool verify = false) const;
+
+private:
+    AssetBundle() = default;
+
+    std::unique_ptr<MappedFile> m_file;
+    const BundleEntry* m_entries = nullptr;
+    size_t m_entryCount = 0;
+    const char* m_names = nullptr;
+};
+
+// The bundle installed next to the executable's assets (assets.lpb), opened
+// on first use. Null when the build copied loose files instead.
+const AssetBundle* getAssetBundle();
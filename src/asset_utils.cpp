@@ -1,5 +1,9 @@
 #include "asset_utils.hpp"
+#include <chrono>
+#include <cstdio>
 #include <filesystem>
+#include <fstream>
+#include <iterator>
 
 #if defined(__APPLE__)
 #include <CoreFoundation/CoreFoundation.h>
@@ -12,6 +16,13 @@
 #include <climits>
 #endif
 
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 std::string getAssetPath(const std::string &filename) {
 #if defined(__APPLE__)
   CFBundleRef mainBundle = CFBundleGetMainBundle();
@@ -34,28 +45,139 @@ std::string getAssetPath(const std::string &filename) {
 
 #endif
 
-  //other platforms
-  std::filesystem::path exePath;
+  //other platforms; the executable's directory doesn't change, so resolve it
+  //once rather than per asset
+  static const std::filesystem::path exeDir = []() {
+    std::filesystem::path exePath;
 #if defined(_WIN32)
-  char buffer[MAX_PATH];
-  GetModuleFileName(NULL, buffer, MAX_PATH);
-  exePath = std::filesystem::path(buffer);
+    char buffer[MAX_PATH];
+    GetModuleFileName(NULL, buffer, MAX_PATH);
+    exePath = std::filesystem::path(buffer);
 #elif defined(__linux__)
-  char buffer[PATH_MAX];
-  ssize_t len = readlink("/proc/self/exe", buffer, sizeof(buffer) - 1);
-  if (len > 0) {
-    buffer[len] = '\0';
-    exePath = buffer;
-  }
+    char buffer[PATH_MAX];
+    ssize_t len = readlink("/proc/self/exe", buffer, sizeof(buffer) - 1);
+    if (len > 0) {
+      buffer[len] = '\0';
+      exePath = buffer;
+    }
 #elif defined(__APPLE__)
-  // apple fallback for if there's no bundle
-  char buffer[PATH_MAX];
-  uint32_t size = sizeof(buffer);
-  if (_NSGetExecutablePath(buffer, &size) == 0) {
-    exePath = buffer;
-  }
+    // apple fallback for if there's no bundle
+    char buffer[PATH_MAX];
+    uint32_t size = sizeof(buffer);
+    if (_NSGetExecutablePath(buffer, &size) == 0) {
+      exePath = buffer;
+    }
 #endif
-  auto exeDir = exePath.parent_path();
+    return exePath.parent_path();
+  }();
   auto assetPath = exeDir / "assets" / filename;
   return assetPath.string();
 }
+
+std::unique_ptr<MappedFile> MappedFile::Open(const std::string &path,
+                                             Access access) {
+  auto start = std::chrono::steady_clock::now();
+  std::unique_ptr<MappedFile> file(new MappedFile());
+#if defined(_WIN32)
+  HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                              nullptr, OPEN_EXISTING,
+                              access == Access::sequential
+                                  ? FILE_FLAG_SEQUENTIAL_SCAN
+                                  : access == Access::random
+                                        ? FILE_FLAG_RANDOM_ACCESS
+                                        : FILE_ATTRIBUTE_NORMAL,
+                              nullptr);
+  if (handle == INVALID_HANDLE_VALUE) {
+    fprintf(stderr, "Failed to open %s\n", path.c_str());
+    return nullptr;
+  }
+  LARGE_INTEGER size;
+  if (GetFileSizeEx(handle, &size) && size.QuadPart > 0) {
+    file->m_mappingHandle =
+        CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (file->m_mappingHandle != nullptr) {
+      file->m_data = static_cast<const uint8_t *>(
+          MapViewOfFile(file->m_mappingHandle, FILE_MAP_READ, 0, 0, 0));
+      if (file->m_data != nullptr) {
+        file->m_size = static_cast<size_t>(size.QuadPart);
+        file->m_mapped = true;
+      } else {
+        // Falls back to reading; nothing else will close the mapping.
+        CloseHandle(file->m_mappingHandle);
+        file->m_mappingHandle = nullptr;
+      }
+    }
+  }
+  CloseHandle(handle);
+#else
+  int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    fprintf(stderr, "Failed to open %s\n", path.c_str());
+    return nullptr;
+  }
+  struct stat info;
+  if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+    void *data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ,
+                      MAP_PRIVATE, fd, 0);
+    if (data != MAP_FAILED) {
+      file->m_data = static_cast<const uint8_t *>(data);
+      file->m_size = static_cast<size_t>(info.st_size);
+      file->m_mapped = true;
+      switch (access) {
+      case Access::normal:
+        break;
+      case Access::sequential:
+        madvise(data, file->m_size, MADV_SEQUENTIAL);
+        madvise(data, file->m_size, MADV_WILLNEED);
+        break;
+      case Access::random:
+        madvise(data, file->m_size, MADV_RANDOM);
+        break;
+      }
+    }
+  }
+  // The mapping keeps its own reference to the file.
+  close(fd);
+#endif
+  if (!file->m_mapped) {
+    std::ifstream stream(path, std::ios::binary);
+    if (!stream.is_open()) {
+      fprintf(stderr, "Failed to open %s\n", path.c_str());
+      return nullptr;
+    }
+    const std::streamoff size =
+        stream.seekg(0, std::ios::end) ? std::streamoff(stream.tellg()) : -1;
+    if (size > 0) {
+      file->m_fallback.resize(static_cast<size_t>(size));
+      stream.seekg(0);
+      // A short read would hand zero-filled bytes to the importer.
+      if (!stream.read(reinterpret_cast<char *>(file->m_fallback.data()),
+                       file->m_fallback.size())) {
+        fprintf(stderr, "Failed to read %s\n", path.c_str());
+        return nullptr;
+      }
+    } else {
+      // Not seekable; read to the end.
+      stream.clear();
+      file->m_fallback.assign(std::istreambuf_iterator<char>(stream), {});
+    }
+    file->m_data = file->m_fallback.data();
+    file->m_size = file->m_fallback.size();
+  }
+  file->m_openMs = std::chrono::duration<double, std::milli>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  return file;
+}
+
+MappedFile::~MappedFile() {
+  if (!m_mapped) {
+    return;
+  }
+#if defined(_WIN32)
+  UnmapViewOfFile(m_data);
+  CloseHandle(m_mappingHandle);
+#else
+  munmap(const_cast<uint8_t *>(m_data), m_size);
+#endif
+}
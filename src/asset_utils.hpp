@@ -1,4 +1,54 @@
 #pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <vector>
 
-std::string getAssetPath(const std::string &filename);
\ No newline at end of file
+#include "rive/span.hpp"
+
+std::string getAssetPath(const std::string &filename);
+
+// Read-only view of a whole file, memory-mapped (mmap / Win32 file mapping)
+// so File::import can parse it in place instead of from a copy. Falls back to
+// reading into memory where mapping fails (empty files, pipes). The bytes
+// stay valid for the lifetime of the object.
+class MappedFile {
+public:
+  // How the pages will be touched; forwarded to madvise where available.
+  enum class Access {
+    normal,
+    // One front-to-back pass (File::import): aggressive readahead, and the
+    // read-ahead starts right away.
+    sequential,
+    // Scattered reads (bundle entries): no readahead.
+    random,
+  };
+
+  // Prints the reason and returns null on failure.
+  static std::unique_ptr<MappedFile> Open(const std::string &path,
+                                          Access access = Access::normal);
+  ~MappedFile();
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  const uint8_t *data() const { return m_data; }
+  size_t size() const { return m_size; }
+  rive::Span<const uint8_t> bytes() const { return {m_data, m_size}; }
+  bool isMapped() const { return m_mapped; }
+  // Wall time Open() took.
+  double openMs() const { return m_openMs; }
+
+private:
+  MappedFile() = default;
+
+  const uint8_t *m_data = nullptr;
+  size_t m_size = 0;
+  bool m_mapped = false;
+  double m_openMs = 0;
+  std::vector<uint8_t> m_fallback;
+#if defined(_WIN32)
+  void *m_mappingHandle = nullptr;
+#endif
+};
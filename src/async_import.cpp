@@ -0,0 +1,410 @@
+#include "async_import.hpp"
+
+#include "alloc_tracker.hpp"
+#include "trace_events.hpp"
+
+#include "rive/assets/font_asset.hpp"
+#include "rive/assets/image_asset.hpp"
+#include "rive/decoders/bitmap_decoder.hpp"
+#include "rive/file_asset_loader.hpp"
+#include "rive/renderer/render_context.hpp"
+#include "rive/renderer/rive_render_image.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+
+namespace
+{
+double elapsed_ms(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(
+               std::chrono::steady_clock::now() - start)
+        .count();
+}
+
+// Runs decode jobs on up to threadCount threads, started as jobs arrive.
+class DecodePool
+{
+public:
+    explicit DecodePool(int threadCount) : m_threadCount(threadCount) {}
+    ~DecodePool() { finish(); }
+
+    DecodePool(const DecodePool&) = delete;
+    DecodePool& operator=(const DecodePool&) = delete;
+
+    int threadsStarted() const { return m_threadsStarted; }
+
+    void submit(std::function<void()> job)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_jobs.push_back(std::move(job));
+        }
+        if (m_threadsStarted < m_threadCount)
+        {
+            m_workers.emplace_back(&DecodePool::workerMain, this);
+            ++m_threadsStarted;
+        }
+        m_jobsChanged.notify_one();
+    }
+
+    // Helps with what is still queued, then waits for the workers.
+    void finish()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_closed = true;
+        }
+        m_jobsChanged.notify_all();
+        while (std::function<void()> job = pop(false))
+        {
+            job();
+        }
+        for (std::thread& worker : m_workers)
+        {
+            worker.join();
+        }
+        m_workers.clear();
+    }
+
+private:
+    std::function<void()> pop(bool wait)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (wait)
+        {
+            m_jobsChanged.wait(lock,
+                               [this] { return !m_jobs.empty() || m_closed; });
+        }
+        if (m_jobs.empty())
+        {
+            return nullptr;
+        }
+        std::function<void()> job = std::move(m_jobs.front());
+        m_jobs.pop_front();
+        return job;
+    }
+
+    void workerMain()
+    {
+        if (g_traceEnabled.load(std::memory_order_relaxed))
+        {
+            trace_set_thread_name("asset decode");
+        }
+        AllocTagScope allocTag(AllocTag::import);
+        while (std::function<void()> job = pop(true))
+        {
+            job();
+        }
+    }
+
+    const int m_threadCount;
+    std::mutex m_mutex;
+    std::condition_variable m_jobsChanged;
+    std::deque<std::function<void()>> m_jobs;
+    bool m_closed = false;
+    std::vector<std::thread> m_workers; // Importing thread only.
+    int m_threadsStarted = 0;
+};
+
+struct DeferredFont
+{
+    rive::FontAsset* asset;
+    rive::rcp<rive::Font> font;
+};
+
+// Claims every in-band image and font so import doesn't decode them inline.
+// Their decodes go to the pool; finish() waits for them, attaches the fonts
+// and hands the images on for AsyncRivImport::AttachImages().
+class DeferredAssetLoader : public rive::FileAssetLoader
+{
+public:
+    DeferredAssetLoader(DecodePool* pool,
+                        rive::Factory* factory,
+                        bool decodeImages,
+                        DecodedImageCache* imageCache) :
+        m_pool(pool),
+        m_factory(factory),
+        m_decodeImages(decodeImages),
+        m_imageCache(imageCache)
+    {}
+
+    bool loadContents(rive::FileAsset& asset,
+                      rive::Span<const uint8_t> inBandBytes,
+                      rive::Factory*) override
+    {
+        if (inBandBytes.size() == 0)
+        {
+            return false;
+        }
+        if (asset.is<rive::ImageAsset>())
+        {
+            // Deques, so the pool can fill in entries while more are added.
+            AsyncRivImport::DeferredImage* image = &m_images.emplace_back(
+                AsyncRivImport::DeferredImage{asset.as<rive::ImageAsset>(),
+                                              inBandBytes,
+                                              nullptr,
+                                              nullptr});
+            if (m_decodeImages)
+            {
+                m_pool->submit([this, image]() { decodeImage(image); });
+            }
+            return true;
+        }
+        if (asset.is<rive::FontAsset>())
+        {
+            DeferredFont* font = &m_fonts.emplace_back(
+                DeferredFont{asset.as<rive::FontAsset>(), nullptr});
+            m_pool->submit([this, font, inBandBytes]() {
+                LP_TRACE_SCOPE("decode font");
+                auto start = std::chrono::steady_clock::now();
+                // Fonts are HarfBuzz objects, safe to create off the
+                // importing thread.
+                font->font = m_factory->decodeFont(inBandBytes);
+                addDecodeMs(elapsed_ms(start));
+            });
+            return true;
+        }
+        return false;
+    }
+
+    void finish(AsyncRivImport::Result* result)
+    {
+        m_pool->finish();
+        for (DeferredFont& font : m_fonts)
+        {
+            if (font.font)
+            {
+                font.asset->font(std::move(font.font));
+            }
+        }
+        for (AsyncRivImport::DeferredImage& image : m_images)
+        {
+            result->deferredImages.push_back(std::move(image));
+        }
+        result->decodeMs = m_decodeMs;
+        result->decodeThreads = m_pool->threadsStarted() + 1;
+        result->imageCacheHits = m_imageCacheHits;
+    }
+
+private:
+    void decodeImage(AsyncRivImport::DeferredImage* image)
+    {
+        LP_TRACE_SCOPE("decode image");
+        auto start = std::chrono::steady_clock::now();
+        if (m_imageCache != nullptr)
+        {
+            image->cached = m_imageCache->lookup(image->encodedBytes);
+            if (image->cached)
+            {
+                ++m_imageCacheHits;
+                addDecodeMs(elapsed_ms(start));
+                return;
+            }
+        }
+        std::unique_ptr<rive::Bitmap> bitmap =
+            rive::Bitmap::decode(image->encodedBytes.data(),
+                                 image->encodedBytes.size());
+        if (bitmap)
+        {
+            // The format RenderContextImpl::makeImageTexture() takes.
+            bitmap->pixelFormat(rive::Bitmap::PixelFormat::RGBAPremul);
+            if (m_imageCache != nullptr)
+            {
+                m_imageCache->store(image->encodedBytes,
+                                    bitmap->width(),
+                                    bitmap->height(),
+                                    bitmap->bytes());
+            }
+        }
+        image->bitmap = std::move(bitmap);
+        addDecodeMs(elapsed_ms(start));
+    }
+
+    void addDecodeMs(double ms)
+    {
+        std::lock_guard<std::mutex> lock(m_decodeMsMutex);
+        m_decodeMs += ms;
+    }
+
+    DecodePool* const m_pool;
+    rive::Factory* const m_factory;
+    const bool m_decodeImages;
+    DecodedImageCache* const m_imageCache;
+    std::atomic<int> m_imageCacheHits{0};
+    std::deque<AsyncRivImport::DeferredImage> m_images;
+    std::deque<DeferredFont> m_fonts;
+    std::mutex m_decodeMsMutex;
+    double m_decodeMs = 0;
+};
+} // namespace
+
+std::unique_ptr<AsyncRivImport> AsyncRivImport::Start(
+    std::string path,
+    rive::Factory* factory,
+    rive::gpu::RenderContext* uploadContext,
+    DecodedImageCache* imageCache)
+{
+    std::unique_ptr<AsyncRivImport> import(new AsyncRivImport(std::move(path),
+                                                              nullptr,
+                                                              nullptr,
+                                                              factory,
+                                                              uploadContext,
+                                                              imageCache));
+    import->m_worker = std::thread(&AsyncRivImport::workerMain, import.get());
+    return import;
+}
+
+std::unique_ptr<AsyncRivImport> AsyncRivImport::Start(
+    const AssetBundle* bundle,
+    const BundleEntry* entry,
+    rive::Factory* factory,
+    rive::gpu::RenderContext* uploadContext,
+    DecodedImageCache* imageCache)
+{
+    std::unique_ptr<AsyncRivImport> import(
+        new AsyncRivImport(std::string(bundle->name(*entry)),
+                           bundle,
+                           entry,
+                           factory,
+                           uploadContext,
+                           imageCache));
+    import->m_worker = std::thread(&AsyncRivImport::workerMain, import.get());
+    return import;
+}
+
+AsyncRivImport::AsyncRivImport(std::string path,
+                               const AssetBundle* bundle,
+                               const BundleEntry* entry,
+                               rive::Factory* factory,
+                               rive::gpu::RenderContext* uploadContext,
+                               DecodedImageCache* imageCache) :
+    m_path(std::move(path)),
+    m_bundle(bundle),
+    m_bundleEntry(entry),
+    m_factory(factory),
+    m_uploadContext(uploadContext),
+    m_imageCache(imageCache)
+{}
+
+AsyncRivImport::~AsyncRivImport()
+{
+    m_worker.join();
+    // A result nobody took.
+    delete m_result.load(std::memory_order_acquire);
+}
+
+void AsyncRivImport::workerMain()
+{
+    if (g_traceEnabled.load(std::memory_order_relaxed))
+    {
+        // Rings are never freed, so only claim one when tracing.
+        trace_set_thread_name("riv import");
+    }
+    LP_TRACE_SCOPE("AsyncRivImport");
+    AllocTagScope allocTag(AllocTag::import);
+    auto start = std::chrono::steady_clock::now();
+    auto result = std::make_unique<Result>();
+    rive::Span<const uint8_t> bytes = {nullptr, 0};
+    if (m_bundle != nullptr)
+    {
+        if (m_bundle->load(*m_bundleEntry, &result->bundleAsset))
+        {
+            bytes = result->bundleAsset.bytes;
+            result->source = m_bundleEntry->compression == kBundleZlib
+                                 ? "bundle, inflated"
+                                 : "bundle, mapped";
+        }
+    }
+    else if ((result->mapping =
+                  MappedFile::Open(m_path, MappedFile::Access::sequential)))
+    {
+        bytes = result->mapping->bytes();
+        result->source = result->mapping->isMapped() ? "mapped" : "read";
+    }
+    result->byteCount = bytes.size();
+    result->openMs = elapsed_ms(start);
+    if (bytes.data() != nullptr)
+    {
+        // This thread keeps parsing while the pool decodes, and helps it
+        // drain once import is done.
+        DecodePool pool(
+            std::max(1, static_cast<int>(std::thread::hardware_concurrency()) -
+                            1));
+        auto loader = rive::make_rcp<DeferredAssetLoader>(
+            &pool,
+            m_factory,
+            m_uploadContext != nullptr,
+            m_uploadContext != nullptr ? m_imageCache : nullptr);
+        result->file =
+            rive::File::import(bytes, m_factory, nullptr, loader);
+        loader->finish(result.get());
+        result->uploadContext = m_uploadContext;
+    }
+    if (!result->file)
+    {
+        result->deferredImages.clear();
+    }
+    result->importMs = elapsed_ms(start);
+    // Release: everything above is visible to whoever acquires the pointer.
+    m_result.store(result.release(), std::memory_order_release);
+    m_result.notify_all();
+}
+
+std::unique_ptr<AsyncRivImport::Result> AsyncRivImport::poll()
+{
+    if (m_taken)
+    {
+        return nullptr;
+    }
+    Result* result = m_result.exchange(nullptr, std::memory_order_acquire);
+    m_taken = result != nullptr;
+    return std::unique_ptr<Result>(result);
+}
+
+std::unique_ptr<AsyncRivImport::Result> AsyncRivImport::get()
+{
+    if (!m_taken)
+    {
+        m_result.wait(nullptr, std::memory_order_acquire);
+    }
+    return poll();
+}
+
+void AsyncRivImport::AttachImages(Result* result, rive::Factory* factory)
+{
+    LP_TRACE_SCOPE("AttachImages");
+    for (const DeferredImage& image : result->deferredImages)
+    {
+        if ((image.bitmap || image.cached) && result->uploadContext)
+        {
+            const uint32_t width =
+                image.cached ? image.cached->width() : image.bitmap->width();
+            const uint32_t height =
+                image.cached ? image.cached->height() : image.bitmap->height();
+            rive::rcp<rive::gpu::Texture> texture =
+                result->uploadContext
+                    ->static_impl_cast<rive::gpu::RenderContextImpl>()
+                    ->makeImageTexture(width,
+                                       height,
+                                       std::bit_width(width | height),
+                                       image.cached ? image.cached->pixels()
+                                                    : image.bitmap->bytes());
+            if (texture)
+            {
+                image.asset->renderImage(
+                    rive::make_rcp<rive::RiveRenderImage>(std::move(texture)));
+                continue;
+            }
+        }
+        // Not predecoded, or the decoders couldn't read it (a platform
+        // decoder behind the factory still might).
+        image.asset->renderImage(factory->decodeImage(image.encodedBytes));
+    }
+    result->deferredImages.clear();
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#include "asset_bundle.hpp"
+#include "asset_utils.hpp"
+#include "image_cache.hpp"
+
+#include "rive/decoders/bitmap_decoder.hpp"
+#include "rive/file.hpp"
+#include "rive/span.hpp"
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace rive
+{
+class Factory;
+class ImageAsset;
+namespace gpu
+{
+class RenderContext;
+} // namespace gpu
+} // namespace rive
+
+// Maps (or pulls from the asset bundle) and imports a .riv on a worker thread so the render loop keeps
+// presenting while it loads.
+//
+// Creating textures is the one part of import that must happen on the render
+// thread (GL contexts are thread-bound, and no backend's factory is safe to
+// upload from two threads), so the worker holds image assets back and
+// AttachImages() uploads them once the file has been handed over. Paths and
+// paints are CPU objects and are created on the worker.
+//
+// Decoding is taken off import's critical path: as import reaches each
+// in-band image and font, it queues the decode on a pool and moves on, so a
+// file with many large images costs roughly its slowest image rather than
+// their sum. Images decode to premultiplied RGBA bitmaps when the factory is
+// a RenderContext that can take them; otherwise the encoded bytes are kept
+// and AttachImages() decodes through the factory as before. Fonts are
+// attached on the worker before the handoff. With a DecodedImageCache, a
+// predecoded image is mapped from the cache when it has been seen before and
+// stored there after decoding when it hasn't.
+//
+// The handoff is a single atomic pointer: the worker publishes the result
+// once, and the render thread either polls it (never blocking) or waits on
+// it like a future.
+class AsyncRivImport
+{
+public:
+    struct DeferredImage
+    {
+        rive::ImageAsset* asset; // Owned by the file.
+        rive::Span<const uint8_t> encodedBytes; // Points into the .riv.
+        std::unique_ptr<rive::Bitmap> bitmap;    // Null if not predecoded.
+        std::unique_ptr<CachedImage> cached;     // Set instead on a cache hit.
+    };
+
+    // Keep alive for as long as the file: it references the bytes.
+    struct Result
+    {
+        std::unique_ptr<MappedFile> mapping; // When loaded from a path.
+        BundleAsset bundleAsset;             // When loaded from the bundle.
+        std::unique_ptr<rive::File> file;    // Null if the load failed.
+        std::vector<DeferredImage> deferredImages;
+        size_t byteCount = 0;
+        const char* source = "";
+        double openMs = 0;   // Mapping, or pulling out of the bundle.
+        double importMs = 0; // Worker time, open through import.
+        // Decode time summed over the pool's threads, and the thread count.
+        double decodeMs = 0;
+        int decodeThreads = 0;
+        // Set when the bitmaps were decoded for this context to upload.
+        rive::gpu::RenderContext* uploadContext = nullptr;
+        int imageCacheHits = 0;
+    };
+
+    // Everything `factory` creates during import happens on the worker or
+    // the decode pool. Pass the render context as `uploadContext` when it is
+    // also the factory, to have images predecoded for it, and an
+    // `imageCache` (which must outlive the import) to reuse earlier decodes.
+    static std::unique_ptr<AsyncRivImport> Start(
+        std::string path,
+        rive::Factory* factory,
+        rive::gpu::RenderContext* uploadContext = nullptr,
+        DecodedImageCache* imageCache = nullptr);
+    // Loads `entry` from `bundle`, which must outlive the import's result.
+    static std::unique_ptr<AsyncRivImport> Start(
+        const AssetBundle* bundle,
+        const BundleEntry* entry,
+        rive::Factory* factory,
+        rive::gpu::RenderContext* uploadContext = nullptr,
+        DecodedImageCache* imageCache = nullptr);
+    // Waits for the worker.
+    ~AsyncRivImport();
+
+    AsyncRivImport(const AsyncRivImport&) = delete;
+    AsyncRivImport& operator=(const AsyncRivImport&) = delete;
+
+    const std::string& path() const { return m_path; }
+
+    // Returns the result the first time it is called after the import
+    // finished; null before that, and after.
+    std::unique_ptr<Result> poll();
+    // Like poll(), but waits for the import to finish.
+    std::unique_ptr<Result> get();
+
+    // Render thread: uploads the held-back images (or decodes them with
+    // `factory`, the one the file was imported with) and attaches them to
+    // their assets.
+    static void AttachImages(Result*, rive::Factory* factory);
+
+private:
+    AsyncRivImport(std::string path,
+                   const AssetBundle* bundle,
+                   const BundleEntry* entry,
+                   rive::Factory* factory,
+                   rive::gpu::RenderContext* uploadContext,
+                   DecodedImageCache* imageCache);
+    void workerMain();
+
+    const std::string m_path;
+    const AssetBundle* const m_bundle;
+    const BundleEntry* const m_bundleEntry;
+    rive::Factory* const m_factory;
+    rive::gpu::RenderContext* const m_uploadContext;
+    DecodedImageCache* const m_imageCache;
+    std::atomic<Result*> m_result{nullptr};
+    bool m_taken = false; // Render thread only.
+    std::thread m_worker;
+};
@@ -0,0 +1,36 @@
+#include "cpu_features.hpp"
+
+#if defined(LP_X86) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+static CPUFeatures detect_cpu_features()
+{
+    CPUFeatures features;
+#if defined(LP_X86)
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    features.sse41 = (info[2] & (1 << 19)) != 0;
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    __cpuidex(info, 7, 0);
+    // AVX2 also needs the OS to save YMM state across context switches.
+    features.avx2 = osxsave && avx && (info[1] & (1 << 5)) != 0 &&
+                    (_xgetbv(0) & 6) == 6;
+#else
+    __builtin_cpu_init();
+    features.sse41 = __builtin_cpu_supports("sse4.1");
+    features.avx2 = __builtin_cpu_supports("avx2");
+#endif
+#elif defined(LP_ARM_NEON)
+    features.neon = true;
+#endif
+    return features;
+}
+
+const CPUFeatures& cpu_features()
+{
+    static const CPUFeatures features = detect_cpu_features();
+    return features;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+// Runtime CPU feature detection for the SIMD kernels. Kernels for wider
+// instruction sets are compiled with a per-function target attribute and
+// only selected when cpu_features() reports support, so the binary still
+// runs on the baseline ISA.
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) ||            \
+    defined(_M_IX86)
+#define LP_X86 1
+#include <immintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+#define LP_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define LP_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+// MSVC accepts any intrinsic without per-function opt-in.
+#define LP_TARGET_SSE41
+#define LP_TARGET_AVX2
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+// NEON is part of the AArch64 baseline, so it needs no dispatch. (32-bit ARM
+// lacks the vector divide the kernels use and takes the scalar path.)
+#define LP_ARM_NEON 1
+#include <arm_neon.h>
+#endif
+
+struct CPUFeatures
+{
+    bool sse41 = false;
+    bool avx2 = false;
+    bool neon = false;
+};
+
+const CPUFeatures& cpu_features();
@@ -1,8 +1,12 @@
 #pragma once
 
+#include <array>
+#include <functional>
 #include <vector>
 
+#include "readback_convert.hpp"
 #include "rive/renderer/render_context.hpp"
+#include "rive/renderer/render_target.hpp"
 
 struct SDL_Window;
 
@@ -30,6 +34,39 @@ struct FiddleContextOptions
     const char* gpuNameFilter = nullptr; // Substring of GPU name to use.
 };
 
+// A frame whose pixels have reached the CPU, in whatever layout the backend
+// read them back in. `conversions` are the ReadbackConversion flags that
+// would bring them to RGBA, bottom row first (the layout end() writes to
+// pixelData); consumers fold them into their own conversion so each frame is
+// touched once. Pixels are only valid for the duration of the callback; they
+// may point straight into a mapped staging buffer.
+struct ReadbackFrame
+{
+    uint64_t frameNumber; // Counts endAsyncReadback() calls, starting at 0.
+    uint32_t width;
+    uint32_t height;
+    const uint8_t* pixels;
+    uint32_t conversions;
+};
+
+using ReadbackCallback = std::function<void(const ReadbackFrame&)>;
+
+// Number of frames endAsyncReadback() can keep in flight before it has to
+// wait on the oldest one.
+constexpr static int kReadbackRingSize = 4;
+
+// GPU execution time of one frame, from its first flush to the end of its
+// last, measured with timestamp queries.
+struct GPUFrameTime
+{
+    uint64_t frameNumber; // Counts end() calls, starting at 0.
+    double ms;
+};
+
+// Frames whose GPU timers can be unresolved at once. A frame that finds
+// every slot busy goes untimed rather than waiting.
+constexpr static int kGPUTimerRingSize = 8;
+
 class FiddleContext
 {
 public:
@@ -61,6 +98,53 @@ public:
         rive::gpu::RenderTarget* offscreenRenderTarget = nullptr) = 0;
     virtual void end(SDL_Window*,
                      std::vector<uint8_t>* pixelData = nullptr) = 0;
+
+    // Receives frames queued by endAsyncReadback().
+    void setReadbackCallback(ReadbackCallback callback)
+    {
+        m_readbackCallback = std::move(callback);
+    }
+    // Like end(pixelData), but queues the copy instead of stalling on it.
+    // Frame N is delivered to the readback callback from a later call, once
+    // the GPU is done with it, while frames N+1..N+k render. Backends without
+    // a readback ring fall back to a synchronous read.
+    virtual void endAsyncReadback(SDL_Window* window)
+    {
+        end(window, &m_syncReadbackPixels);
+        if (rive::gpu::RenderTarget* renderTarget = renderTargetOrNull())
+        {
+            deliverReadback(renderTarget->width(),
+                            renderTarget->height(),
+                            m_syncReadbackPixels.data());
+        }
+        else
+        {
+            skipReadback();
+        }
+    }
+    // Blocks until every queued readback has been delivered.
+    virtual void finishReadbacks() {}
+    // Blocks until every queued GPU timer has resolved, so the times of the
+    // last frames rendered can be polled.
+    virtual void finishGPUTimers() {}
+    // Pops the oldest frame whose GPU time has resolved, a few frames after
+    // it rendered. Never stalls; returns false when nothing is ready or the
+    // backend has no GPU timers (currently Vulkan and desktop GL do).
+    virtual bool pollGPUFrameTime(GPUFrameTime* gpuFrameTime)
+    {
+        if (m_gpuFrameTimeCount == 0)
+        {
+            return false;
+        }
+        *gpuFrameTime = m_gpuFrameTimes[m_gpuFrameTimeHead];
+        m_gpuFrameTimeHead =
+            (m_gpuFrameTimeHead + 1) % kMaxUnpolledGPUFrameTimes;
+        --m_gpuFrameTimeCount;
+        return true;
+    }
+    // Time the current frame waited to acquire a swapchain image (Vulkan) or
+    // drawable (Metal). Zero where acquiring is not a separate step.
+    double acquireWaitMs() const { return m_acquireWaitMs; }
     virtual void tick(){};
     virtual void hotloadShaders(){};
 
@@ -80,4 +164,57 @@ public:
         FiddleContextOptions = {});
     static std::unique_ptr<FiddleContext> MakeDawnPLS(
         FiddleContextOptions = {});
+    // CPU only: a real factory and a renderer that counts draws instead of
+    // rasterizing them. Always headless; end() reads back the clear color.
+    // Prints per-frame draw counts every reportInterval frames; 0 keeps it
+    // quiet, so timing output isn't interleaved with reports.
+    static std::unique_ptr<FiddleContext> MakeNull(int reportInterval = 0);
+
+protected:
+    // Hands the oldest in-flight frame to the readback callback. Frames must
+    // be delivered in the order they were queued.
+    void deliverReadback(uint32_t width,
+                         uint32_t height,
+                         const uint8_t* pixels,
+                         uint32_t conversions = 0)
+    {
+        if (m_readbackCallback)
+        {
+            m_readbackCallback(
+                {m_readbackFrameNumber, width, height, pixels, conversions});
+        }
+        ++m_readbackFrameNumber;
+    }
+
+    // Drops the oldest in-flight frame, e.g. when it could not be read, so
+    // later frames keep their numbers.
+    void skipReadback() { ++m_readbackFrameNumber; }
+
+    void setAcquireWaitMs(double ms) { m_acquireWaitMs = ms; }
+
+    void deliverGPUFrameTime(uint64_t frameNumber, double ms)
+    {
+        // Nobody may be polling; keep only the most recent results.
+        if (m_gpuFrameTimeCount == kMaxUnpolledGPUFrameTimes)
+        {
+            m_gpuFrameTimeHead =
+                (m_gpuFrameTimeHead + 1) % kMaxUnpolledGPUFrameTimes;
+            --m_gpuFrameTimeCount;
+        }
+        m_gpuFrameTimes[(m_gpuFrameTimeHead + m_gpuFrameTimeCount) %
+                        kMaxUnpolledGPUFrameTimes] = {frameNumber, ms};
+        ++m_gpuFrameTimeCount;
+    }
+
+private:
+    constexpr static size_t kMaxUnpolledGPUFrameTimes = 256;
+
+    double m_acquireWaitMs = 0;
+    ReadbackCallback m_readbackCallback;
+    uint64_t m_readbackFrameNumber = 0;
+    std::vector<uint8_t> m_syncReadbackPixels;
+    // Fixed ring, so delivering a time never allocates.
+    std::array<GPUFrameTime, kMaxUnpolledGPUFrameTimes> m_gpuFrameTimes;
+    size_t m_gpuFrameTimeHead = 0;
+    size_t m_gpuFrameTimeCount = 0;
 };
@@ -11,6 +11,7 @@ std::unique_ptr<FiddleContext> FiddleContext::MakeD3DPLS(FiddleContextOptions)
 
 #include "rive/renderer/rive_renderer.hpp"
 #include "rive/renderer/d3d11/render_context_d3d_impl.hpp"
+#include "readback_convert.hpp"
 #include <array>
 #include <dxgi1_2.h>
 
@@ -176,12 +177,13 @@ public:
                               0,
                               &map);
             pixelData->resize(h * w * 4);
-            for (uint32_t y = 0; y < h; ++y)
-            {
-                auto row =
-                    reinterpret_cast<const char*>(map.pData) + map.RowPitch * y;
-                memcpy(pixelData->data() + (h - y - 1) * w * 4, row, w * 4);
-            }
+            convert_readback(pixelData->data(),
+                             w * 4,
+                             reinterpret_cast<const uint8_t*>(map.pData),
+                             map.RowPitch,
+                             w,
+                             h,
+                             kReadbackFlipY);
             m_gpuContext->Unmap(m_readbackTexture.Get(), 0);
         }
 
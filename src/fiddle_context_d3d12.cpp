@@ -12,6 +12,7 @@ std::unique_ptr<FiddleContext> FiddleContext::MakeD3D12PLS(
 
 #include "rive/renderer/rive_renderer.hpp"
 #include "rive/renderer/d3d12/render_context_d3d12_impl.hpp"
+#include "readback_convert.hpp"
 #include <dxgi1_6.h>
 
 #define GLFW_INCLUDE_NONE
@@ -488,12 +489,13 @@ public:
                                       &range,
                                       reinterpret_cast<void**>(&mappedData)));
 
-        for (uint32_t y = 0; y < h; ++y)
-        {
-            auto row = reinterpret_cast<const char*>(mappedData) +
-                       footprint.Footprint.RowPitch * y;
-            memcpy(pixelData->data() + (h - y - 1) * w * 4, row, w * 4);
-        }
+        convert_readback(pixelData->data(),
+                         w * 4,
+                         mappedData,
+                         footprint.Footprint.RowPitch,
+                         w,
+                         h,
+                         kReadbackFlipY);
 
         D3D12_RANGE emptyRange{0, 0};
         readbackBuffer->Unmap(0, &emptyRange);
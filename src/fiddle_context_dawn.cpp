@@ -12,6 +12,7 @@ std::unique_ptr<FiddleContext> FiddleContext::MakeDawnPLS(
 
 #include "rive/renderer/rive_renderer.hpp"
 #include "rive/renderer/webgpu/render_context_webgpu_impl.hpp"
+#include "readback_convert.hpp"
 
 using namespace rive;
 using namespace rive::gpu;
@@ -363,14 +364,13 @@ public:
             pixelData->resize(h * w * 4);
             const uint8_t* pixelReadBuffData = reinterpret_cast<const uint8_t*>(
                 m_pixelReadBuff.GetConstMappedRange());
-            for (size_t y = 0; y < h; ++y)
-            {
-                // Flip Y.
-                const uint8_t* src =
-                    &pixelReadBuffData[(h - y - 1) * rowBytesInReadBuff];
-                size_t row = y * w * 4;
-                memcpy(pixelData->data() + row, src, w * 4);
-            }
+            convert_readback(pixelData->data(),
+                             w * 4,
+                             pixelReadBuffData,
+                             rowBytesInReadBuff,
+                             w,
+                             h,
+                             kReadbackFlipY);
             m_pixelReadBuff.Unmap();
         }
 
@@ -10,6 +10,7 @@ std::unique_ptr<FiddleContext> FiddleContext::MakeGLPLS(FiddleContextOptions)
 #else
 
 #include "path_fiddle.hpp"
+#include "trace_events.hpp"
 #include "rive/renderer/rive_renderer.hpp"
 #include "rive/renderer/gl/render_context_gl_impl.hpp"
 #include "rive/renderer/gl/render_target_gl.hpp"
@@ -21,6 +22,16 @@ std::unique_ptr<FiddleContext> FiddleContext::MakeGLPLS(FiddleContextOptions)
 
 #include <SDL3/SDL.h>
 
+#include <array>
+
+#if defined(RIVE_DESKTOP_GL) && defined(__linux__)
+// Headless GL goes through Mesa's surfaceless EGL platform, so it runs on
+// render nodes with no display server (llvmpipe, virgl, etc.).
+#define LP_HEADLESS_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
 using namespace rive;
 using namespace rive::gpu;
 
@@ -126,6 +137,7 @@ public:
 
     void end(SDL_Window* window, std::vector<uint8_t>* pixelData) final
     {
+        LP_TRACE_SCOPE("FiddleContext::end");
         onEnd(pixelData);
         if (m_zoomWindowFBO)
         {
@@ -182,14 +194,23 @@ private:
 class FiddleContextGL : public FiddleContextGLBase
 {
 public:
-    FiddleContextGL(FiddleContextOptions options)
+    FiddleContextGL(FiddleContextOptions options) :
+        m_isHeadless(options.allowHeadlessRendering)
     {
         printf("FiddleContextGL: Constructor start\n");
 #ifdef RIVE_DESKTOP_GL
+        GLADloadproc glLoader = (GLADloadproc)SDL_GL_GetProcAddress;
+#ifdef LP_HEADLESS_EGL
+        if (m_isHeadless)
+        {
+            makeSurfacelessContext();
+            glLoader = (GLADloadproc)eglGetProcAddress;
+        }
+#endif
         printf("FiddleContextGL: Starting GLAD initialization...\n");
         
-        // Test if SDL_GL_GetProcAddress is working
-        SDL_FunctionPointer testFunc = SDL_GL_GetProcAddress("glGetString");
+        // Test if the GL loader is working
+        void* testFunc = glLoader("glGetString");
         printf("FiddleContextGL: glGetString function pointer: %p\n", (void*)testFunc);
         
         // Try to call a basic OpenGL function to ensure context is ready
@@ -202,7 +223,7 @@ public:
         
         // Load the OpenGL API using glad.
         printf("FiddleContextGL: About to call gladLoadCustomLoader...\n");
-        if (!gladLoadCustomLoader((GLADloadproc)SDL_GL_GetProcAddress))
+        if (!gladLoadCustomLoader(glLoader))
         {
             fprintf(stderr, "Failed to initialize glad.\n");
             abort();
@@ -245,6 +266,52 @@ public:
             fprintf(stderr, "Failed to create a RiveRenderContext for GL.\n");
             abort();
         }
+
+#ifdef RIVE_DESKTOP_GL
+        // GL_TIME_ELAPSED and 64-bit query results are core in 3.3.
+        GLint major = 0, minor = 0;
+        glGetIntegerv(GL_MAJOR_VERSION, &major);
+        glGetIntegerv(GL_MINOR_VERSION, &minor);
+        m_gpuTimersSupported = major > 3 || (major == 3 && minor >= 3);
+        if (m_gpuTimersSupported)
+        {
+            for (GPUTimer& timer : m_gpuTimers)
+            {
+                glGenQueries(1, &timer.query);
+            }
+        }
+#endif
+    }
+
+    ~FiddleContextGL() override
+    {
+        for (AsyncReadback& readback : m_asyncReadbacks)
+        {
+            glDeleteSync(readback.fence);
+            glDeleteBuffers(1, &readback.pbo);
+        }
+        if (m_gpuTimersSupported)
+        {
+            for (GPUTimer& timer : m_gpuTimers)
+            {
+                glDeleteQueries(1, &timer.query);
+            }
+        }
+        m_renderTarget.reset();
+        m_renderContext.reset();
+        glDeleteFramebuffers(1, &m_headlessFBO);
+        glDeleteTextures(1, &m_headlessTexture);
+#ifdef LP_HEADLESS_EGL
+        if (m_eglDisplay != EGL_NO_DISPLAY)
+        {
+            eglMakeCurrent(m_eglDisplay,
+                           EGL_NO_SURFACE,
+                           EGL_NO_SURFACE,
+                           EGL_NO_CONTEXT);
+            eglDestroyContext(m_eglDisplay, m_eglContext);
+            eglTerminate(m_eglDisplay);
+        }
+#endif
     }
 
     rive::Factory* factory() final { return m_renderContext.get(); }
@@ -263,8 +330,40 @@ public:
                        int height,
                        uint32_t sampleCount) final
     {
-        m_renderTarget =
-            make_rcp<FramebufferRenderTargetGL>(width, height, 0, sampleCount);
+        // In-flight readbacks were sized for the old target.
+        finishReadbacks();
+
+        if (m_isHeadless)
+        {
+            // Draw straight into a texture. The FBO is only used to read it
+            // back; nothing is ever blitted to a window.
+            glDeleteFramebuffers(1, &m_headlessFBO);
+            glDeleteTextures(1, &m_headlessTexture);
+            glGenTextures(1, &m_headlessTexture);
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, m_headlessTexture);
+            glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, width, height);
+
+            glGenFramebuffers(1, &m_headlessFBO);
+            glBindFramebuffer(GL_FRAMEBUFFER, m_headlessFBO);
+            glFramebufferTexture2D(GL_FRAMEBUFFER,
+                                   GL_COLOR_ATTACHMENT0,
+                                   GL_TEXTURE_2D,
+                                   m_headlessTexture,
+                                   0);
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+            auto renderTarget = make_rcp<TextureRenderTargetGL>(width, height);
+            renderTarget->setTargetTexture(m_headlessTexture);
+            m_renderTarget = std::move(renderTarget);
+        }
+        else
+        {
+            m_renderTarget = make_rcp<FramebufferRenderTargetGL>(width,
+                                                                 height,
+                                                                 0,
+                                                                 sampleCount);
+        }
         glViewport(0, 0, width, height);
     }
 
@@ -275,12 +374,24 @@ public:
 
     void begin(const RenderContext::FrameDescriptor& frameDescriptor) final
     {
+        LP_TRACE_SCOPE("FiddleContext::begin");
         renderContextGLImpl()->invalidateGLState();
         m_renderContext->beginFrame(frameDescriptor);
+        // Nothing reaches the GPU until flush, so starting here times
+        // exactly the frame's flushes.
+        if (m_gpuTimersSupported &&
+            m_gpuTimersQueued - m_gpuTimersResolved < kGPUTimerRingSize)
+        {
+            glBeginQuery(
+                GL_TIME_ELAPSED,
+                m_gpuTimers[m_gpuTimersQueued % kGPUTimerRingSize].query);
+            m_gpuTimerOpen = true;
+        }
     }
 
     void flushPLSContext(RenderTarget* offscreenRenderTarget) final
     {
+        LP_TRACE_SCOPE("FiddleContext::flushPLSContext");
         m_renderContext->flush({
             .renderTarget = offscreenRenderTarget != nullptr
                                 ? offscreenRenderTarget
@@ -288,16 +399,61 @@ public:
         });
     }
 
+    void endAsyncReadback(SDL_Window* window) final
+    {
+        m_asyncReadbackRequested = true;
+        end(window, nullptr);
+    }
+
+    void finishReadbacks() final
+    {
+        while (m_asyncReadbacksDelivered < m_asyncReadbacksQueued)
+        {
+            AsyncReadback& readback =
+                m_asyncReadbacks[m_asyncReadbacksDelivered % kReadbackRingSize];
+            while (glClientWaitSync(readback.fence,
+                                    GL_SYNC_FLUSH_COMMANDS_BIT,
+                                    GL_TIMEOUT_IGNORED) == GL_TIMEOUT_EXPIRED)
+            {}
+            deliverOldestReadback();
+        }
+    }
+
+    void finishGPUTimers() final
+    {
+        if (m_gpuTimersResolved == m_gpuTimersQueued)
+        {
+            return;
+        }
+        glFinish();
+        resolveGPUTimers();
+    }
+
     void onEnd(std::vector<uint8_t>* pixelData) final
     {
         flushPLSContext(nullptr);
         renderContextGLImpl()->unbindGLInternalResources();
         glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        if (m_gpuTimerOpen)
+        {
+            glEndQuery(GL_TIME_ELAPSED);
+            m_gpuTimers[m_gpuTimersQueued % kGPUTimerRingSize].frameNumber =
+                m_frameNumber;
+            ++m_gpuTimersQueued;
+            m_gpuTimerOpen = false;
+        }
+        resolveGPUTimers();
+        ++m_frameNumber;
+        if (m_asyncReadbackRequested)
+        {
+            m_asyncReadbackRequested = false;
+            queueAsyncReadback();
+        }
         if (pixelData)
         {
             pixelData->resize(m_renderTarget->height() *
                               m_renderTarget->width() * 4);
-            glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, m_headlessFBO);
             glReadPixels(0,
                          0,
                          m_renderTarget->width(),
@@ -309,6 +465,201 @@ public:
     }
 
 private:
+    // One slot of the readback ring: a pixel pack buffer that glReadPixels
+    // copies into without stalling, and the fence that says when it landed.
+    struct AsyncReadback
+    {
+        GLuint pbo = 0;
+        GLsync fence = nullptr;
+        uint32_t width = 0;
+        uint32_t height = 0;
+    };
+
+    void queueAsyncReadback()
+    {
+        // Make room by draining the oldest frame if the ring is full. With
+        // kReadbackRingSize frames of slack this is almost always done.
+        if (m_asyncReadbacksQueued - m_asyncReadbacksDelivered ==
+            kReadbackRingSize)
+        {
+            AsyncReadback& oldest =
+                m_asyncReadbacks[m_asyncReadbacksDelivered % kReadbackRingSize];
+            glClientWaitSync(oldest.fence,
+                             GL_SYNC_FLUSH_COMMANDS_BIT,
+                             GL_TIMEOUT_IGNORED);
+            deliverOldestReadback();
+        }
+
+        AsyncReadback& readback =
+            m_asyncReadbacks[m_asyncReadbacksQueued % kReadbackRingSize];
+        uint32_t w = m_renderTarget->width();
+        uint32_t h = m_renderTarget->height();
+        if (readback.pbo == 0)
+        {
+            glGenBuffers(1, &readback.pbo);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.pbo);
+        if (readback.width != w || readback.height != h)
+        {
+            glBufferData(GL_PIXEL_PACK_BUFFER,
+                         w * h * 4,
+                         nullptr,
+                         GL_STREAM_READ);
+            readback.width = w;
+            readback.height = h;
+        }
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, m_headlessFBO);
+        glReadPixels(0, 0, w, h, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        ++m_asyncReadbacksQueued;
+
+        // Hand off whatever older frames have already finished, in order.
+        while (m_asyncReadbacksDelivered + 1 < m_asyncReadbacksQueued)
+        {
+            AsyncReadback& oldest =
+                m_asyncReadbacks[m_asyncReadbacksDelivered % kReadbackRingSize];
+            GLenum status = glClientWaitSync(oldest.fence, 0, 0);
+            if (status != GL_ALREADY_SIGNALED &&
+                status != GL_CONDITION_SATISFIED)
+            {
+                break;
+            }
+            deliverOldestReadback();
+        }
+    }
+
+    // The oldest queued readback's fence must have signaled.
+    void deliverOldestReadback()
+    {
+        AsyncReadback& readback =
+            m_asyncReadbacks[m_asyncReadbacksDelivered % kReadbackRingSize];
+        size_t size = readback.width * readback.height * 4;
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.pbo);
+        // Already bottom-up RGBA; deliver straight out of the mapping.
+        const void* contents =
+            glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT);
+        ++m_asyncReadbacksDelivered;
+        if (contents != nullptr)
+        {
+            deliverReadback(readback.width,
+                            readback.height,
+                            static_cast<const uint8_t*>(contents));
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        }
+        else
+        {
+            fprintf(stderr,
+                    "Failed to map readback buffer (GL error 0x%x)\n",
+                    glGetError());
+            skipReadback();
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        glDeleteSync(readback.fence);
+        readback.fence = nullptr;
+    }
+
+    // One slot of the GPU timer ring: a GL_TIME_ELAPSED query around a
+    // frame's flushes.
+    struct GPUTimer
+    {
+        GLuint query = 0;
+        uint64_t frameNumber = 0;
+    };
+
+    // Hands off every finished timer, in order, without waiting.
+    void resolveGPUTimers()
+    {
+        while (m_gpuTimersResolved < m_gpuTimersQueued)
+        {
+            const GPUTimer& timer =
+                m_gpuTimers[m_gpuTimersResolved % kGPUTimerRingSize];
+            GLint available = 0;
+            glGetQueryObjectiv(timer.query,
+                               GL_QUERY_RESULT_AVAILABLE,
+                               &available);
+            if (!available)
+            {
+                break;
+            }
+            GLuint64 elapsedNs = 0;
+            glGetQueryObjectui64v(timer.query, GL_QUERY_RESULT, &elapsedNs);
+            ++m_gpuTimersResolved;
+            deliverGPUFrameTime(timer.frameNumber, elapsedNs * 1e-6);
+        }
+    }
+
+#ifdef LP_HEADLESS_EGL
+    void makeSurfacelessContext()
+    {
+        auto eglGetPlatformDisplayEXT =
+            reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+                eglGetProcAddress("eglGetPlatformDisplayEXT"));
+        if (eglGetPlatformDisplayEXT == nullptr)
+        {
+            fprintf(stderr, "EGL_EXT_platform_base is not supported.\n");
+            abort();
+        }
+        m_eglDisplay = eglGetPlatformDisplayEXT(EGL_PLATFORM_SURFACELESS_MESA,
+                                                EGL_DEFAULT_DISPLAY,
+                                                nullptr);
+        EGLint major, minor;
+        if (m_eglDisplay == EGL_NO_DISPLAY ||
+            !eglInitialize(m_eglDisplay, &major, &minor))
+        {
+            fprintf(stderr, "Failed to initialize a surfaceless EGL display.\n");
+            abort();
+        }
+        printf("FiddleContextGL: Surfaceless EGL %i.%i\n", major, minor);
+
+        eglBindAPI(EGL_OPENGL_API);
+        const EGLint configAttribs[] = {
+            EGL_RENDERABLE_TYPE,
+            EGL_OPENGL_BIT,
+            EGL_NONE,
+        };
+        EGLConfig config;
+        EGLint configCount = 0;
+        if (!eglChooseConfig(m_eglDisplay,
+                             configAttribs,
+                             &config,
+                             1,
+                             &configCount) ||
+            configCount == 0)
+        {
+            fprintf(stderr, "No EGL config supports desktop GL.\n");
+            abort();
+        }
+        m_eglContext =
+            eglCreateContext(m_eglDisplay, config, EGL_NO_CONTEXT, nullptr);
+        if (m_eglContext == EGL_NO_CONTEXT ||
+            !eglMakeCurrent(m_eglDisplay,
+                            EGL_NO_SURFACE,
+                            EGL_NO_SURFACE,
+                            m_eglContext))
+        {
+            fprintf(stderr, "Failed to make a surfaceless GL context.\n");
+            abort();
+        }
+    }
+
+    EGLDisplay m_eglDisplay = EGL_NO_DISPLAY;
+    EGLContext m_eglContext = EGL_NO_CONTEXT;
+#endif
+
+    const bool m_isHeadless;
+    GLuint m_headlessTexture = 0;
+    GLuint m_headlessFBO = 0;
+    bool m_asyncReadbackRequested = false;
+    std::array<AsyncReadback, kReadbackRingSize> m_asyncReadbacks;
+    uint64_t m_asyncReadbacksQueued = 0;
+    uint64_t m_asyncReadbacksDelivered = 0;
+    bool m_gpuTimersSupported = false;
+    bool m_gpuTimerOpen = false;
+    std::array<GPUTimer, kGPUTimerRingSize> m_gpuTimers;
+    uint64_t m_gpuTimersQueued = 0;
+    uint64_t m_gpuTimersResolved = 0;
+    uint64_t m_frameNumber = 0;
     std::unique_ptr<RenderContext> m_renderContext;
     rcp<RenderTargetGL> m_renderTarget;
 };
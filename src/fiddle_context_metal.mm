@@ -1,6 +1,8 @@
 #include "fiddle_context.hpp"
 
 #include "rive/renderer/rive_renderer.hpp"
+#include "readback_convert.hpp"
+#include "trace_events.hpp"
 
 #include "rive/renderer/metal/render_context_metal_impl.h"
 #import <Metal/Metal.h>
@@ -9,6 +11,7 @@
 #import <AppKit/AppKit.h>
 
 #include <SDL3/SDL.h>
+#include <chrono>
 
 using namespace rive;
 using namespace rive::gpu;
@@ -138,14 +141,23 @@ public:
 
     void begin(const RenderContext::FrameDescriptor& frameDescriptor) override
     {
+        LP_TRACE_SCOPE("FiddleContext::begin");
+        setAcquireWaitMs(0);
         m_renderContext->beginFrame(frameDescriptor);
     }
 
     void flushPLSContext(RenderTarget* offscreenRenderTarget) final
     {
+        LP_TRACE_SCOPE("FiddleContext::flushPLSContext");
         if (m_currentFrameSurface == nil)
         {
+            LP_TRACE_SCOPE("nextDrawable");
+            auto acquireStart = std::chrono::steady_clock::now();
             m_currentFrameSurface = [m_swapchain nextDrawable];
+            setAcquireWaitMs(std::chrono::duration<double, std::milli>(
+                                 std::chrono::steady_clock::now() -
+                                 acquireStart)
+                                 .count());
             assert(m_currentFrameSurface.texture.width ==
                    m_renderTarget->width());
             assert(m_currentFrameSurface.texture.height ==
@@ -165,6 +177,7 @@ public:
 
     void end(SDL_Window* window, std::vector<uint8_t>* pixelData) final
     {
+        LP_TRACE_SCOPE("FiddleContext::end");
         flushPLSContext(nullptr);
 
         if (pixelData != nil)
@@ -205,23 +218,17 @@ public:
             pixelData->resize(h * w * 4);
             const uint8_t* contents =
                 reinterpret_cast<const uint8_t*>(m_pixelReadBuff.contents);
-            const size_t rowBytes = w * 4;
-            for (size_t y = 0; y < h; ++y)
-            {
-                // Flip Y.
-                const uint8_t* src = &contents[(h - y - 1) * w * 4];
-                uint8_t* dst = &(*pixelData)[y * w * 4];
-                for (size_t x = 0; x < rowBytes; x += 4)
-                {
-                    // BGBRA -> RGBA.
-                    dst[x + 0] = src[x + 2];
-                    dst[x + 1] = src[x + 1];
-                    dst[x + 2] = src[x + 0];
-                    dst[x + 3] = src[x + 3];
-                }
-            }
+            // Flip Y and BGRA -> RGBA in one pass.
+            convert_readback(pixelData->data(),
+                             w * 4,
+                             contents,
+                             w * 4,
+                             w,
+                             h,
+                             kReadbackFlipY | kReadbackSwizzleRB);
         }
 
+        LP_TRACE_SCOPE("present");
         id<MTLCommandBuffer> presentCommandBuffer = [m_queue commandBuffer];
         [presentCommandBuffer presentDrawable:m_currentFrameSurface];
         [presentCommandBuffer commit];
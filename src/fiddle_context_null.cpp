@@ -0,0 +1,281 @@
+#include "fiddle_context.hpp"
+
+#include "rive/decoders/bitmap_decoder.hpp"
+#include "rive/renderer/rive_render_factory.hpp"
+#include "rive/renderer/rive_render_path.hpp"
+#include "utils/no_op_renderer.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+using namespace rive;
+
+// Runs the runtime with no graphics API at all. Paths and paints are the
+// renderer's real CPU-side objects (RiveRenderPath builds its RawPath and
+// bounds exactly as on a GPU backend), images are really decoded, and every
+// draw is counted and then dropped. Frame time is therefore advanceAndApply
+// plus scene traversal and path building, with no rasterization.
+
+namespace
+{
+// Work recorded since the last report.
+struct NullRenderStats
+{
+    uint64_t saves = 0;
+    uint64_t restores = 0;
+    uint64_t transforms = 0;
+    uint64_t drawPaths = 0;
+    uint64_t clipPaths = 0;
+    uint64_t drawImages = 0;
+    uint64_t drawImageMeshes = 0;
+    uint64_t meshVertices = 0;
+    uint64_t meshIndices = 0;
+    uint64_t pathVerbs = 0;
+    uint64_t pathPoints = 0;
+    uint64_t pathsCreated = 0;
+    uint64_t paintsCreated = 0;
+    uint64_t buffersCreated = 0;
+    uint64_t imagesDecoded = 0;
+};
+
+class NullRenderBuffer : public RenderBuffer
+{
+public:
+    NullRenderBuffer(RenderBufferType type,
+                     RenderBufferFlags flags,
+                     size_t sizeInBytes) :
+        RenderBuffer(type, flags, sizeInBytes), m_data(sizeInBytes)
+    {}
+
+protected:
+    void* onMap() override { return m_data.data(); }
+    void onUnmap() override {}
+
+private:
+    std::vector<uint8_t> m_data;
+};
+
+class NullRenderImage : public RenderImage
+{
+public:
+    NullRenderImage(int width, int height)
+    {
+        m_Width = width;
+        m_Height = height;
+    }
+};
+
+class NullFactory : public RiveRenderFactory
+{
+public:
+    NullFactory(NullRenderStats* stats) : m_stats(stats) {}
+
+    rcp<RenderBuffer> makeRenderBuffer(RenderBufferType type,
+                                       RenderBufferFlags flags,
+                                       size_t sizeInBytes) override
+    {
+        ++m_stats->buffersCreated;
+        return make_rcp<NullRenderBuffer>(type, flags, sizeInBytes);
+    }
+
+    rcp<RenderPath> makeRenderPath(RawPath& rawPath, FillRule fillRule) override
+    {
+        ++m_stats->pathsCreated;
+        return RiveRenderFactory::makeRenderPath(rawPath, fillRule);
+    }
+
+    rcp<RenderPath> makeEmptyRenderPath() override
+    {
+        ++m_stats->pathsCreated;
+        return RiveRenderFactory::makeEmptyRenderPath();
+    }
+
+    rcp<RenderPaint> makeRenderPaint() override
+    {
+        ++m_stats->paintsCreated;
+        return RiveRenderFactory::makeRenderPaint();
+    }
+
+    rcp<RenderImage> decodeImage(Span<const uint8_t> encodedBytes) override
+    {
+        // Decode for real so import costs match a GPU backend; only the
+        // dimensions are kept.
+        std::unique_ptr<Bitmap> bitmap =
+            Bitmap::decode(encodedBytes.data(), encodedBytes.size());
+        if (!bitmap)
+        {
+            return nullptr;
+        }
+        ++m_stats->imagesDecoded;
+        return make_rcp<NullRenderImage>(bitmap->width(), bitmap->height());
+    }
+
+private:
+    NullRenderStats* const m_stats;
+};
+
+class NullRenderer : public NoOpRenderer
+{
+public:
+    NullRenderer(NullRenderStats* stats) : m_stats(stats) {}
+
+    void save() override { ++m_stats->saves; }
+    void restore() override { ++m_stats->restores; }
+    void transform(const Mat2D&) override { ++m_stats->transforms; }
+
+    void drawPath(RenderPath* path, RenderPaint*) override
+    {
+        ++m_stats->drawPaths;
+        countPath(path);
+    }
+
+    void clipPath(RenderPath* path) override
+    {
+        ++m_stats->clipPaths;
+        countPath(path);
+    }
+
+    void drawImage(const RenderImage*,
+                   ImageSampler,
+                   BlendMode,
+                   float) override
+    {
+        ++m_stats->drawImages;
+    }
+
+    void drawImageMesh(const RenderImage*,
+                       ImageSampler,
+                       rcp<RenderBuffer>,
+                       rcp<RenderBuffer>,
+                       rcp<RenderBuffer>,
+                       uint32_t vertexCount,
+                       uint32_t indexCount,
+                       BlendMode,
+                       float) override
+    {
+        ++m_stats->drawImageMeshes;
+        m_stats->meshVertices += vertexCount;
+        m_stats->meshIndices += indexCount;
+    }
+
+private:
+    void countPath(RenderPath* path)
+    {
+        // Touch the bounds the way RiveRenderer does before it tessellates.
+        auto* renderPath = static_cast<RiveRenderPath*>(path);
+        renderPath->getBounds();
+        const RawPath& rawPath = renderPath->getRawPath();
+        m_stats->pathVerbs += rawPath.verbs().size();
+        m_stats->pathPoints += rawPath.points().size();
+    }
+
+    NullRenderStats* const m_stats;
+};
+} // namespace
+
+class FiddleContextNull : public FiddleContext
+{
+public:
+    explicit FiddleContextNull(int reportInterval) :
+        m_factory(&m_stats), m_reportInterval(reportInterval)
+    {
+        printf("==== Null backend: counting draws, no rasterization ====\n");
+    }
+
+    float dpiScale(SDL_Window*) const override { return 1; }
+
+    Factory* factory() override { return &m_factory; }
+
+    rive::gpu::RenderContext* renderContextOrNull() override { return nullptr; }
+
+    rive::gpu::RenderTarget* renderTargetOrNull() override { return nullptr; }
+
+    void onSizeChanged(SDL_Window*,
+                       int width,
+                       int height,
+                       uint32_t sampleCount) override
+    {
+        m_width = width;
+        m_height = height;
+    }
+
+    void toggleZoomWindow() override {}
+
+    std::unique_ptr<Renderer> makeRenderer(int width, int height) override
+    {
+        return std::make_unique<NullRenderer>(&m_stats);
+    }
+
+    void begin(const rive::gpu::RenderContext::FrameDescriptor& frame) override
+    {
+        m_clearColor = frame.clearColor;
+    }
+
+    void flushPLSContext(rive::gpu::RenderTarget*) override {}
+
+    void end(SDL_Window*, std::vector<uint8_t>* pixelData) override
+    {
+        if (pixelData != nullptr)
+        {
+            // Nothing was rasterized; hand back the clear color as RGBA.
+            const uint8_t clear[4] = {
+                static_cast<uint8_t>(m_clearColor >> 16),
+                static_cast<uint8_t>(m_clearColor >> 8),
+                static_cast<uint8_t>(m_clearColor),
+                static_cast<uint8_t>(m_clearColor >> 24),
+            };
+            pixelData->resize(static_cast<size_t>(m_width) * m_height * 4);
+            for (size_t i = 0; i < pixelData->size(); i += 4)
+            {
+                memcpy(pixelData->data() + i, clear, 4);
+            }
+        }
+        if (m_reportInterval > 0 &&
+            ++m_framesSinceReport == m_reportInterval)
+        {
+            printReport();
+        }
+    }
+
+private:
+    void printReport()
+    {
+        const double n = m_framesSinceReport;
+        printf("null: per frame %.1f draws (%.1f verbs, %.1f points), "
+               "%.1f images, %.1f image meshes (%.1f vertices, %.1f indices), "
+               "%.1f clips, %.1f saves, %.1f restores, %.1f transforms; "
+               "created %llu paths, %llu paints, %llu buffers, %llu images "
+               "over %i frames\n",
+               m_stats.drawPaths / n,
+               m_stats.pathVerbs / n,
+               m_stats.pathPoints / n,
+               m_stats.drawImages / n,
+               m_stats.drawImageMeshes / n,
+               m_stats.meshVertices / n,
+               m_stats.meshIndices / n,
+               m_stats.clipPaths / n,
+               m_stats.saves / n,
+               m_stats.restores / n,
+               m_stats.transforms / n,
+               static_cast<unsigned long long>(m_stats.pathsCreated),
+               static_cast<unsigned long long>(m_stats.paintsCreated),
+               static_cast<unsigned long long>(m_stats.buffersCreated),
+               static_cast<unsigned long long>(m_stats.imagesDecoded),
+               m_framesSinceReport);
+        m_stats = {};
+        m_framesSinceReport = 0;
+    }
+
+    NullRenderStats m_stats;
+    NullFactory m_factory;
+    const int m_reportInterval;
+    int m_width = 0;
+    int m_height = 0;
+    ColorInt m_clearColor = 0;
+    int m_framesSinceReport = 0;
+};
+
+std::unique_ptr<FiddleContext> FiddleContext::MakeNull(int reportInterval)
+{
+    return std::make_unique<FiddleContextNull>(reportInterval);
+}
@@ -19,11 +19,16 @@ std::unique_ptr<FiddleContext> FiddleContext::MakeVulkanPLS(
 #include "rive/renderer/vulkan/render_context_vulkan_impl.hpp"
 #include "rive/renderer/vulkan/render_target_vulkan.hpp"
 #include "shader_hotload.hpp"
-#include <GLFW/glfw3.h>
-#include <GLFW/glfw3native.h>
+#include "readback_convert.hpp"
+#include "trace_events.hpp"
+#include <SDL3/SDL.h>
+#include <SDL3/SDL_vulkan.h>
 #include <vulkan/vulkan.h>
 #include <vulkan/vulkan_beta.h>
 #include <vk_mem_alloc.h>
+#include <array>
+#include <chrono>
+#include <limits>
 
 using namespace rive;
 using namespace rive::gpu;
@@ -35,16 +40,27 @@ public:
     {
         rive_vkb::load_vulkan();
 
-        uint32_t glfwExtensionCount = 0;
-        const char** glfwExtensions;
-        glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
-
         vkb::InstanceBuilder instanceBuilder;
         instanceBuilder.set_app_name("path_fiddle")
             .set_engine_name("Rive Renderer")
-            .enable_extensions(glfwExtensionCount, glfwExtensions)
             .require_api_version(1, options.coreFeaturesOnly ? 0 : 3, 0)
             .set_minimum_instance_version(1, 0, 0);
+        if (m_options.allowHeadlessRendering)
+        {
+            // No surface extensions, so this also works on render nodes with
+            // no display (SwiftShader, lavapipe).
+            instanceBuilder.set_headless(true);
+        }
+        else
+        {
+            Uint32 sdlExtensionCount = 0;
+            const char* const* sdlExtensions =
+                SDL_Vulkan_GetInstanceExtensions(&sdlExtensionCount);
+            for (Uint32 i = 0; i < sdlExtensionCount; ++i)
+            {
+                instanceBuilder.enable_extension(sdlExtensions[i]);
+            }
+        }
         m_instance = VKB_CHECK(instanceBuilder.build());
 #ifdef DEBUG
         instanceBuilder.enable_validation_layers(
@@ -64,6 +80,8 @@ public:
             m_options.coreFeaturesOnly ? rive_vkb::FeatureSet::coreOnly
                                        : rive_vkb::FeatureSet::allAvailable,
             m_options.gpuNameFilter);
+        m_dispatchTable = m_device.make_table();
+        initGPUTimers();
         m_renderContext = RenderContextVulkanImpl::MakeContext(
             m_instance,
             m_device.physical_device,
@@ -78,9 +96,19 @@ public:
         // command buffers.
         m_swapchain = nullptr;
 
+        for (AsyncReadback& readback : m_asyncReadbacks)
+        {
+            readback.buffer = nullptr;
+        }
+
         m_renderContext.reset();
         m_renderTarget.reset();
 
+        if (m_timestampQueryPool != VK_NULL_HANDLE)
+        {
+            m_dispatchTable.destroyQueryPool(m_timestampQueryPool, nullptr);
+        }
+
         if (m_windowSurface != VK_NULL_HANDLE)
         {
             m_instanceDispatchTable.destroySurfaceKHR(m_windowSurface, nullptr);
@@ -90,7 +118,7 @@ public:
         vkb::destroy_instance(m_instance);
     }
 
-    float dpiScale(GLFWwindow* window) const final
+    float dpiScale(SDL_Window* window) const final
     {
 #ifdef __APPLE__
         return 2;
@@ -116,11 +144,14 @@ public:
         return m_renderTarget.get();
     }
 
-    void onSizeChanged(GLFWwindow* window,
+    void onSizeChanged(SDL_Window* window,
                        int width,
                        int height,
                        uint32_t sampleCount) final
     {
+        // In-flight readbacks were sized for the old target.
+        finishReadbacks();
+
         uint64_t currentFrameNumber = 0;
         if (m_swapchain != nullptr)
         {
@@ -131,12 +162,44 @@ public:
         if (m_windowSurface != VK_NULL_HANDLE)
         {
             m_instanceDispatchTable.destroySurfaceKHR(m_windowSurface, nullptr);
+            m_windowSurface = VK_NULL_HANDLE;
         }
 
-        VK_CHECK(glfwCreateWindowSurface(m_instance,
-                                         window,
-                                         nullptr,
-                                         &m_windowSurface));
+        if (m_options.allowHeadlessRendering)
+        {
+            // Render into a plain image instead of a window surface. There is
+            // nothing to present, so submit() never waits on a compositor.
+            m_swapchain = std::make_unique<rive_vkb::Swapchain>(
+                m_device,
+                ref_rcp(vk()),
+                width,
+                height,
+                VK_FORMAT_R8G8B8A8_UNORM,
+                m_options.coreFeaturesOnly
+                    ? VK_IMAGE_USAGE_TRANSFER_SRC_BIT |
+                          VK_IMAGE_USAGE_TRANSFER_DST_BIT
+                    : VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT |
+                          VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+                currentFrameNumber);
+
+            m_renderTarget = renderContextVulkanImpl()->makeRenderTarget(
+                width,
+                height,
+                m_swapchain->imageFormat(),
+                m_swapchain->imageUsageFlags());
+            return;
+        }
+
+        if (!SDL_Vulkan_CreateSurface(window,
+                                      m_instance,
+                                      nullptr,
+                                      &m_windowSurface))
+        {
+            fprintf(stderr,
+                    "SDL_Vulkan_CreateSurface failed: %s\n",
+                    SDL_GetError());
+            abort();
+        }
 
         VkSurfaceCapabilitiesKHR windowCapabilities;
         VK_CHECK(m_instanceDispatchTable
@@ -218,19 +281,33 @@ public:
 
     void begin(const RenderContext::FrameDescriptor& frameDescriptor) final
     {
+        LP_TRACE_SCOPE("FiddleContext::begin");
+        setAcquireWaitMs(0);
         m_renderContext->beginFrame(std::move(frameDescriptor));
     }
 
     void flushPLSContext(RenderTarget* offscreenRenderTarget) final
     {
+        LP_TRACE_SCOPE("FiddleContext::flushPLSContext");
         const rive_vkb::SwapchainImage* swapchainImage =
             m_swapchain->currentImage();
         if (swapchainImage == nullptr)
         {
+            LP_TRACE_SCOPE("acquireNextImage");
+            auto acquireStart = std::chrono::steady_clock::now();
             swapchainImage = m_swapchain->acquireNextImage();
+            setAcquireWaitMs(std::chrono::duration<double, std::milli>(
+                                 std::chrono::steady_clock::now() -
+                                 acquireStart)
+                                 .count());
             m_renderTarget->setTargetImageView(swapchainImage->imageView,
                                                swapchainImage->image,
                                                swapchainImage->imageLastAccess);
+            // Every frame at or before safeFrameNumber has finished on the
+            // GPU, including any readback copies it recorded.
+            m_safeFrameNumber = swapchainImage->safeFrameNumber;
+            beginGPUTimer(swapchainImage->commandBuffer,
+                          swapchainImage->currentFrameNumber);
         }
 
         m_renderContext->flush({
@@ -243,13 +320,274 @@ public:
         });
     }
 
-    void end(GLFWwindow* window, std::vector<uint8_t>* pixelData) final
+    void end(SDL_Window* window, std::vector<uint8_t>* pixelData) final
     {
+        LP_TRACE_SCOPE("FiddleContext::end");
         flushPLSContext(nullptr);
+        endGPUTimer();
+        LP_TRACE_SCOPE("submit");
         m_swapchain->submit(m_renderTarget->targetLastAccess(), pixelData);
     }
 
+    void endAsyncReadback(SDL_Window* window) final
+    {
+        LP_TRACE_SCOPE("FiddleContext::endAsyncReadback");
+        flushPLSContext(nullptr);
+        endGPUTimer();
+        deliverFinishedReadbacks();
+
+        // Make room by draining the oldest frame if the ring is full. With
+        // more slots than frames in flight this is almost never hit.
+        if (m_asyncReadbacksQueued - m_asyncReadbacksDelivered ==
+            kReadbackRingSize)
+        {
+            m_swapchain->dispatchTable().deviceWaitIdle();
+            deliverOldestReadback();
+        }
+
+        const rive_vkb::SwapchainImage* swapchainImage =
+            m_swapchain->currentImage();
+        VkCommandBuffer commandBuffer = swapchainImage->commandBuffer;
+        uint32_t w = m_renderTarget->width();
+        uint32_t h = m_renderTarget->height();
+
+        AsyncReadback& readback =
+            m_asyncReadbacks[m_asyncReadbacksQueued % kReadbackRingSize];
+        if (readback.buffer == nullptr || readback.width != w ||
+            readback.height != h)
+        {
+            readback.buffer = vk()->makeBuffer(
+                {
+                    .size = w * h * 4,
+                    .usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                },
+                vkutil::Mappability::readWrite);
+            readback.width = w;
+            readback.height = h;
+        }
+        readback.frameNumber = swapchainImage->currentFrameNumber;
+
+        VkImage image = m_renderTarget->accessTargetImage(
+            commandBuffer,
+            {
+                .pipelineStages = VK_PIPELINE_STAGE_TRANSFER_BIT,
+                .accessMask = VK_ACCESS_TRANSFER_READ_BIT,
+                .layout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            });
+        VkBufferImageCopy region = {
+            .imageSubresource =
+                {
+                    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                    .layerCount = 1,
+                },
+            .imageExtent = {w, h, 1},
+        };
+        vk()->CmdCopyImageToBuffer(commandBuffer,
+                                   image,
+                                   VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                                   *readback.buffer,
+                                   1,
+                                   &region);
+        VkBufferMemoryBarrier hostReadBarrier = {
+            .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+            .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_HOST_READ_BIT,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .buffer = *readback.buffer,
+            .size = VK_WHOLE_SIZE,
+        };
+        vk()->CmdPipelineBarrier(commandBuffer,
+                                 VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                 VK_PIPELINE_STAGE_HOST_BIT,
+                                 0,
+                                 0,
+                                 nullptr,
+                                 1,
+                                 &hostReadBarrier,
+                                 0,
+                                 nullptr);
+        ++m_asyncReadbacksQueued;
+
+        LP_TRACE_SCOPE("submit");
+        m_swapchain->submit(m_renderTarget->targetLastAccess(), nullptr);
+    }
+
+    void finishReadbacks() final
+    {
+        if (m_asyncReadbacksDelivered == m_asyncReadbacksQueued)
+        {
+            return;
+        }
+        m_swapchain->dispatchTable().deviceWaitIdle();
+        while (m_asyncReadbacksDelivered < m_asyncReadbacksQueued)
+        {
+            deliverOldestReadback();
+        }
+    }
+
+    void finishGPUTimers() final
+    {
+        if (m_gpuTimersResolved == m_gpuTimersQueued)
+        {
+            return;
+        }
+        m_swapchain->dispatchTable().deviceWaitIdle();
+        // Every submitted frame has finished, whatever its swapchain image.
+        resolveGPUTimers(std::numeric_limits<uint64_t>::max());
+    }
+
 private:
+    // One slot of the readback ring: a host-visible staging buffer and the
+    // frame number whose completion makes it safe to read.
+    struct AsyncReadback
+    {
+        rcp<vkutil::Buffer> buffer;
+        uint64_t frameNumber = 0;
+        uint32_t width = 0;
+        uint32_t height = 0;
+    };
+
+    void deliverFinishedReadbacks()
+    {
+        while (m_asyncReadbacksDelivered < m_asyncReadbacksQueued &&
+               m_asyncReadbacks[m_asyncReadbacksDelivered % kReadbackRingSize]
+                       .frameNumber <= m_safeFrameNumber)
+        {
+            deliverOldestReadback();
+        }
+    }
+
+    // The oldest queued readback's frame must have finished on the GPU.
+    void deliverOldestReadback()
+    {
+        AsyncReadback& readback =
+            m_asyncReadbacks[m_asyncReadbacksDelivered % kReadbackRingSize];
+        uint32_t w = readback.width;
+        uint32_t h = readback.height;
+        readback.buffer->invalidateContents();
+        const uint8_t* contents =
+            static_cast<const uint8_t*>(readback.buffer->contents());
+        bool isBGRA = m_swapchain->imageFormat() == VK_FORMAT_B8G8R8A8_UNORM;
+
+        // Hand the staging buffer over as is: it is top-down (and maybe
+        // BGRA), and the consumer fixes that in its own pass.
+        ++m_asyncReadbacksDelivered;
+        deliverReadback(w,
+                        h,
+                        contents,
+                        kReadbackFlipY | (isBGRA ? kReadbackSwizzleRB : 0));
+    }
+
+    // One slot of the GPU timer ring: a timestamp pair around the frame's
+    // flushes, readable once its swapchain frame number is safe.
+    struct GPUTimer
+    {
+        uint64_t swapchainFrameNumber = 0;
+        uint64_t frameNumber = 0;
+    };
+
+    void initGPUTimers()
+    {
+        uint32_t queueFamily =
+            VKB_CHECK(m_device.get_queue_index(vkb::QueueType::graphics));
+        m_timestampPeriodNs =
+            m_device.physical_device.properties.limits.timestampPeriod;
+        const uint32_t validBits =
+            m_device.queue_families[queueFamily].timestampValidBits;
+        if (validBits == 0 || m_timestampPeriodNs == 0)
+        {
+            printf("Vulkan: no timestamp queries; GPU times unavailable\n");
+            return;
+        }
+        // Counters narrower than 64 bits wrap; deltas are taken modulo this.
+        m_timestampMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+        VkQueryPoolCreateInfo queryPoolCreateInfo = {
+            .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+            .queryType = VK_QUERY_TYPE_TIMESTAMP,
+            .queryCount = kGPUTimerRingSize * 2,
+        };
+        VK_CHECK(m_dispatchTable.createQueryPool(&queryPoolCreateInfo,
+                                                 nullptr,
+                                                 &m_timestampQueryPool));
+    }
+
+    // Called on the first flush of a frame, right after acquire.
+    void beginGPUTimer(VkCommandBuffer commandBuffer,
+                       uint64_t swapchainFrameNumber)
+    {
+        if (m_timestampQueryPool == VK_NULL_HANDLE ||
+            m_gpuTimersQueued - m_gpuTimersResolved == kGPUTimerRingSize)
+        {
+            return;
+        }
+        const uint32_t slot = m_gpuTimersQueued % kGPUTimerRingSize;
+        m_dispatchTable.cmdResetQueryPool(commandBuffer,
+                                          m_timestampQueryPool,
+                                          slot * 2,
+                                          2);
+        m_dispatchTable.cmdWriteTimestamp(commandBuffer,
+                                          VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                                          m_timestampQueryPool,
+                                          slot * 2);
+        m_gpuTimers[slot].swapchainFrameNumber = swapchainFrameNumber;
+        m_gpuTimerCommandBuffer = commandBuffer;
+    }
+
+    // Called after the last flush of a frame, before submit.
+    void endGPUTimer()
+    {
+        if (m_gpuTimerCommandBuffer != VK_NULL_HANDLE)
+        {
+            const uint32_t slot = m_gpuTimersQueued % kGPUTimerRingSize;
+            m_dispatchTable.cmdWriteTimestamp(
+                m_gpuTimerCommandBuffer,
+                VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                m_timestampQueryPool,
+                slot * 2 + 1);
+            m_gpuTimers[slot].frameNumber = m_frameNumber;
+            ++m_gpuTimersQueued;
+            m_gpuTimerCommandBuffer = VK_NULL_HANDLE;
+        }
+        resolveGPUTimers(m_safeFrameNumber);
+        ++m_frameNumber;
+    }
+
+    // Hands off every timer whose frame is at or before safeFrameNumber.
+    void resolveGPUTimers(uint64_t safeFrameNumber)
+    {
+        while (m_gpuTimersResolved < m_gpuTimersQueued)
+        {
+            const uint32_t slot = m_gpuTimersResolved % kGPUTimerRingSize;
+            const GPUTimer& timer = m_gpuTimers[slot];
+            if (timer.swapchainFrameNumber > safeFrameNumber)
+            {
+                break;
+            }
+            uint64_t timestamps[2];
+            VkResult result =
+                m_dispatchTable.getQueryPoolResults(m_timestampQueryPool,
+                                                    slot * 2,
+                                                    2,
+                                                    sizeof(timestamps),
+                                                    timestamps,
+                                                    sizeof(uint64_t),
+                                                    VK_QUERY_RESULT_64_BIT);
+            if (result == VK_NOT_READY)
+            {
+                break;
+            }
+            ++m_gpuTimersResolved;
+            if (result == VK_SUCCESS)
+            {
+                deliverGPUFrameTime(
+                    timer.frameNumber,
+                    ((timestamps[1] - timestamps[0]) & m_timestampMask) *
+                        m_timestampPeriodNs * 1e-6);
+            }
+        }
+    }
+
     VulkanContext* vk() const
     {
         return renderContextVulkanImpl()->vulkanContext();
@@ -259,12 +597,28 @@ private:
     vkb::Instance m_instance;
     vkb::InstanceDispatchTable m_instanceDispatchTable;
     vkb::Device m_device;
+    vkb::DispatchTable m_dispatchTable;
 
     VkSurfaceKHR m_windowSurface = VK_NULL_HANDLE;
     std::unique_ptr<rive_vkb::Swapchain> m_swapchain;
 
     std::unique_ptr<RenderContext> m_renderContext;
     rcp<RenderTargetVulkanImpl> m_renderTarget;
+
+    uint64_t m_safeFrameNumber = 0;
+    std::array<AsyncReadback, kReadbackRingSize> m_asyncReadbacks;
+    uint64_t m_asyncReadbacksQueued = 0;
+    uint64_t m_asyncReadbacksDelivered = 0;
+
+    VkQueryPool m_timestampQueryPool = VK_NULL_HANDLE;
+    double m_timestampPeriodNs = 0;
+    uint64_t m_timestampMask = ~0ull;
+    std::array<GPUTimer, kGPUTimerRingSize> m_gpuTimers;
+    uint64_t m_gpuTimersQueued = 0;
+    uint64_t m_gpuTimersResolved = 0;
+    // Set while the current frame's timer is open.
+    VkCommandBuffer m_gpuTimerCommandBuffer = VK_NULL_HANDLE;
+    uint64_t m_frameNumber = 0;
 };
 
 std::unique_ptr<FiddleContext> FiddleContext::MakeVulkanPLS(
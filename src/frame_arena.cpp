@@ -0,0 +1,55 @@
+#include "frame_arena.hpp"
+
+#include <algorithm>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+
+FrameArena::FrameArena(size_t capacity) :
+    m_capacity(capacity), m_buffer(new char[capacity])
+{}
+
+void* FrameArena::allocate(size_t size, size_t alignment)
+{
+    const uintptr_t base = reinterpret_cast<uintptr_t>(m_buffer.get());
+    const uintptr_t aligned =
+        (base + m_used + alignment - 1) & ~(uintptr_t(alignment) - 1);
+    const size_t offset = aligned - base;
+    if (offset > m_capacity || size > m_capacity - offset)
+    {
+        m_overflowed = true;
+        return nullptr;
+    }
+    m_used = offset + size;
+    m_highWater = std::max(m_highWater, m_used);
+    return m_buffer.get() + offset;
+}
+
+const char* FrameArena::format(const char* fmt, ...)
+{
+    // Format straight into whatever is left, then claim what was written.
+    char* out = m_buffer.get() + m_used;
+    const size_t available = m_capacity - m_used;
+    if (available == 0)
+    {
+        m_overflowed = true;
+        return "";
+    }
+    va_list args;
+    va_start(args, fmt);
+    int length = vsnprintf(out, available, fmt, args);
+    va_end(args);
+    if (length < 0)
+    {
+        out[0] = '\0';
+        length = 0;
+    }
+    if (static_cast<size_t>(length) >= available)
+    {
+        m_overflowed = true;
+    }
+    allocate(std::min(static_cast<size_t>(length) + 1, available), 1);
+    return out;
+}
+
+void FrameArena::reset() { m_used = 0; }
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+
+// Bump allocator for per-frame temporaries (formatted titles, log lines).
+// The buffer is allocated once up front; reset() at the start of each frame
+// recycles it, so steady-state frames never reach the heap. Nothing is
+// destroyed on reset, so only trivially destructible data belongs here.
+class FrameArena
+{
+public:
+    explicit FrameArena(size_t capacity);
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    // Returns null once the frame's budget is used up.
+    void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+    // printf into the arena. Returns a truncated (possibly empty) string if
+    // the arena is full, never null.
+    const char* format(const char* fmt, ...)
+#ifdef __GNUC__
+        __attribute__((format(printf, 2, 3)))
+#endif
+        ;
+
+    // Invalidates everything handed out since the last reset.
+    void reset();
+
+    size_t capacity() const { return m_capacity; }
+    // Most bytes used by any one frame, and whether any request failed.
+    size_t highWater() const { return m_highWater; }
+    bool overflowed() const { return m_overflowed; }
+
+private:
+    const size_t m_capacity;
+    const std::unique_ptr<char[]> m_buffer;
+    size_t m_used = 0;
+    size_t m_highWater = 0;
+    bool m_overflowed = false;
+};
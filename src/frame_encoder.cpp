@@ -0,0 +1,198 @@
+#include "frame_encoder.hpp"
+
+#include "image_io.hpp"
+#include "readback_convert.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+FrameEncoder::FrameEncoder(const FrameEncoderOptions& options) :
+    m_options(options)
+{
+    int workerCount = m_options.workerCount;
+    if (workerCount <= 0)
+    {
+        workerCount =
+            std::max(1, static_cast<int>(std::thread::hardware_concurrency()) - 1);
+    }
+    int queueDepth = std::max(m_options.queueDepth, 1);
+
+    m_slots.resize(queueDepth);
+    m_queuedSlots.resize(queueDepth);
+    m_freeSlots.reserve(queueDepth);
+    for (int i = queueDepth - 1; i >= 0; --i)
+    {
+        m_freeSlots.push_back(i);
+    }
+    m_stats.resize(workerCount);
+    for (int i = 0; i < workerCount; ++i)
+    {
+        m_workers.emplace_back(&FrameEncoder::workerMain, this, i);
+    }
+}
+
+FrameEncoder::~FrameEncoder() { finish(); }
+
+const char* FrameEncoder::fileExtension() const
+{
+    return m_options.encoding == FrameEncoding::png ? "png" : "webp";
+}
+
+void FrameEncoder::push(const char* path,
+                        uint32_t width,
+                        uint32_t height,
+                        const uint8_t* pixels,
+                        uint32_t conversions)
+{
+    int slotIndex;
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_slotFreed.wait(lock, [this] { return !m_freeSlots.empty(); });
+        slotIndex = m_freeSlots.back();
+        m_freeSlots.pop_back();
+    }
+
+    // The slot is ours until it is queued, so fill it without the lock. Slot
+    // buffers keep their capacity, so this stops allocating once every slot
+    // has seen a frame of this size.
+    Slot& slot = m_slots[slotIndex];
+    slot.path = path;
+    slot.width = width;
+    slot.height = height;
+    slot.pixels.resize(static_cast<size_t>(width) * height * 4);
+    convert_readback(slot.pixels.data(),
+                     width * 4,
+                     pixels,
+                     width * 4,
+                     width,
+                     height,
+                     conversions);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queuedSlots[(m_queueHead + m_queuedCount) % m_queuedSlots.size()] =
+            slotIndex;
+        ++m_queuedCount;
+    }
+    m_frameQueued.notify_one();
+}
+
+void FrameEncoder::finish()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_finishing)
+        {
+            return;
+        }
+        m_finishing = true;
+    }
+    m_frameQueued.notify_all();
+    for (std::thread& worker : m_workers)
+    {
+        worker.join();
+    }
+}
+
+uint64_t FrameEncoder::failureCount() const
+{
+    uint64_t failures = 0;
+    for (const WorkerStats& stats : m_stats)
+    {
+        failures += stats.failures;
+    }
+    return failures;
+}
+
+void FrameEncoder::printStats() const
+{
+    uint64_t totalFrames = 0;
+    for (size_t i = 0; i < m_stats.size(); ++i)
+    {
+        const WorkerStats& stats = m_stats[i];
+        totalFrames += stats.frames;
+        double seconds = std::max(stats.encodeSeconds, 1e-9);
+        printf("encoder worker %zu: %llu frames (%llu failed) in %.2fs, "
+               "%.1f frames/s, %.1f Mpx/s\n",
+               i,
+               static_cast<unsigned long long>(stats.frames),
+               static_cast<unsigned long long>(stats.failures),
+               stats.encodeSeconds,
+               stats.frames / seconds,
+               stats.pixels / seconds * 1e-6);
+    }
+    printf("encoder: %llu frames on %zu workers\n",
+           static_cast<unsigned long long>(totalFrames),
+           m_stats.size());
+}
+
+void FrameEncoder::workerMain(int workerIndex)
+{
+    WorkerStats& stats = m_stats[workerIndex];
+    for (;;)
+    {
+        int slotIndex;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_frameQueued.wait(lock, [this] {
+                return m_queuedCount > 0 || m_finishing;
+            });
+            if (m_queuedCount == 0)
+            {
+                return; // Finishing, and the queue is drained.
+            }
+            slotIndex = m_queuedSlots[m_queueHead];
+            m_queueHead = (m_queueHead + 1) % m_queuedSlots.size();
+            --m_queuedCount;
+        }
+
+        const Slot& slot = m_slots[slotIndex];
+        auto start = std::chrono::steady_clock::now();
+        bool ok = encode(slot);
+        stats.encodeSeconds += std::chrono::duration<double>(
+                                   std::chrono::steady_clock::now() - start)
+                                   .count();
+        ++stats.frames;
+        stats.pixels += static_cast<uint64_t>(slot.width) * slot.height;
+        if (!ok)
+        {
+            ++stats.failures;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_freeSlots.push_back(slotIndex);
+        }
+        m_slotFreed.notify_one();
+    }
+}
+
+bool FrameEncoder::encode(const Slot& slot) const
+{
+    ptrdiff_t rowStride = static_cast<ptrdiff_t>(slot.width) * 4;
+    switch (m_options.encoding)
+    {
+        case FrameEncoding::png:
+            return write_png(slot.path.c_str(),
+                             slot.width,
+                             slot.height,
+                             slot.pixels.data(),
+                             rowStride);
+        case FrameEncoding::webpLossless:
+            return write_webp(slot.path.c_str(),
+                              slot.width,
+                              slot.height,
+                              slot.pixels.data(),
+                              rowStride,
+                              -1);
+        case FrameEncoding::webpLossy:
+            return write_webp(slot.path.c_str(),
+                              slot.width,
+                              slot.height,
+                              slot.pixels.data(),
+                              rowStride,
+                              m_options.webpQuality);
+    }
+    return false;
+}
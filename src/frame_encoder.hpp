@@ -0,0 +1,97 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum class FrameEncoding
+{
+    png,
+    webpLossless,
+    webpLossy,
+};
+
+struct FrameEncoderOptions
+{
+    FrameEncoding encoding = FrameEncoding::png;
+    // 0 picks one less than the hardware thread count, leaving a core for
+    // the render thread.
+    int workerCount = 0;
+    // Frames that may be buffered at once, queued or mid-encode. push()
+    // blocks once they are all in use, which caps memory at queueDepth
+    // frames regardless of how far the render thread gets ahead.
+    int queueDepth = 8;
+    // Quality for lossy WebP, in [0, 100].
+    float webpQuality = 90;
+};
+
+// Encodes captured frames to image files on a pool of worker threads so the
+// render thread never waits on libpng/libwebp.
+class FrameEncoder
+{
+public:
+    explicit FrameEncoder(const FrameEncoderOptions&);
+    ~FrameEncoder();
+
+    FrameEncoder(const FrameEncoder&) = delete;
+    FrameEncoder& operator=(const FrameEncoder&) = delete;
+
+    // File extension for the selected encoding, without the dot.
+    const char* fileExtension() const;
+
+    // Copies a width x height RGBA frame into a pooled buffer, applying the
+    // given ReadbackConversion flags on the way, and queues it to be written
+    // to path. Blocks while every buffer is in use.
+    void push(const char* path,
+              uint32_t width,
+              uint32_t height,
+              const uint8_t* pixels,
+              uint32_t conversions);
+
+    // Waits for every queued frame to be written and stops the workers.
+    void finish();
+
+    // Frames that failed to encode or write. Final once finish() returns.
+    uint64_t failureCount() const;
+
+    // Prints frames, megapixels and wall time per worker.
+    void printStats() const;
+
+private:
+    struct Slot
+    {
+        std::string path;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        std::vector<uint8_t> pixels;
+    };
+
+    struct WorkerStats
+    {
+        uint64_t frames = 0;
+        uint64_t pixels = 0;
+        uint64_t failures = 0;
+        double encodeSeconds = 0;
+    };
+
+    void workerMain(int workerIndex);
+    bool encode(const Slot&) const;
+
+    const FrameEncoderOptions m_options;
+    std::vector<Slot> m_slots;
+    std::vector<WorkerStats> m_stats;
+    std::vector<std::thread> m_workers;
+
+    std::mutex m_mutex;
+    std::condition_variable m_slotFreed;
+    std::condition_variable m_frameQueued;
+    std::vector<int> m_freeSlots;
+    // FIFO ring with room for every slot, so queueing never allocates.
+    std::vector<int> m_queuedSlots;
+    size_t m_queueHead = 0;
+    size_t m_queuedCount = 0;
+    bool m_finishing = false;
+};
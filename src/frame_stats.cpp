@@ -0,0 +1,301 @@
+#include "frame_stats.hpp"
+
+#include "json_writer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+const char* frame_phase_name(FramePhase phase)
+{
+    switch (phase)
+    {
+        case kAdvancePhase:
+            return "advance";
+        case kDrawPhase:
+            return "draw";
+        case kFlushPhase:
+            return "flush";
+        case kPresentPhase:
+            return "present";
+        case kFramePhaseCount:
+            break;
+    }
+    return "total";
+}
+
+// Nearest-rank percentile of an ascending array.
+static double percentile(const std::vector<double>& sorted, double p)
+{
+    size_t rank = static_cast<size_t>(std::ceil(p / 100 * sorted.size()));
+    return sorted[std::min(std::max<size_t>(rank, 1), sorted.size()) - 1];
+}
+
+static PhaseSummary summarize_samples(std::vector<double> samples)
+{
+    PhaseSummary summary;
+    if (samples.empty())
+    {
+        return summary;
+    }
+    double sum = 0;
+    for (double ms : samples)
+    {
+        sum += ms;
+    }
+    std::sort(samples.begin(), samples.end());
+    summary.min = samples.front();
+    summary.mean = sum / samples.size();
+    summary.p50 = percentile(samples, 50);
+    summary.p95 = percentile(samples, 95);
+    summary.p99 = percentile(samples, 99);
+    summary.max = samples.back();
+    return summary;
+}
+
+PhaseSummary FrameStats::summarize(int phase) const
+{
+    std::vector<double> samples;
+    samples.reserve(m_frames.size());
+    for (const FrameTimings& frame : m_frames)
+    {
+        samples.push_back(phase == kFramePhaseCount ? frame.total()
+                                                    : frame.ms[phase]);
+    }
+    return summarize_samples(std::move(samples));
+}
+
+PhaseSummary FrameStats::summarizeGPU() const
+{
+    return summarize_samples(m_gpuMs);
+}
+
+static void print_summary(const char* name, const PhaseSummary& s)
+{
+    printf("  %-8s %8.3f %8.3f %8.3f %8.3f %8.3f %8.3f\n",
+           name,
+           s.min,
+           s.mean,
+           s.p50,
+           s.p95,
+           s.p99,
+           s.max);
+}
+
+// Opens an object holding the summary; the caller adds to it and closes it.
+static void write_summary(JSONWriter* json,
+                          const char* name,
+                          const PhaseSummary& s)
+{
+    json->beginObject(name);
+    json->number("min_ms", s.min);
+    json->number("mean_ms", s.mean);
+    json->number("p50_ms", s.p50);
+    json->number("p95_ms", s.p95);
+    json->number("p99_ms", s.p99);
+    json->number("max_ms", s.max);
+}
+
+// Counters are reported for advance, draw, flush and their sum.
+constexpr static int kPerfPhaseCount = kPresentPhase;
+
+static PerfCounts perf_phase_counts(const PerfCounts* perf, int phase)
+{
+    if (phase < kPerfPhaseCount)
+    {
+        return perf[phase];
+    }
+    PerfCounts total;
+    for (int i = 0; i < kPerfPhaseCount; ++i)
+    {
+        total += perf[i];
+    }
+    return total;
+}
+
+static void print_perf_counts(const char* name,
+                              const PerfCounts& counts,
+                              const bool* available,
+                              double frames)
+{
+    printf("  %-8s", name);
+    for (int i = 0; i < kPerfCounterCount; ++i)
+    {
+        if (available[i])
+        {
+            printf(" %16.1f", counts.value[i] / frames);
+        }
+        else
+        {
+            printf(" %16s", "-");
+        }
+    }
+    if (available[kPerfInstructions] && available[kPerfCycles] &&
+        counts.value[kPerfCycles] > 0)
+    {
+        printf(" %6.2f",
+               static_cast<double>(counts.value[kPerfInstructions]) /
+                   counts.value[kPerfCycles]);
+    }
+    printf("\n");
+}
+
+void FrameStats::print() const
+{
+    printf("%zu frames, ms:    min     mean      p50      p95      p99      "
+           "max\n",
+           m_frames.size());
+    for (int phase = 0; phase <= kFramePhaseCount; ++phase)
+    {
+        print_summary(frame_phase_name(static_cast<FramePhase>(phase)),
+                      summarize(phase));
+    }
+    if (!m_gpuMs.empty())
+    {
+        print_summary("gpu", summarizeGPU());
+        printf("  (gpu: %zu frames resolved)\n", m_gpuMs.size());
+    }
+    if (m_allocFrames > 0)
+    {
+        print_alloc_counts(m_allocs, m_allocFrames);
+        printf("  max %llu allocs in one frame, %llu of %llu frames "
+               "allocation-free\n",
+               static_cast<unsigned long long>(m_maxFrameAllocs),
+               static_cast<unsigned long long>(m_allocFreeFrames),
+               static_cast<unsigned long long>(m_allocFrames));
+    }
+    if (m_perfFrames > 0)
+    {
+        printf("perf counters per frame:\n          ");
+        for (int i = 0; i < kPerfCounterCount; ++i)
+        {
+            printf(" %16s", perf_counter_name(i));
+        }
+        printf(" %6s\n", "ipc");
+        for (int phase = 0; phase <= kPerfPhaseCount; ++phase)
+        {
+            print_perf_counts(
+                phase < kPerfPhaseCount
+                    ? frame_phase_name(static_cast<FramePhase>(phase))
+                    : "total",
+                perf_phase_counts(m_perf, phase),
+                m_perfCounterAvailable,
+                static_cast<double>(m_perfFrames));
+        }
+    }
+}
+
+void FrameStats::addAllocations(const AllocCounts& frame)
+{
+    for (int i = 0; i < kAllocTagCount; ++i)
+    {
+        m_allocs.allocs[i] += frame.allocs[i];
+        m_allocs.bytes[i] += frame.bytes[i];
+    }
+    const uint64_t allocs = frame.totalAllocs();
+    m_maxFrameAllocs = std::max(m_maxFrameAllocs, allocs);
+    m_allocFreeFrames += allocs == 0;
+    ++m_allocFrames;
+}
+
+void FrameStats::setPerfCounters(const PerfCounterGroup& group)
+{
+    for (int i = 0; i < kPerfCounterCount; ++i)
+    {
+        m_perfCounterAvailable[i] = group.has(i);
+    }
+}
+
+void FrameStats::addPerfCounts(const PerfCounts (&phases)[kFramePhaseCount])
+{
+    for (int phase = 0; phase < kFramePhaseCount; ++phase)
+    {
+        m_perf[phase] += phases[phase];
+    }
+    ++m_perfFrames;
+}
+
+void FrameStats::writeJSON(JSONWriter* json) const
+{
+    json->beginObject("phases");
+    for (int phase = 0; phase <= kFramePhaseCount; ++phase)
+    {
+        write_summary(json,
+                      frame_phase_name(static_cast<FramePhase>(phase)),
+                      summarize(phase));
+        json->endObject();
+    }
+    json->endObject();
+    if (!m_gpuMs.empty())
+    {
+        write_summary(json, "gpu", summarizeGPU());
+        json->integer("frames", static_cast<int64_t>(m_gpuMs.size()));
+        json->endObject();
+    }
+    if (m_allocFrames > 0)
+    {
+        const double frames = static_cast<double>(m_allocFrames);
+        json->beginObject("allocations");
+        json->integer("frames", static_cast<int64_t>(m_allocFrames));
+        json->number("allocs_per_frame", m_allocs.totalAllocs() / frames);
+        json->number("bytes_per_frame", m_allocs.totalBytes() / frames);
+        json->integer("max_allocs_per_frame",
+                      static_cast<int64_t>(m_maxFrameAllocs));
+        json->integer("allocation_free_frames",
+                      static_cast<int64_t>(m_allocFreeFrames));
+        json->beginObject("tags");
+        for (int i = 0; i < kAllocTagCount; ++i)
+        {
+            json->beginObject(alloc_tag_name(static_cast<AllocTag>(i)));
+            json->number("allocs_per_frame", m_allocs.allocs[i] / frames);
+            json->number("bytes_per_frame", m_allocs.bytes[i] / frames);
+            json->endObject();
+        }
+        json->endObject();
+        json->endObject();
+    }
+    if (m_perfFrames > 0)
+    {
+        const double frames = static_cast<double>(m_perfFrames);
+        json->beginObject("perf_counters");
+        json->integer("frames", static_cast<int64_t>(m_perfFrames));
+        for (int phase = 0; phase <= kPerfPhaseCount; ++phase)
+        {
+            const PerfCounts counts = perf_phase_counts(m_perf, phase);
+            json->beginObject(
+                phase < kPerfPhaseCount
+                    ? frame_phase_name(static_cast<FramePhase>(phase))
+                    : "total");
+            char key[64];
+            for (int i = 0; i < kPerfCounterCount; ++i)
+            {
+                if (m_perfCounterAvailable[i])
+                {
+                    snprintf(key,
+                             sizeof(key),
+                             "%s_per_frame",
+                             perf_counter_name(i));
+                    json->number(key, counts.value[i] / frames);
+                }
+            }
+            const double instructions =
+                static_cast<double>(counts.value[kPerfInstructions]);
+            if (m_perfCounterAvailable[kPerfInstructions] &&
+                m_perfCounterAvailable[kPerfCycles] &&
+                counts.value[kPerfCycles] > 0)
+            {
+                json->number("ipc", instructions / counts.value[kPerfCycles]);
+            }
+            if (m_perfCounterAvailable[kPerfInstructions] &&
+                m_perfCounterAvailable[kPerfCacheMisses] && instructions > 0)
+            {
+                // Misses per thousand instructions.
+                json->number("cache_mpki",
+                             counts.value[kPerfCacheMisses] * 1e3 /
+                                 instructions);
+            }
+            json->endObject();
+        }
+        json->endObject();
+    }
+}
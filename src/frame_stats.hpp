@@ -0,0 +1,87 @@
+#pragma once
+
+#include "alloc_tracker.hpp"
+#include "perf_counters.hpp"
+
+#include <cstddef>
+#include <vector>
+
+class JSONWriter;
+
+// Where a frame's CPU time goes, in loop order. Present is only a separate
+// call on GL; the other backends present inside end(), so it lands in flush.
+enum FramePhase
+{
+    kAdvancePhase,
+    kDrawPhase,
+    kFlushPhase,
+    kPresentPhase,
+    kFramePhaseCount,
+};
+
+const char* frame_phase_name(FramePhase);
+
+struct FrameTimings
+{
+    double ms[kFramePhaseCount] = {};
+
+    double total() const
+    {
+        double sum = 0;
+        for (double phase : ms)
+        {
+            sum += phase;
+        }
+        return sum;
+    }
+};
+
+// Distribution of one phase (or the total) over the collected frames.
+struct PhaseSummary
+{
+    double min = 0;
+    double mean = 0;
+    double p50 = 0;
+    double p95 = 0;
+    double p99 = 0;
+    double max = 0;
+};
+
+class FrameStats
+{
+public:
+    void reserve(size_t frameCount) { m_frames.reserve(frameCount); }
+    void add(const FrameTimings& frame) { m_frames.push_back(frame); }
+    size_t frameCount() const { return m_frames.size(); }
+    // GPU times arrive a few frames late and not for every frame, so they
+    // are kept as a separate distribution.
+    void addGPUTime(double ms) { m_gpuMs.push_back(ms); }
+    size_t gpuFrameCount() const { return m_gpuMs.size(); }
+    // One measured frame's allocations (with alloc tracking enabled).
+    void addAllocations(const AllocCounts& frame);
+    // Which counters addPerfCounts() will carry; the rest are not reported.
+    void setPerfCounters(const PerfCounterGroup&);
+    // One measured frame's counters, by phase (present is not counted).
+    void addPerfCounts(const PerfCounts (&phases)[kFramePhaseCount]);
+
+    // phase == kFramePhaseCount summarizes whole-frame totals.
+    PhaseSummary summarize(int phase) const;
+    PhaseSummary summarizeGPU() const;
+
+    void print() const;
+    // Writes a "phases" object with one summary per phase plus "total", a
+    // "gpu" object when GPU times were collected, and "allocations" and
+    // "perf_counters" objects when those were.
+    void writeJSON(JSONWriter*) const;
+
+private:
+    std::vector<FrameTimings> m_frames;
+    std::vector<double> m_gpuMs;
+    AllocCounts m_allocs;
+    uint64_t m_allocFrames = 0;
+    uint64_t m_maxFrameAllocs = 0;
+    uint64_t m_allocFreeFrames = 0;
+    bool m_perfCounterAvailable[kPerfCounterCount] = {};
+    PerfCounts m_perf[kFramePhaseCount];
+    uint64_t m_perfFrames = 0;
+};
@@ -0,0 +1,204 @@
+#include "frame_telemetry.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+
+int LatencyHistogram::BucketIndex(uint64_t ns)
+{
+    // The first two sub-bucket ranges are exact; each later power of two is
+    // split into kSubBucketCount equal buckets.
+    const int bits = std::bit_width(ns);
+    if (bits <= kSubBucketBits + 1)
+    {
+        return static_cast<int>(ns);
+    }
+    const int shift = bits - (kSubBucketBits + 1);
+    return (shift + 1) * kSubBucketCount + static_cast<int>(ns >> shift) -
+           kSubBucketCount;
+}
+
+uint64_t LatencyHistogram::BucketUpperBound(int index)
+{
+    if (index < 2 * kSubBucketCount)
+    {
+        return index;
+    }
+    const int shift = index / kSubBucketCount - 1;
+    const uint64_t subBucket = index % kSubBucketCount + kSubBucketCount;
+    return ((subBucket + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(double ms)
+{
+    constexpr uint64_t kMaxNs = (uint64_t(1) << kMaxValueBits) - 1;
+    const double ns = std::max(ms, 0.0) * 1e6;
+    const uint64_t value =
+        ns >= static_cast<double>(kMaxNs) ? kMaxNs : std::llround(ns);
+    ++m_counts[BucketIndex(value)];
+    ++m_count;
+    m_sumMs += ms;
+    m_maxMs = std::max(m_maxMs, ms);
+}
+
+void LatencyHistogram::reset() { *this = LatencyHistogram(); }
+
+double LatencyHistogram::percentile(double p) const
+{
+    if (m_count == 0)
+    {
+        return 0;
+    }
+    const uint64_t rank = std::max<uint64_t>(
+        static_cast<uint64_t>(std::ceil(p / 100 * m_count)),
+        1);
+    uint64_t seen = 0;
+    for (int i = 0; i < kBucketCount; ++i)
+    {
+        seen += m_counts[i];
+        if (seen >= rank)
+        {
+            return std::min(BucketUpperBound(i) * 1e-6, m_maxMs);
+        }
+    }
+    return m_maxMs;
+}
+
+const char* FrameTelemetry::MetricName(int metric)
+{
+    switch (metric)
+    {
+        case kFrameMetric:
+            return "frame";
+        case kAdvanceMetric:
+            return "advance";
+        case kFlushMetric:
+            return "flush";
+    }
+    return "unknown";
+}
+
+FrameTelemetry::~FrameTelemetry()
+{
+    if (m_log != nullptr)
+    {
+        fclose(m_log);
+    }
+}
+
+bool FrameTelemetry::openLog(const char* path)
+{
+    m_log = fopen(path, "a");
+    if (m_log == nullptr)
+    {
+        fprintf(stderr, "Failed to open %s for writing\n", path);
+        return false;
+    }
+    const char* extension = strrchr(path, '.');
+    m_logIsJSON = extension != nullptr && (!strcmp(extension, ".json") ||
+                                           !strcmp(extension, ".jsonl"));
+    fseek(m_log, 0, SEEK_END);
+    if (!m_logIsJSON && ftell(m_log) == 0)
+    {
+        fprintf(m_log, "elapsed_s,frames");
+        for (int metric = 0; metric < kMetricCount; ++metric)
+        {
+            const char* name = MetricName(metric);
+            fprintf(m_log,
+                    ",%s_p50_ms,%s_p99_ms,%s_max_ms",
+                    name,
+                    name,
+                    name);
+        }
+        fprintf(m_log, "\n");
+    }
+    return true;
+}
+
+void FrameTelemetry::record(double frameMs, double advanceMs, double flushMs)
+{
+    const double ms[kMetricCount] = {frameMs, advanceMs, flushMs};
+    for (int metric = 0; metric < kMetricCount; ++metric)
+    {
+        m_window[metric].record(ms[metric]);
+        m_total[metric].record(ms[metric]);
+    }
+}
+
+void FrameTelemetry::snapshot(double elapsedSeconds)
+{
+    const unsigned long long frames = m_window[kFrameMetric].count();
+    printf("telemetry %.1fs: %llu frames", elapsedSeconds, frames);
+    for (int metric = 0; metric < kMetricCount; ++metric)
+    {
+        const LatencyHistogram& h = m_window[metric];
+        printf(" | %s p50 %.2f p99 %.2f max %.2f",
+               MetricName(metric),
+               h.percentile(50),
+               h.percentile(99),
+               h.max());
+    }
+    printf(" ms\n");
+
+    if (m_log != nullptr)
+    {
+        if (m_logIsJSON)
+        {
+            fprintf(m_log,
+                    "{\"elapsed_s\":%.3f,\"frames\":%llu",
+                    elapsedSeconds,
+                    frames);
+            for (int metric = 0; metric < kMetricCount; ++metric)
+            {
+                const LatencyHistogram& h = m_window[metric];
+                fprintf(m_log,
+                        ",\"%s\":{\"p50_ms\":%.4f,\"p99_ms\":%.4f,"
+                        "\"max_ms\":%.4f}",
+                        MetricName(metric),
+                        h.percentile(50),
+                        h.percentile(99),
+                        h.max());
+            }
+            fprintf(m_log, "}\n");
+        }
+        else
+        {
+            fprintf(m_log, "%.3f,%llu", elapsedSeconds, frames);
+            for (int metric = 0; metric < kMetricCount; ++metric)
+            {
+                const LatencyHistogram& h = m_window[metric];
+                fprintf(m_log,
+                        ",%.4f,%.4f,%.4f",
+                        h.percentile(50),
+                        h.percentile(99),
+                        h.max());
+            }
+            fprintf(m_log, "\n");
+        }
+        // A soak run may end in a crash; keep what was logged.
+        fflush(m_log);
+    }
+
+    for (LatencyHistogram& h : m_window)
+    {
+        h.reset();
+    }
+}
+
+void FrameTelemetry::printTotals() const
+{
+    printf("telemetry over %llu frames, ms:\n"
+           "                p50      p99    p99.9      max\n",
+           static_cast<unsigned long long>(m_total[kFrameMetric].count()));
+    for (int metric = 0; metric < kMetricCount; ++metric)
+    {
+        const LatencyHistogram& h = m_total[metric];
+        printf("  %-8s %8.3f %8.3f %8.3f %8.3f\n",
+               MetricName(metric),
+               h.percentile(50),
+               h.percentile(99),
+               h.percentile(99.9),
+               h.max());
+    }
+}
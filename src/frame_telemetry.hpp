@@ -0,0 +1,80 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+
+// Log-linear latency histogram in the style of HdrHistogram: values are
+// nanoseconds, exact below 64ns and within 1/32 (~3%) above, up to ~4.9
+// hours. Recording is a bucket increment; nothing allocates.
+class LatencyHistogram
+{
+public:
+    void record(double ms);
+    void reset();
+
+    uint64_t count() const { return m_count; }
+    double mean() const { return m_count ? m_sumMs / m_count : 0; }
+    double max() const { return m_maxMs; }
+    // Nearest-rank percentile, reported as the upper edge of its bucket
+    // (never above the exact max).
+    double percentile(double p) const;
+
+private:
+    constexpr static int kSubBucketBits = 5;
+    constexpr static int kSubBucketCount = 1 << kSubBucketBits;
+    constexpr static int kMaxValueBits = 44;
+    constexpr static int kBucketCount =
+        (kMaxValueBits - kSubBucketBits + 1) * kSubBucketCount;
+
+    static int BucketIndex(uint64_t ns);
+    static uint64_t BucketUpperBound(int index);
+
+    std::array<uint64_t, kBucketCount> m_counts = {};
+    uint64_t m_count = 0;
+    double m_sumMs = 0;
+    double m_maxMs = 0;
+};
+
+// Frame, advance and flush time histograms, cumulative and over a rolling
+// window that snapshot() closes. Snapshots print one line and can append to
+// a log for soak runs.
+class FrameTelemetry
+{
+public:
+    enum Metric
+    {
+        kFrameMetric, // Wall time between the ends of consecutive frames.
+        kAdvanceMetric,
+        kFlushMetric,
+        kMetricCount,
+    };
+
+    static const char* MetricName(int metric);
+
+    ~FrameTelemetry();
+
+    // Appends snapshots to `path`: JSON Lines when it ends in .json or
+    // .jsonl, otherwise CSV (with a header if the file is new).
+    bool openLog(const char* path);
+
+    void record(double frameMs, double advanceMs, double flushMs);
+
+    const LatencyHistogram& window(int metric) const
+    {
+        return m_window[metric];
+    }
+    const LatencyHistogram& total(int metric) const { return m_total[metric]; }
+
+    // Reports the current window and starts a new one. `elapsedSeconds`
+    // timestamps the snapshot.
+    void snapshot(double elapsedSeconds);
+    // Percentiles over every recorded frame.
+    void printTotals() const;
+
+private:
+    LatencyHistogram m_window[kMetricCount];
+    LatencyHistogram m_total[kMetricCount];
+    FILE* m_log = nullptr;
+    bool m_logIsJSON = false;
+};
@@ -0,0 +1,143 @@
+#include "hitch_recorder.hpp"
+
+#include "json_writer.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+HitchRecorder::HitchRecorder(double budgetMs, std::string directory) :
+    m_budgetMs(budgetMs), m_directory(std::move(directory))
+{}
+
+bool HitchRecorder::record(const HitchFrame& frame)
+{
+    m_frames[m_recordedCount++ % kFrameCount] = frame;
+    const bool hitch = frame.frameMs > m_budgetMs;
+    if (m_framesUntilDump < 0)
+    {
+        if (!hitch)
+        {
+            return false;
+        }
+        m_framesUntilDump = kFramesAfterHitch;
+        m_firstHitchFrame = frame.frameNumber;
+        m_pendingHitches = 0;
+    }
+    else
+    {
+        --m_framesUntilDump;
+    }
+    m_pendingHitches += hitch;
+    return m_framesUntilDump == 0;
+}
+
+// Opens a complete event; the caller may add to it and closes it. Chrome
+// trace timestamps are microseconds.
+static void write_event(JSONWriter* json,
+                        const char* name,
+                        uint64_t startNs,
+                        double durationMs,
+                        uint64_t baseNs)
+{
+    json->beginObject();
+    json->string("name", name);
+    json->string("ph", "X");
+    json->integer("pid", 1);
+    json->integer("tid", 1);
+    json->integer("ts", static_cast<int64_t>((startNs - baseNs) / 1000));
+    json->integer("dur", static_cast<int64_t>(durationMs * 1e3));
+}
+
+bool HitchRecorder::writeDump()
+{
+    m_framesUntilDump = -1;
+    char path[1024];
+    snprintf(path,
+             sizeof(path),
+             "%s/hitch_%06llu.json",
+             m_directory.c_str(),
+             static_cast<unsigned long long>(m_firstHitchFrame));
+    FILE* file = fopen(path, "w");
+    if (file == nullptr)
+    {
+        fprintf(stderr, "Failed to open %s for writing\n", path);
+        return false;
+    }
+
+    const uint64_t count =
+        std::min<uint64_t>(m_recordedCount, kFrameCount);
+    const uint64_t first = m_recordedCount - count;
+    const HitchFrame& oldest = m_frames[first % kFrameCount];
+    const uint64_t baseNs =
+        oldest.endNs - static_cast<uint64_t>(oldest.frameMs * 1e6);
+
+    JSONWriter json(file);
+    json.beginObject();
+    json.string("displayTimeUnit", "ms");
+    json.beginArray("traceEvents");
+    for (uint64_t i = first; i < m_recordedCount; ++i)
+    {
+        const HitchFrame& frame = m_frames[i % kFrameCount];
+        const bool hitch = frame.frameMs > m_budgetMs;
+        const uint64_t startNs =
+            frame.endNs - static_cast<uint64_t>(frame.frameMs * 1e6);
+        write_event(&json,
+                    hitch ? "frame (over budget)" : "frame",
+                    startNs,
+                    frame.frameMs,
+                    baseNs);
+        json.beginObject("args");
+        json.integer("frame", static_cast<int64_t>(frame.frameNumber));
+        json.number("frame_ms", frame.frameMs);
+        json.string("scene", frame.scene);
+        json.boolean("size_changed", frame.sizeChanged);
+        json.boolean("imported", frame.importMs > 0);
+        json.boolean("made_scenes", frame.madeScenes);
+        json.number("acquire_ms", frame.acquireMs);
+        json.endObject();
+        json.endObject();
+
+        // Only durations are kept, so phases are laid out back to back,
+        // ending where the frame ended; whatever is left at the start is
+        // time outside the timed phases (events, the OS, the previous
+        // present).
+        double phasesMs = frame.importMs + frame.timings.total();
+        uint64_t ns = frame.endNs - static_cast<uint64_t>(phasesMs * 1e6);
+        if (frame.importMs > 0)
+        {
+            write_event(&json, "import", ns, frame.importMs, baseNs);
+            json.endObject();
+            ns += static_cast<uint64_t>(frame.importMs * 1e6);
+        }
+        for (int phase = 0; phase < kFramePhaseCount; ++phase)
+        {
+            const double ms = frame.timings.ms[phase];
+            if (ms <= 0)
+            {
+                continue;
+            }
+            write_event(&json,
+                        frame_phase_name(static_cast<FramePhase>(phase)),
+                        ns,
+                        ms,
+                        baseNs);
+            json.endObject();
+            if (phase == kFlushPhase && frame.acquireMs > 0)
+            {
+                write_event(&json, "acquire", ns, frame.acquireMs, baseNs);
+                json.endObject();
+            }
+            ns += static_cast<uint64_t>(ms * 1e6);
+        }
+    }
+    json.endArray();
+    json.endObject();
+    const bool ok = fclose(file) == 0;
+    printf("Hitch at frame %llu (%i over %.1f ms): wrote %llu frames to %s\n",
+           static_cast<unsigned long long>(m_firstHitchFrame),
+           m_pendingHitches,
+           m_budgetMs,
+           static_cast<unsigned long long>(count),
+           path);
+    return ok;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "frame_stats.hpp"
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+// What the hitch recorder keeps about one frame. Fixed size, so recording a
+// frame is a copy into the ring.
+struct HitchFrame
+{
+    uint64_t frameNumber = 0;
+    uint64_t endNs = 0; // trace_now_ns() when the frame finished.
+    double frameMs = 0; // End to end, like FrameTelemetry's frame metric.
+    FrameTimings timings;
+    double acquireMs = 0; // Swapchain image wait, inside flush.
+    double importMs = 0;  // Nonzero when the .riv was imported this frame.
+    bool sizeChanged = false;
+    bool madeScenes = false;
+    char scene[64] = {}; // The scene advanced this frame, if any.
+};
+
+// Flight recorder: always keeps the last kFrameCount frames. When a frame
+// runs over budget it waits kFramesAfterHitch more frames (folding in any
+// further hitches), then asks to be dumped as a Chrome trace.
+class HitchRecorder
+{
+public:
+    constexpr static int kFrameCount = 256;
+    constexpr static int kFramesAfterHitch = 16;
+
+    HitchRecorder(double budgetMs, std::string directory);
+
+    // Returns true when a dump is due.
+    bool record(const HitchFrame&);
+    // Writes the ring to <directory>/hitch_<first hitch frame>.json.
+    bool writeDump();
+
+    double budgetMs() const { return m_budgetMs; }
+
+private:
+    const double m_budgetMs;
+    const std::string m_directory;
+    std::array<HitchFrame, kFrameCount> m_frames;
+    uint64_t m_recordedCount = 0;
+    // -1 while no hitch is pending.
+    int m_framesUntilDump = -1;
+    uint64_t m_firstHitchFrame = 0;
+    int m_pendingHitches = 0;
+};
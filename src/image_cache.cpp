@@ -0,0 +1,281 @@
+#include "image_cache.hpp"
+
+#include "asset_bundle.hpp"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+// Bump when the file layout or the decoded output changes; old entries then
+// miss and age out.
+constexpr static uint32_t kImageCacheVersion = 1;
+constexpr static char kImageCacheMagic[8] = {'L', 'P', 'I', 'M', 'G', 'C', 'H', 'E'};
+constexpr static uint32_t kPixelFormatRGBAPremul = 1;
+
+// Followed by width * height * 4 bytes of pixels. 32 bytes, so the pixels
+// start aligned.
+struct ImageCacheHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t pixelFormat;
+    uint32_t width;
+    uint32_t height;
+    uint64_t encodedSize; // Guards against hash collisions.
+};
+
+static long process_id()
+{
+#if defined(_WIN32)
+    return _getpid();
+#else
+    return getpid();
+#endif
+}
+
+static bool is_cache_entry(const fs::path& path)
+{
+    return path.extension() == ".rgba";
+}
+
+static bool read_header(const MappedFile& file,
+                        uint64_t encodedSize,
+                        ImageCacheHeader* header)
+{
+    if (file.size() < sizeof(*header))
+    {
+        return false;
+    }
+    memcpy(header, file.data(), sizeof(*header));
+    return memcmp(header->magic, kImageCacheMagic, sizeof(header->magic)) ==
+               0 &&
+           header->version == kImageCacheVersion &&
+           header->pixelFormat == kPixelFormatRGBAPremul &&
+           header->encodedSize == encodedSize &&
+           file.size() - sizeof(*header) ==
+               uint64_t(header->width) * header->height * 4;
+}
+
+std::unique_ptr<DecodedImageCache> DecodedImageCache::Open(
+    const std::string& dir,
+    uint64_t maxBytes)
+{
+    std::error_code error;
+    fs::create_directories(dir, error);
+    if (!fs::is_directory(dir, error))
+    {
+        fprintf(stderr, "image cache: can't use %s\n", dir.c_str());
+        return nullptr;
+    }
+    std::unique_ptr<DecodedImageCache> cache(
+        new DecodedImageCache(dir, maxBytes));
+    uint64_t totalBytes = 0;
+    for (auto it = fs::directory_iterator(dir, error);
+         !error && it != fs::directory_iterator();
+         it.increment(error))
+    {
+        if (is_cache_entry(it->path()))
+        {
+            totalBytes += it->file_size(error);
+        }
+    }
+    cache->m_totalBytes = totalBytes;
+    if (totalBytes > maxBytes)
+    {
+        cache->evict();
+    }
+    return cache;
+}
+
+std::string DecodedImageCache::entryPath(
+    rive::Span<const uint8_t> encoded) const
+{
+    struct
+    {
+        uint64_t encodedHash;
+        uint32_t version;
+        uint32_t pixelFormat;
+    } key = {bundle_hash(encoded.data(), encoded.size()),
+             kImageCacheVersion,
+             kPixelFormatRGBAPremul};
+    char name[32];
+    snprintf(name,
+             sizeof(name),
+             "%016" PRIx64 ".rgba",
+             bundle_hash(&key, sizeof(key)));
+    return (fs::path(m_dir) / name).string();
+}
+
+std::unique_ptr<CachedImage> DecodedImageCache::lookup(
+    rive::Span<const uint8_t> encoded)
+{
+    const std::string path = entryPath(encoded);
+    std::error_code error;
+    if (!fs::exists(path, error))
+    {
+        ++m_misses;
+        return nullptr;
+    }
+    auto image = std::unique_ptr<CachedImage>(new CachedImage());
+    image->m_file = MappedFile::Open(path, MappedFile::Access::sequential);
+    ImageCacheHeader header;
+    if (!image->m_file ||
+        !read_header(*image->m_file, encoded.size(), &header))
+    {
+        // Truncated by a crash, or a collision: drop it and decode again.
+        fprintf(stderr, "image cache: discarding bad entry %s\n", path.c_str());
+        image = nullptr;
+        fs::remove(path, error);
+        ++m_misses;
+        return nullptr;
+    }
+    image->m_width = header.width;
+    image->m_height = header.height;
+    image->m_pixels = image->m_file->data() + sizeof(header);
+    // Mark it recently used.
+    fs::last_write_time(path, fs::file_time_type::clock::now(), error);
+    ++m_hits;
+    return image;
+}
+
+void DecodedImageCache::store(rive::Span<const uint8_t> encoded,
+                              uint32_t width,
+                              uint32_t height,
+                              const uint8_t* pixels)
+{
+    const uint64_t pixelBytes = uint64_t(width) * height * 4;
+    const uint64_t fileBytes = sizeof(ImageCacheHeader) + pixelBytes;
+    if (fileBytes > m_maxBytes)
+    {
+        return;
+    }
+    const std::string path = entryPath(encoded);
+    // Unique per process and thread, so concurrent stores of the same image,
+    // from this launch or another sharing the directory, don't write into
+    // one temporary file.
+    char suffix[48];
+    snprintf(suffix,
+             sizeof(suffix),
+             ".%lx.%zx.tmp",
+             static_cast<unsigned long>(process_id()),
+             std::hash<std::thread::id>()(std::this_thread::get_id()));
+    const std::string tempPath = path + suffix;
+
+    ImageCacheHeader header = {};
+    memcpy(header.magic, kImageCacheMagic, sizeof(header.magic));
+    header.version = kImageCacheVersion;
+    header.pixelFormat = kPixelFormatRGBAPremul;
+    header.width = width;
+    header.height = height;
+    header.encodedSize = encoded.size();
+    FILE* file = fopen(tempPath.c_str(), "wb");
+    if (file == nullptr)
+    {
+        fprintf(stderr, "image cache: failed to write %s\n", tempPath.c_str());
+        return;
+    }
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+              fwrite(pixels, 1, pixelBytes, file) == pixelBytes;
+    ok = fclose(file) == 0 && ok;
+    std::error_code error;
+    const bool replacing = fs::exists(path, error);
+    if (ok)
+    {
+        fs::rename(tempPath, path, error);
+        ok = !error;
+    }
+    if (!ok)
+    {
+        fprintf(stderr, "image cache: failed to write %s\n", path.c_str());
+        fs::remove(tempPath, error);
+        return;
+    }
+    if (!replacing && (m_totalBytes += fileBytes) > m_maxBytes)
+    {
+        evict();
+    }
+}
+
+void DecodedImageCache::evict()
+{
+    std::lock_guard<std::mutex> lock(m_evictMutex);
+    struct Entry
+    {
+        fs::path path;
+        fs::file_time_type lastUse;
+        uint64_t size;
+    };
+    std::vector<Entry> entries;
+    uint64_t totalBytes = 0;
+    std::error_code error;
+    for (auto it = fs::directory_iterator(m_dir, error);
+         !error && it != fs::directory_iterator();
+         it.increment(error))
+    {
+        std::error_code entryError;
+        if (!is_cache_entry(it->path()))
+        {
+            continue;
+        }
+        Entry entry = {it->path(),
+                       it->last_write_time(entryError),
+                       it->file_size(entryError)};
+        if (!entryError)
+        {
+            totalBytes += entry.size;
+            entries.push_back(std::move(entry));
+        }
+    }
+    // Another thread (or process) may have evicted already.
+    if (totalBytes <= m_maxBytes)
+    {
+        m_totalBytes = totalBytes;
+        return;
+    }
+    std::sort(entries.begin(),
+              entries.end(),
+              [](const Entry& a, const Entry& b) {
+                  return a.lastUse < b.lastUse;
+              });
+    // Down to 3/4 of the cap, so a full cache doesn't rescan the directory
+    // on every store.
+    const uint64_t target = m_maxBytes / 4 * 3;
+    for (const Entry& entry : entries)
+    {
+        if (totalBytes <= target)
+        {
+            break;
+        }
+        if (fs::remove(entry.path, error))
+        {
+            totalBytes -= entry.size;
+            ++m_evictions;
+        }
+    }
+    m_totalBytes = totalBytes;
+}
+
+void DecodedImageCache::printStats() const
+{
+    printf("image cache %s: %llu hits, %llu misses, %llu evicted, %.1f of "
+           "%.1f MB\n",
+           m_dir.c_str(),
+           static_cast<unsigned long long>(m_hits.load()),
+           static_cast<unsigned long long>(m_misses.load()),
+           static_cast<unsigned long long>(m_evictions.load()),
+           m_totalBytes / (1024.0 * 1024.0),
+           m_maxBytes / (1024.0 * 1024.0));
+}
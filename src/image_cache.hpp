@@ -0,0 +1,79 @@
+#pragma once
+
+#include "asset_utils.hpp"
+
+#include "rive/span.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+
+// One decoded image read back from the cache. The pixels are premultiplied
+// RGBA, top row first, and point into a mapping of the cache file; they stay
+// valid for the lifetime of the object.
+class CachedImage
+{
+public:
+    uint32_t width() const { return m_width; }
+    uint32_t height() const { return m_height; }
+    const uint8_t* pixels() const { return m_pixels; }
+
+private:
+    friend class DecodedImageCache;
+
+    std::unique_ptr<MappedFile> m_file;
+    uint32_t m_width = 0;
+    uint32_t m_height = 0;
+    const uint8_t* m_pixels = nullptr;
+};
+
+// Persistent cache of decoded images, so a relaunch maps the pixels back
+// instead of running libpng/libwebp/libjpeg again. Entries are keyed by a
+// hash of the encoded bytes and the decode parameters (output format and the
+// cache's own version), one file each. A file's modification time is its
+// last use: hits touch it, and once the directory grows past its cap the
+// least recently used files are deleted.
+//
+// lookup() and store() are safe to call from several threads, and several
+// processes can share a directory: files are written under a temporary name
+// and renamed into place.
+class DecodedImageCache
+{
+public:
+    // Creates `dir` if needed. Prints the reason and returns null if it
+    // can't be used.
+    static std::unique_ptr<DecodedImageCache> Open(const std::string& dir,
+                                                   uint64_t maxBytes);
+
+    // Null on a miss (or a corrupt entry, which is removed).
+    std::unique_ptr<CachedImage> lookup(rive::Span<const uint8_t> encoded);
+    // Saves premultiplied RGBA pixels decoded from `encoded`.
+    void store(rive::Span<const uint8_t> encoded,
+               uint32_t width,
+               uint32_t height,
+               const uint8_t* pixels);
+
+    uint64_t hits() const { return m_hits; }
+    uint64_t misses() const { return m_misses; }
+    uint64_t totalBytes() const { return m_totalBytes; }
+    void printStats() const;
+
+private:
+    DecodedImageCache(std::string dir, uint64_t maxBytes) :
+        m_dir(std::move(dir)), m_maxBytes(maxBytes)
+    {}
+
+    std::string entryPath(rive::Span<const uint8_t> encoded) const;
+    // Deletes the least recently used entries until the cache fits.
+    void evict();
+
+    const std::string m_dir;
+    const uint64_t m_maxBytes;
+    std::atomic<uint64_t> m_totalBytes{0};
+    std::atomic<uint64_t> m_hits{0};
+    std::atomic<uint64_t> m_misses{0};
+    std::atomic<uint64_t> m_evictions{0};
+    std::mutex m_evictMutex;
+};
@@ -0,0 +1,188 @@
+#include "image_diff.hpp"
+
+#include "cpu_features.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+
+using DiffRowFn = void (*)(const uint8_t* a,
+                           const uint8_t* b,
+                           uint32_t width,
+                           uint8_t tolerance,
+                           ImageDiff* diff);
+
+static void diff_row_scalar(const uint8_t* a,
+                            const uint8_t* b,
+                            uint32_t width,
+                            uint8_t tolerance,
+                            ImageDiff* diff)
+{
+    for (uint32_t x = 0; x < width; ++x, a += 4, b += 4)
+    {
+        int delta = 0;
+        for (int c = 0; c < 4; ++c)
+        {
+            delta = std::max(delta, abs(a[c] - b[c]));
+        }
+        diff->maxChannelDelta =
+            std::max(diff->maxChannelDelta, static_cast<uint8_t>(delta));
+        diff->mismatchedPixels += delta > tolerance;
+    }
+}
+
+#ifdef LP_X86
+// Bits set in a 4-bit movemask (avoids __builtin_popcount for MSVC).
+constexpr static uint8_t kPopcount4[16] =
+    {0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4};
+
+LP_TARGET_SSE41 static void diff_row_sse41(const uint8_t* a,
+                                           const uint8_t* b,
+                                           uint32_t width,
+                                           uint8_t tolerance,
+                                           ImageDiff* diff)
+{
+    const __m128i tol = _mm_set1_epi8(static_cast<char>(tolerance));
+    __m128i maxDelta = _mm_setzero_si128();
+    uint64_t mismatched = 0;
+    uint32_t x = 0;
+    for (; x + 4 <= width; x += 4, a += 16, b += 16)
+    {
+        __m128i pa = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a));
+        __m128i pb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b));
+        __m128i delta =
+            _mm_or_si128(_mm_subs_epu8(pa, pb), _mm_subs_epu8(pb, pa));
+        maxDelta = _mm_max_epu8(maxDelta, delta);
+        // A pixel matches when all four channels saturate to zero.
+        __m128i ok = _mm_cmpeq_epi32(_mm_subs_epu8(delta, tol),
+                                     _mm_setzero_si128());
+        mismatched +=
+            4 - kPopcount4[_mm_movemask_ps(_mm_castsi128_ps(ok))];
+    }
+    maxDelta = _mm_max_epu8(maxDelta, _mm_srli_si128(maxDelta, 8));
+    maxDelta = _mm_max_epu8(maxDelta, _mm_srli_si128(maxDelta, 4));
+    maxDelta = _mm_max_epu8(maxDelta, _mm_srli_si128(maxDelta, 2));
+    maxDelta = _mm_max_epu8(maxDelta, _mm_srli_si128(maxDelta, 1));
+    diff->maxChannelDelta =
+        std::max(diff->maxChannelDelta,
+                 static_cast<uint8_t>(_mm_cvtsi128_si32(maxDelta)));
+    diff->mismatchedPixels += mismatched;
+    diff_row_scalar(a, b, width - x, tolerance, diff);
+}
+
+LP_TARGET_AVX2 static void diff_row_avx2(const uint8_t* a,
+                                         const uint8_t* b,
+                                         uint32_t width,
+                                         uint8_t tolerance,
+                                         ImageDiff* diff)
+{
+    const __m256i tol = _mm256_set1_epi8(static_cast<char>(tolerance));
+    __m256i maxDelta = _mm256_setzero_si256();
+    uint64_t mismatched = 0;
+    uint32_t x = 0;
+    for (; x + 8 <= width; x += 8, a += 32, b += 32)
+    {
+        __m256i pa = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a));
+        __m256i pb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b));
+        __m256i delta = _mm256_or_si256(_mm256_subs_epu8(pa, pb),
+                                        _mm256_subs_epu8(pb, pa));
+        maxDelta = _mm256_max_epu8(maxDelta, delta);
+        __m256i ok = _mm256_cmpeq_epi32(_mm256_subs_epu8(delta, tol),
+                                        _mm256_setzero_si256());
+        int okMask = _mm256_movemask_ps(_mm256_castsi256_ps(ok));
+        mismatched += 8 - kPopcount4[okMask & 0xf] - kPopcount4[okMask >> 4];
+    }
+    __m128i max128 = _mm_max_epu8(_mm256_castsi256_si128(maxDelta),
+                                  _mm256_extracti128_si256(maxDelta, 1));
+    max128 = _mm_max_epu8(max128, _mm_srli_si128(max128, 8));
+    max128 = _mm_max_epu8(max128, _mm_srli_si128(max128, 4));
+    max128 = _mm_max_epu8(max128, _mm_srli_si128(max128, 2));
+    max128 = _mm_max_epu8(max128, _mm_srli_si128(max128, 1));
+    diff->maxChannelDelta =
+        std::max(diff->maxChannelDelta,
+                 static_cast<uint8_t>(_mm_cvtsi128_si32(max128)));
+    diff->mismatchedPixels += mismatched;
+    diff_row_scalar(a, b, width - x, tolerance, diff);
+}
+#endif
+
+#ifdef LP_ARM_NEON
+static void diff_row_neon(const uint8_t* a,
+                          const uint8_t* b,
+                          uint32_t width,
+                          uint8_t tolerance,
+                          ImageDiff* diff)
+{
+    const uint8x16_t tol = vdupq_n_u8(tolerance);
+    uint8x16_t maxDelta = vdupq_n_u8(0);
+    uint64_t mismatched = 0;
+    uint32_t x = 0;
+    for (; x + 4 <= width; x += 4, a += 16, b += 16)
+    {
+        uint8x16_t delta = vabdq_u8(vld1q_u8(a), vld1q_u8(b));
+        maxDelta = vmaxq_u8(maxDelta, delta);
+        // Nonzero 32-bit lanes are pixels with a channel over tolerance.
+        uint32x4_t over =
+            vtstq_u32(vreinterpretq_u32_u8(vqsubq_u8(delta, tol)),
+                      vdupq_n_u32(~0u));
+        mismatched += vaddvq_u32(vshrq_n_u32(over, 31));
+    }
+    diff->maxChannelDelta =
+        std::max(diff->maxChannelDelta, vmaxvq_u8(maxDelta));
+    diff->mismatchedPixels += mismatched;
+    diff_row_scalar(a, b, width - x, tolerance, diff);
+}
+#endif
+
+struct DiffKernel
+{
+    DiffRowFn diffRow;
+    const char* name;
+};
+
+static DiffKernel select_kernel()
+{
+    const CPUFeatures& features = cpu_features();
+#ifdef LP_X86
+    if (features.avx2)
+    {
+        return {diff_row_avx2, "avx2"};
+    }
+    if (features.sse41)
+    {
+        return {diff_row_sse41, "sse4.1"};
+    }
+#endif
+#ifdef LP_ARM_NEON
+    if (features.neon)
+    {
+        return {diff_row_neon, "neon"};
+    }
+#endif
+    (void)features;
+    return {diff_row_scalar, "scalar"};
+}
+
+static const DiffKernel& kernel()
+{
+    static const DiffKernel selected = select_kernel();
+    return selected;
+}
+
+ImageDiff diff_images(const uint8_t* a,
+                      size_t aRowBytes,
+                      const uint8_t* b,
+                      size_t bRowBytes,
+                      uint32_t width,
+                      uint32_t height,
+                      uint8_t tolerance)
+{
+    ImageDiff diff;
+    const DiffRowFn diffRow = kernel().diffRow;
+    for (uint32_t y = 0; y < height; ++y)
+    {
+        diffRow(a + aRowBytes * y, b + bRowBytes * y, width, tolerance, &diff);
+    }
+    return diff;
+}
+
+const char* image_diff_kernel_name() { return kernel().name; }
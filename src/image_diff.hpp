@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+struct ImageDiff
+{
+    // Pixels where any channel differs by more than the tolerance.
+    uint64_t mismatchedPixels = 0;
+    // Largest per-channel difference anywhere in the image.
+    uint8_t maxChannelDelta = 0;
+};
+
+// Compares two width x height blocks of 4-byte pixels channel by channel,
+// picking an AVX2, SSE4.1 or NEON kernel at runtime. A pixel matches when
+// every channel is within `tolerance` of the other image's.
+ImageDiff diff_images(const uint8_t* a,
+                      size_t aRowBytes,
+                      const uint8_t* b,
+                      size_t bRowBytes,
+                      uint32_t width,
+                      uint32_t height,
+                      uint8_t tolerance);
+
+// Name of the kernel diff_images() dispatches to on this machine.
+const char* image_diff_kernel_name();
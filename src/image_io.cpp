@@ -0,0 +1,176 @@
+#include "image_io.hpp"
+
+#include <cstdio>
+#include <vector>
+
+#include "png.h"
+#include "webp/encode.h"
+
+bool write_png(const char* path,
+               uint32_t width,
+               uint32_t height,
+               const uint8_t* topRow,
+               ptrdiff_t rowStride)
+{
+    FILE* file = fopen(path, "wb");
+    if (file == nullptr)
+    {
+        fprintf(stderr, "Failed to open %s for writing\n", path);
+        return false;
+    }
+
+    png_structp png =
+        png_create_write_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+    png_infop info = png ? png_create_info_struct(png) : nullptr;
+    if (info == nullptr)
+    {
+        png_destroy_write_struct(&png, nullptr);
+        fclose(file);
+        return false;
+    }
+
+    std::vector<png_const_bytep> rows(height);
+    for (uint32_t y = 0; y < height; ++y)
+    {
+        rows[y] = topRow + rowStride * static_cast<ptrdiff_t>(y);
+    }
+
+    if (setjmp(png_jmpbuf(png)))
+    {
+        fprintf(stderr, "libpng failed writing %s\n", path);
+        png_destroy_write_struct(&png, &info);
+        fclose(file);
+        return false;
+    }
+
+    png_init_io(png, file);
+    // Captured frames are written once and rarely re-read; favor encode speed
+    // over file size.
+    png_set_compression_level(png, 1);
+    png_set_filter(png, 0, PNG_FILTER_SUB);
+    png_set_IHDR(png,
+                 info,
+                 width,
+                 height,
+                 8,
+                 PNG_COLOR_TYPE_RGBA,
+                 PNG_INTERLACE_NONE,
+                 PNG_COMPRESSION_TYPE_DEFAULT,
+                 PNG_FILTER_TYPE_DEFAULT);
+    png_write_info(png, info);
+    png_write_rows(png, const_cast<png_bytepp>(rows.data()), height);
+    png_write_end(png, nullptr);
+
+    png_destroy_write_struct(&png, &info);
+    // Buffered bytes only reach the disk here; a full disk shows up now.
+    if (fclose(file) != 0)
+    {
+        fprintf(stderr, "Failed to write %s\n", path);
+        return false;
+    }
+    return true;
+}
+
+bool read_png(const char* path,
+              uint32_t* width,
+              uint32_t* height,
+              std::vector<uint8_t>* rgba)
+{
+    FILE* file = fopen(path, "rb");
+    if (file == nullptr)
+    {
+        return false;
+    }
+
+    png_structp png =
+        png_create_read_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+    png_infop info = png ? png_create_info_struct(png) : nullptr;
+    if (info == nullptr)
+    {
+        png_destroy_read_struct(&png, nullptr, nullptr);
+        fclose(file);
+        return false;
+    }
+
+    std::vector<png_bytep> rows;
+    if (setjmp(png_jmpbuf(png)))
+    {
+        fprintf(stderr, "libpng failed reading %s\n", path);
+        png_destroy_read_struct(&png, &info, nullptr);
+        fclose(file);
+        return false;
+    }
+
+    png_init_io(png, file);
+    png_read_info(png, info);
+    png_set_expand(png);
+    png_set_strip_16(png);
+    png_set_gray_to_rgb(png);
+    png_set_add_alpha(png, 0xff, PNG_FILLER_AFTER);
+    png_read_update_info(png, info);
+
+    *width = png_get_image_width(png, info);
+    *height = png_get_image_height(png, info);
+    rgba->resize(static_cast<size_t>(*width) * *height * 4);
+    rows.resize(*height);
+    for (uint32_t y = 0; y < *height; ++y)
+    {
+        rows[y] = rgba->data() + static_cast<size_t>(*width) * 4 * y;
+    }
+    png_read_image(png, rows.data());
+    png_read_end(png, nullptr);
+
+    png_destroy_read_struct(&png, &info, nullptr);
+    fclose(file);
+    return true;
+}
+
+bool write_webp(const char* path,
+                uint32_t width,
+                uint32_t height,
+                const uint8_t* topRow,
+                ptrdiff_t rowStride,
+                float quality)
+{
+    if (rowStride < 0)
+    {
+        // libwebp only walks rows forward.
+        fprintf(stderr, "write_webp: negative row stride is unsupported\n");
+        return false;
+    }
+    uint8_t* encoded = nullptr;
+    size_t encodedSize =
+        quality < 0 ? WebPEncodeLosslessRGBA(topRow,
+                                             width,
+                                             height,
+                                             static_cast<int>(rowStride),
+                                             &encoded)
+                    : WebPEncodeRGBA(topRow,
+                                     width,
+                                     height,
+                                     static_cast<int>(rowStride),
+                                     quality,
+                                     &encoded);
+    if (encodedSize == 0)
+    {
+        fprintf(stderr, "libwebp failed encoding %s\n", path);
+        WebPFree(encoded);
+        return false;
+    }
+
+    FILE* file = fopen(path, "wb");
+    if (file == nullptr)
+    {
+        fprintf(stderr, "Failed to open %s for writing\n", path);
+        WebPFree(encoded);
+        return false;
+    }
+    bool ok = fwrite(encoded, 1, encodedSize, file) == encodedSize;
+    ok = fclose(file) == 0 && ok;
+    WebPFree(encoded);
+    if (!ok)
+    {
+        fprintf(stderr, "Failed to write %s\n", path);
+    }
+    return ok;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Writes 8-bit RGBA pixels to a PNG file. Rows are read starting at
+// topRow and advance by rowStride bytes, so a bottom-up readback (the
+// layout FiddleContext::end() produces) is written upright by passing its
+// last row and a negative stride.
+bool write_png(const char* path,
+               uint32_t width,
+               uint32_t height,
+               const uint8_t* topRow,
+               ptrdiff_t rowStride);
+
+// Writes 8-bit RGBA pixels to a WebP file, top row first. quality < 0 selects
+// lossless encoding; otherwise it is the lossy quality in [0, 100].
+bool write_webp(const char* path,
+                uint32_t width,
+                uint32_t height,
+                const uint8_t* topRow,
+                ptrdiff_t rowStride,
+                float quality);
+
+// Decodes a PNG file to 8-bit RGBA, top row first. Palette, grayscale and
+// 16-bit images are expanded; images without alpha get an opaque channel.
+bool read_png(const char* path,
+              uint32_t* width,
+              uint32_t* height,
+              std::vector<uint8_t>* rgba);
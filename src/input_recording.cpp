@@ -0,0 +1,252 @@
+#include "input_recording.hpp"
+
+#include "rive/scene.hpp"
+#include "rive/animation/state_machine_bool.hpp"
+#include "rive/animation/state_machine_input_instance.hpp"
+#include "rive/animation/state_machine_number.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+using namespace rive;
+
+// File layout: magic, uint32 sizeof(SDL_Event), uint32 width, uint32 height,
+// then one record per frame:
+//     double deltaSeconds
+//     uint32 eventCount, SDL_Event[eventCount]
+//     uint32 changeCount, {uint16 index, float value}[changeCount]
+constexpr static char kInputLogMagic[8] =
+    {'L', 'P', 'I', 'N', 'P', 'U', 'T', '2'};
+
+static bool read_input(const SMIInput* input, float* value)
+{
+    switch (input->inputCoreType())
+    {
+        case StateMachineNumberBase::typeKey:
+            *value = static_cast<const SMINumber*>(input)->value();
+            return true;
+        case StateMachineBoolBase::typeKey:
+            *value = static_cast<const SMIBool*>(input)->value() ? 1.f : 0.f;
+            return true;
+    }
+    return false;
+}
+
+static void write_input(SMIInput* input, float value)
+{
+    switch (input->inputCoreType())
+    {
+        case StateMachineNumberBase::typeKey:
+            static_cast<SMINumber*>(input)->value(value);
+            break;
+        case StateMachineBoolBase::typeKey:
+            static_cast<SMIBool*>(input)->value(value != 0);
+            break;
+    }
+}
+
+template <typename T> static void write_pod(FILE* file, const T& value)
+{
+    fwrite(&value, sizeof(T), 1, file);
+}
+
+template <typename T> static bool read_pod(FILE* file, T* value)
+{
+    return fread(value, sizeof(T), 1, file) == 1;
+}
+
+std::unique_ptr<InputRecorder> InputRecorder::Open(const char* path,
+                                                   uint32_t width,
+                                                   uint32_t height)
+{
+    FILE* file = fopen(path, "wb");
+    if (file == nullptr)
+    {
+        fprintf(stderr, "Failed to open %s for writing\n", path);
+        return nullptr;
+    }
+    fwrite(kInputLogMagic, sizeof(kInputLogMagic), 1, file);
+    write_pod(file, static_cast<uint32_t>(sizeof(SDL_Event)));
+    write_pod(file, width);
+    write_pod(file, height);
+    return std::unique_ptr<InputRecorder>(new InputRecorder(file));
+}
+
+InputRecorder::InputRecorder(FILE* file) : m_file(file) {}
+
+InputRecorder::~InputRecorder()
+{
+    fclose(m_file);
+    printf("Recorded input for %u frames\n", m_frameCount);
+}
+
+void InputRecorder::recordEvent(const SDL_Event& event)
+{
+    m_frame.events.push_back(event);
+}
+
+void InputRecorder::endFrame(double deltaSeconds, Scene* scene)
+{
+    const size_t inputCount = scene ? scene->inputCount() : 0;
+    // NaN never compares equal, so every input is logged the first time.
+    m_lastInputValues.resize(inputCount, NAN);
+    m_frame.inputChanges.clear();
+    for (size_t i = 0; i < inputCount; ++i)
+    {
+        float value;
+        if (read_input(scene->input(i), &value) &&
+            !(value == m_lastInputValues[i]))
+        {
+            m_frame.inputChanges.push_back({static_cast<uint16_t>(i), value});
+            m_lastInputValues[i] = value;
+        }
+    }
+
+    write_pod(m_file, deltaSeconds);
+    write_pod(m_file, static_cast<uint32_t>(m_frame.events.size()));
+    fwrite(m_frame.events.data(),
+           sizeof(SDL_Event),
+           m_frame.events.size(),
+           m_file);
+    write_pod(m_file, static_cast<uint32_t>(m_frame.inputChanges.size()));
+    for (const InputChange& change : m_frame.inputChanges)
+    {
+        write_pod(m_file, change.index);
+        write_pod(m_file, change.value);
+    }
+    m_frame.events.clear();
+    ++m_frameCount;
+}
+
+std::unique_ptr<InputReplayer> InputReplayer::Open(const char* path)
+{
+    FILE* file = fopen(path, "rb");
+    if (file == nullptr)
+    {
+        fprintf(stderr, "Failed to open input log %s\n", path);
+        return nullptr;
+    }
+    char magic[sizeof(kInputLogMagic)];
+    uint32_t eventSize = 0, width = 0, height = 0;
+    if (fread(magic, sizeof(magic), 1, file) != 1 ||
+        memcmp(magic, kInputLogMagic, sizeof(magic)) != 0 ||
+        !read_pod(file, &eventSize) || !read_pod(file, &width) ||
+        !read_pod(file, &height))
+    {
+        fprintf(stderr, "%s is not an input log\n", path);
+        fclose(file);
+        return nullptr;
+    }
+    if (eventSize != sizeof(SDL_Event))
+    {
+        fprintf(stderr,
+                "%s was recorded with a different SDL (event size %u, "
+                "expected %zu)\n",
+                path,
+                eventSize,
+                sizeof(SDL_Event));
+        fclose(file);
+        return nullptr;
+    }
+    return std::unique_ptr<InputReplayer>(
+        new InputReplayer(file, width, height));
+}
+
+InputReplayer::InputReplayer(FILE* file, uint32_t width, uint32_t height) :
+    m_file(file), m_width(width), m_height(height)
+{
+    const long position = ftell(m_file);
+    fseek(m_file, 0, SEEK_END);
+    m_fileSize = static_cast<uint64_t>(std::max(ftell(m_file), 0L));
+    fseek(m_file, position, SEEK_SET);
+}
+
+InputReplayer::~InputReplayer() { fclose(m_file); }
+
+bool InputReplayer::fail()
+{
+    fprintf(stderr, "Input log is truncated or corrupt\n");
+    m_failed = true;
+    return false;
+}
+
+uint64_t InputReplayer::remainingBytes() const
+{
+    const long position = ftell(m_file);
+    return position < 0 || static_cast<uint64_t>(position) > m_fileSize
+               ? 0
+               : m_fileSize - position;
+}
+
+bool InputReplayer::nextFrame()
+{
+    if (m_failed)
+    {
+        return false;
+    }
+    if (remainingBytes() == 0)
+    {
+        return false; // A clean end falls exactly between records.
+    }
+    uint32_t eventCount, changeCount;
+    if (!read_pod(m_file, &m_frame.deltaSeconds) ||
+        !read_pod(m_file, &eventCount) ||
+        uint64_t(eventCount) * sizeof(SDL_Event) > remainingBytes())
+    {
+        return fail();
+    }
+    m_frame.events.resize(eventCount);
+    if (fread(m_frame.events.data(), sizeof(SDL_Event), eventCount, m_file) !=
+            eventCount ||
+        !read_pod(m_file, &changeCount) ||
+        uint64_t(changeCount) * (sizeof(uint16_t) + sizeof(float)) >
+            remainingBytes())
+    {
+        return fail();
+    }
+    m_frame.inputChanges.resize(changeCount);
+    for (InputChange& change : m_frame.inputChanges)
+    {
+        if (!read_pod(m_file, &change.index) || !read_pod(m_file, &change.value))
+        {
+            return fail();
+        }
+    }
+    ++m_frameNumber;
+    return true;
+}
+
+void InputReplayer::syncInputs(Scene* scene)
+{
+    for (const InputChange& change : m_frame.inputChanges)
+    {
+        if (change.index >= m_expectedInputValues.size())
+        {
+            m_expectedInputValues.resize(change.index + 1, NAN);
+        }
+        m_expectedInputValues[change.index] = change.value;
+    }
+    const size_t inputCount =
+        scene ? std::min(scene->inputCount(), m_expectedInputValues.size())
+              : 0;
+    for (size_t i = 0; i < inputCount; ++i)
+    {
+        SMIInput* input = scene->input(i);
+        float value;
+        const float expected = m_expectedInputValues[i];
+        if (std::isnan(expected) || !read_input(input, &value) ||
+            value == expected)
+        {
+            continue;
+        }
+        fprintf(stderr,
+                "replay: frame %u input '%s' is %g, recording had %g\n",
+                m_frameNumber,
+                input->name().c_str(),
+                value,
+                expected);
+        ++m_divergenceCount;
+        write_input(input, expected);
+    }
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <SDL3/SDL_events.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+namespace rive
+{
+class Scene;
+} // namespace rive
+
+// Per-frame logs of everything that drives the app loop: the SDL events
+// handled before the frame, the frame's delta time, and the state-machine
+// inputs whose values changed during it. Replaying one feeds the same
+// events and deltas back, so an interaction sequence renders identically on
+// another machine.
+//
+// Events are stored as raw SDL_Event bytes; logs are only portable between
+// builds with the same SDL_Event layout, which the header records. The header
+// also records the render target size, since pointer positions and layout
+// only replay identically at that size.
+
+// A number or bool input (bools as 0/1). Triggers have no observable value
+// and are not logged.
+struct InputChange
+{
+    uint16_t index;
+    float value;
+};
+
+struct RecordedFrame
+{
+    double deltaSeconds = 0;
+    std::vector<SDL_Event> events;
+    std::vector<InputChange> inputChanges;
+};
+
+class InputRecorder
+{
+public:
+    // `width` and `height` are the render target size in pixels.
+    static std::unique_ptr<InputRecorder> Open(const char* path,
+                                               uint32_t width,
+                                               uint32_t height);
+    ~InputRecorder();
+
+    void recordEvent(const SDL_Event&);
+    // Writes the frame: events since the last call, the delta, and every
+    // input of `scene` (may be null) that changed since the last call.
+    void endFrame(double deltaSeconds, rive::Scene* scene);
+
+private:
+    InputRecorder(FILE*);
+
+    FILE* m_file;
+    RecordedFrame m_frame;
+    std::vector<float> m_lastInputValues;
+    uint32_t m_frameCount = 0;
+};
+
+class InputReplayer
+{
+public:
+    static std::unique_ptr<InputReplayer> Open(const char* path);
+    ~InputReplayer();
+
+    // Loads the next frame. Returns false at the end of the log, or when the
+    // log is truncated or corrupt, which also sets failed().
+    bool nextFrame();
+    bool failed() const { return m_failed; }
+    const RecordedFrame& frame() const { return m_frame; }
+    // Render target size the log was recorded at.
+    uint32_t width() const { return m_width; }
+    uint32_t height() const { return m_height; }
+    uint32_t frameNumber() const { return m_frameNumber; }
+
+    // Call after the scene advanced. Compares every input with the value the
+    // recording had at this frame, reports and counts the ones that
+    // diverged, then sets them to the recorded values.
+    void syncInputs(rive::Scene* scene);
+    uint32_t divergenceCount() const { return m_divergenceCount; }
+
+private:
+    InputReplayer(FILE*, uint32_t width, uint32_t height);
+
+    bool fail();
+    // Bytes left in the log, so counts can be checked before sizing buffers.
+    uint64_t remainingBytes() const;
+
+    FILE* m_file;
+    const uint32_t m_width;
+    const uint32_t m_height;
+    RecordedFrame m_frame;
+    std::vector<float> m_expectedInputValues;
+    uint32_t m_frameNumber = 0;
+    uint32_t m_divergenceCount = 0;
+    uint64_t m_fileSize = 0;
+    bool m_failed = false;
+};
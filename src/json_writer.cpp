@@ -0,0 +1,132 @@
+#include "json_writer.hpp"
+
+#include <cinttypes>
+#include <cmath>
+
+void JSONWriter::beginValue(const char* key)
+{
+    if (!m_hasMembers.empty())
+    {
+        fputs(m_hasMembers.back() ? ",\n" : "\n", m_file);
+        m_hasMembers.back() = true;
+        for (size_t i = 0; i < m_hasMembers.size(); ++i)
+        {
+            fputs("  ", m_file);
+        }
+    }
+    if (key != nullptr)
+    {
+        writeString(key);
+        fputs(": ", m_file);
+    }
+}
+
+void JSONWriter::writeString(const char* value)
+{
+    fputc('"', m_file);
+    for (const char* c = value; *c; ++c)
+    {
+        switch (*c)
+        {
+            case '"':
+                fputs("\\\"", m_file);
+                break;
+            case '\\':
+                fputs("\\\\", m_file);
+                break;
+            case '\n':
+                fputs("\\n", m_file);
+                break;
+            default:
+                if (static_cast<unsigned char>(*c) < 0x20)
+                {
+                    fprintf(m_file, "\\u%04x", *c);
+                }
+                else
+                {
+                    fputc(*c, m_file);
+                }
+        }
+    }
+    fputc('"', m_file);
+}
+
+void JSONWriter::beginObject(const char* key)
+{
+    beginValue(key);
+    fputc('{', m_file);
+    m_hasMembers.push_back(false);
+}
+
+void JSONWriter::endObject()
+{
+    bool hadMembers = m_hasMembers.back();
+    m_hasMembers.pop_back();
+    if (hadMembers)
+    {
+        fputc('\n', m_file);
+        for (size_t i = 0; i < m_hasMembers.size(); ++i)
+        {
+            fputs("  ", m_file);
+        }
+    }
+    fputc('}', m_file);
+    if (m_hasMembers.empty())
+    {
+        fputc('\n', m_file);
+    }
+}
+
+void JSONWriter::beginArray(const char* key)
+{
+    beginValue(key);
+    fputc('[', m_file);
+    m_hasMembers.push_back(false);
+}
+
+void JSONWriter::endArray()
+{
+    bool hadMembers = m_hasMembers.back();
+    m_hasMembers.pop_back();
+    if (hadMembers)
+    {
+        fputc('\n', m_file);
+        for (size_t i = 0; i < m_hasMembers.size(); ++i)
+        {
+            fputs("  ", m_file);
+        }
+    }
+    fputc(']', m_file);
+}
+
+void JSONWriter::number(const char* key, double value)
+{
+    beginValue(key);
+    if (std::isfinite(value))
+    {
+        fprintf(m_file, "%.6g", value);
+    }
+    else
+    {
+        // JSON has no NaN/Infinity.
+        fputs("null", m_file);
+    }
+}
+
+void JSONWriter::integer(const char* key, int64_t value)
+{
+    beginValue(key);
+    fprintf(m_file, "%" PRId64, value);
+}
+
+void JSONWriter::boolean(const char* key, bool value)
+{
+    beginValue(key);
+    fputs(value ? "true" : "false", m_file);
+}
+
+void JSONWriter::string(const char* key, const char* value)
+{
+    beginValue(key);
+    writeString(value);
+}
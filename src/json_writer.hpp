@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+// Minimal streaming JSON writer for bench and telemetry reports. Keys are
+// written as given; values are escaped.
+class JSONWriter
+{
+public:
+    explicit JSONWriter(FILE* file) : m_file(file) {}
+
+    // Opens an object: the root when key is null, else a named member.
+    void beginObject(const char* key = nullptr);
+    void endObject();
+    void beginArray(const char* key);
+    void endArray();
+
+    void number(const char* key, double value);
+    void integer(const char* key, int64_t value);
+    void boolean(const char* key, bool value);
+    void string(const char* key, const char* value);
+    // Array elements (key-less values).
+    void number(double value) { number(nullptr, value); }
+
+private:
+    void beginValue(const char* key);
+    void writeString(const char* value);
+
+    FILE* const m_file;
+    // One entry per open object/array: whether it has members yet.
+    std::vector<bool> m_hasMembers;
+};
@@ -0,0 +1,584 @@
+// Golden-image regression runner.
+//
+// Renders state machines from a manifest at fixed timestamps through a
+// headless FiddleContext, compares each frame against a stored PNG, and
+// reports pixel mismatches alongside per-frame timings so visual and
+// performance regressions show up in the same run.
+//
+// Manifest lines (blank lines and '#' comments are skipped):
+//
+//     <file.riv> <state machine index or name> <t0,t1,...seconds>
+//
+// .riv paths are relative to the manifest. Timestamps must be ascending; the
+// state machine advances cumulatively from 0.
+
+#include "fiddle_context.hpp"
+
+#include "rive/artboard.hpp"
+#include "rive/file.hpp"
+#include "rive/layout.hpp"
+#include "rive/animation/state_machine_instance.hpp"
+
+#include "asset_utils.hpp"
+#include "image_diff.hpp"
+#include "image_io.hpp"
+#include "readback_convert.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace rive;
+
+enum class API
+{
+    gl,
+    metal,
+    vulkan,
+};
+
+struct GoldenCase
+{
+    std::string rivPath;
+    std::string stateMachine;
+    std::vector<double> timestamps;
+};
+
+// Best-of-N timings for one frame, in milliseconds.
+struct FrameTimes
+{
+    double advanceMs = 0;
+    double drawMs = 0;  // Recording draw calls into the renderer.
+    double flushMs = 0; // end(): submit, wait on the GPU and read back.
+    double gpuMs = -1;  // GPU execution; negative without GPU timers.
+
+    double cpuMs() const { return advanceMs + drawMs; }
+    double frameMs() const { return advanceMs + drawMs + flushMs; }
+};
+
+struct Options
+{
+    API api =
+#if defined(__APPLE__)
+        API::metal
+#elif defined(_WIN32)
+        API::vulkan
+#else
+        API::gl
+#endif
+        ;
+    bool forceAtomicMode = false;
+    int msaa = 0;
+    uint32_t width = 512;
+    uint32_t height = 512;
+    std::string manifestPath;
+    std::string goldensDir;
+    std::string reportPath;
+    bool update = false;
+    uint8_t tolerance = 2;
+    uint64_t maxMismatchedPixels = 0;
+    int repeat = 5;
+    // A frame fails as slow when it exceeds its recorded time by this much,
+    // and by at least kSlowFloorMs in absolute terms.
+    double timeTolerancePercent = 25;
+};
+
+constexpr static double kSlowFloorMs = .5;
+constexpr static char kTimingsFileName[] = "timings.csv";
+
+static double elapsed_ms(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(
+               std::chrono::steady_clock::now() - start)
+        .count();
+}
+
+static bool parse_manifest(const std::string& path,
+                           std::vector<GoldenCase>* cases)
+{
+    std::ifstream manifest(path);
+    if (!manifest.is_open())
+    {
+        fprintf(stderr, "Failed to open manifest %s\n", path.c_str());
+        return false;
+    }
+    std::filesystem::path baseDir = std::filesystem::path(path).parent_path();
+    std::string line;
+    for (int lineNumber = 1; std::getline(manifest, line); ++lineNumber)
+    {
+        line = line.substr(0, line.find('#'));
+        std::istringstream fields(line);
+        GoldenCase golden;
+        std::string timestamps;
+        if (!(fields >> golden.rivPath))
+        {
+            continue;
+        }
+        if (!(fields >> golden.stateMachine >> timestamps))
+        {
+            fprintf(stderr,
+                    "%s:%i: expected <file.riv> <state machine> <t0,t1,...>\n",
+                    path.c_str(),
+                    lineNumber);
+            return false;
+        }
+        golden.rivPath = (baseDir / golden.rivPath).string();
+        std::istringstream times(timestamps);
+        std::string time;
+        while (std::getline(times, time, ','))
+        {
+            double seconds = atof(time.c_str());
+            if (!golden.timestamps.empty() &&
+                seconds < golden.timestamps.back())
+            {
+                fprintf(stderr,
+                        "%s:%i: timestamps must be ascending\n",
+                        path.c_str(),
+                        lineNumber);
+                return false;
+            }
+            golden.timestamps.push_back(seconds);
+        }
+        cases->push_back(std::move(golden));
+    }
+    return true;
+}
+
+// name -> frameMs recorded by the last --update run.
+static std::map<std::string, double> load_timings(const std::string& path)
+{
+    std::map<std::string, double> timings;
+    std::ifstream file(path);
+    std::string line;
+    while (std::getline(file, line))
+    {
+        size_t comma = line.find(',');
+        if (comma != std::string::npos)
+        {
+            timings[line.substr(0, comma)] = atof(line.c_str() + comma + 1);
+        }
+    }
+    return timings;
+}
+
+static std::unique_ptr<StateMachineInstance> make_state_machine(
+    Artboard* artboard,
+    const std::string& nameOrIndex)
+{
+    char* end;
+    long index = strtol(nameOrIndex.c_str(), &end, 10);
+    if (*end == '\0')
+    {
+        return index >= 0 && static_cast<size_t>(index) <
+                                 artboard->stateMachineCount()
+                   ? artboard->stateMachineAt(index)
+                   : nullptr;
+    }
+    return artboard->stateMachineNamed(nameOrIndex);
+}
+
+static std::unique_ptr<FiddleContext> make_fiddle_context(const Options& opts)
+{
+    FiddleContextOptions options;
+    options.allowHeadlessRendering = true;
+    options.enableReadPixels = true;
+    // Frames must not depend on when background shader compiles finish.
+    options.synchronousShaderCompilations = true;
+    switch (opts.api)
+    {
+        case API::gl:
+            return FiddleContext::MakeGLPLS(options);
+        case API::metal:
+            return FiddleContext::MakeMetalPLS(options);
+        case API::vulkan:
+            return FiddleContext::MakeVulkanPLS(options);
+    }
+    return nullptr;
+}
+
+static void print_usage()
+{
+    fprintf(stderr,
+            "usage: lp_goldens --manifest FILE --goldens DIR [--update]\n"
+            "                  [--gl|--metal|--vk] [--atomic] [--msaaN]\n"
+            "                  [--size WxH] [--tolerance N] "
+            "[--max-mismatch PIXELS]\n"
+            "                  [--repeat N] [--time-tolerance PERCENT]\n"
+            "                  [--report FILE.csv]\n");
+}
+
+static bool parse_args(int argc, char* argv[], Options* opts)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const bool hasValue = i + 1 < argc;
+        if (!strcmp(argv[i], "--manifest") && hasValue)
+        {
+            opts->manifestPath = argv[++i];
+        }
+        else if (!strcmp(argv[i], "--goldens") && hasValue)
+        {
+            opts->goldensDir = argv[++i];
+        }
+        else if (!strcmp(argv[i], "--report") && hasValue)
+        {
+            opts->reportPath = argv[++i];
+        }
+        else if (!strcmp(argv[i], "--update"))
+        {
+            opts->update = true;
+        }
+        else if (!strcmp(argv[i], "--gl"))
+        {
+            opts->api = API::gl;
+        }
+        else if (!strcmp(argv[i], "--metal"))
+        {
+            opts->api = API::metal;
+        }
+        else if (!strcmp(argv[i], "--vulkan") || !strcmp(argv[i], "--vk"))
+        {
+            opts->api = API::vulkan;
+        }
+        else if (!strcmp(argv[i], "--atomic"))
+        {
+            opts->forceAtomicMode = true;
+        }
+        else if (!strncmp(argv[i], "--msaa", 6))
+        {
+            opts->msaa = argv[i][6] - '0';
+        }
+        else if (!strcmp(argv[i], "--size") && hasValue)
+        {
+            if (sscanf(argv[++i], "%ux%u", &opts->width, &opts->height) != 2 ||
+                opts->width == 0 || opts->height == 0)
+            {
+                return false;
+            }
+        }
+        else if (!strcmp(argv[i], "--tolerance") && hasValue)
+        {
+            opts->tolerance =
+                static_cast<uint8_t>(std::clamp(atoi(argv[++i]), 0, 255));
+        }
+        else if (!strcmp(argv[i], "--max-mismatch") && hasValue)
+        {
+            opts->maxMismatchedPixels = strtoull(argv[++i], nullptr, 10);
+        }
+        else if (!strcmp(argv[i], "--repeat") && hasValue)
+        {
+            opts->repeat = std::max(1, atoi(argv[++i]));
+        }
+        else if (!strcmp(argv[i], "--time-tolerance") && hasValue)
+        {
+            opts->timeTolerancePercent = atof(argv[++i]);
+        }
+        else
+        {
+            fprintf(stderr, "unknown argument %s\n", argv[i]);
+            return false;
+        }
+    }
+    return !opts->manifestPath.empty() && !opts->goldensDir.empty();
+}
+
+int main(int argc, char* argv[])
+{
+    setvbuf(stdout, NULL, _IONBF, 0);
+
+    Options opts;
+    if (!parse_args(argc, argv, &opts))
+    {
+        print_usage();
+        return 2;
+    }
+    std::vector<GoldenCase> cases;
+    if (!parse_manifest(opts.manifestPath, &cases))
+    {
+        return 2;
+    }
+    std::error_code ec;
+    std::filesystem::create_directories(opts.goldensDir, ec);
+    const std::string timingsPath =
+        (std::filesystem::path(opts.goldensDir) / kTimingsFileName).string();
+    const std::map<std::string, double> baselineTimings =
+        opts.update ? std::map<std::string, double>{}
+                    : load_timings(timingsPath);
+
+    std::unique_ptr<FiddleContext> fiddleContext = make_fiddle_context(opts);
+    if (!fiddleContext)
+    {
+        fprintf(stderr, "Failed to create a headless fiddle context.\n");
+        return 2;
+    }
+    fiddleContext->onSizeChanged(nullptr, opts.width, opts.height, opts.msaa);
+    std::unique_ptr<Renderer> renderer =
+        fiddleContext->makeRenderer(opts.width, opts.height);
+
+    printf("lp_goldens: %zu files at %ux%u, diff kernel %s\n",
+           cases.size(),
+           opts.width,
+           opts.height,
+           image_diff_kernel_name());
+
+    FILE* report = nullptr;
+    if (!opts.reportPath.empty())
+    {
+        report = fopen(opts.reportPath.c_str(), "w");
+        if (report == nullptr)
+        {
+            fprintf(stderr, "Failed to open %s\n", opts.reportPath.c_str());
+            return 2;
+        }
+        fprintf(report,
+                "name,status,mismatched_pixels,max_channel_delta,advance_ms,"
+                "draw_ms,flush_ms,gpu_ms,frame_ms,baseline_frame_ms\n");
+    }
+    std::ostringstream newTimings;
+
+    const size_t rowBytes = static_cast<size_t>(opts.width) * 4;
+    std::vector<uint8_t> readback;
+    std::vector<uint8_t> actual(rowBytes * opts.height);
+    std::vector<uint8_t> expected;
+    int frameCount = 0, failedCount = 0, slowCount = 0;
+
+    for (const GoldenCase& golden : cases)
+    {
+        std::unique_ptr<MappedFile> rivBytes =
+            MappedFile::Open(golden.rivPath, MappedFile::Access::sequential);
+        std::unique_ptr<File> file =
+            rivBytes ? File::import(rivBytes->bytes(), fiddleContext->factory())
+                     : nullptr;
+        std::unique_ptr<ArtboardInstance> artboard =
+            file ? file->artboardDefault() : nullptr;
+        std::unique_ptr<StateMachineInstance> scene =
+            artboard ? make_state_machine(artboard.get(), golden.stateMachine)
+                     : nullptr;
+        if (!scene)
+        {
+            fprintf(stderr,
+                    "FAIL %s: could not load state machine %s\n",
+                    golden.rivPath.c_str(),
+                    golden.stateMachine.c_str());
+            failedCount += static_cast<int>(golden.timestamps.size());
+            continue;
+        }
+        int viewModelId = artboard->viewModelId();
+        rcp<ViewModelInstance> viewModelInstance =
+            viewModelId == -1
+                ? file->createViewModelInstance(artboard.get())
+                : file->createViewModelInstance(viewModelId, 0);
+        artboard->bindViewModelInstance(viewModelInstance);
+        if (viewModelInstance != nullptr)
+        {
+            scene->bindViewModelInstance(viewModelInstance);
+        }
+        const Mat2D alignment = computeAlignment(
+            Fit::contain,
+            Alignment::center,
+            AABB(0, 0, static_cast<float>(opts.width),
+                 static_cast<float>(opts.height)),
+            artboard->bounds());
+
+        const std::string stem =
+            std::filesystem::path(golden.rivPath).stem().string();
+        double sceneTime = 0;
+        for (double timestamp : golden.timestamps)
+        {
+            char name[256];
+            snprintf(name,
+                     sizeof(name),
+                     "%s.%s.%06.0fms",
+                     stem.c_str(),
+                     golden.stateMachine.c_str(),
+                     timestamp * 1000);
+            const std::string goldenPath =
+                (std::filesystem::path(opts.goldensDir) / (std::string(name) +
+                                                           ".png"))
+                    .string();
+
+            FrameTimes times;
+            auto start = std::chrono::steady_clock::now();
+            scene->advanceAndApply(static_cast<float>(timestamp - sceneTime));
+            times.advanceMs = elapsed_ms(start);
+            sceneTime = timestamp;
+
+            // Redraw the same frame and keep the fastest of each phase, which
+            // is far more stable run to run than a single sample.
+            for (int i = 0; i < opts.repeat; ++i)
+            {
+                fiddleContext->begin({
+                    .renderTargetWidth = opts.width,
+                    .renderTargetHeight = opts.height,
+                    .clearColor = 0xff303030,
+                    .msaaSampleCount = opts.msaa,
+                    .disableRasterOrdering = opts.forceAtomicMode,
+                });
+                start = std::chrono::steady_clock::now();
+                renderer->save();
+                renderer->transform(alignment);
+                scene->draw(renderer.get());
+                renderer->restore();
+                double drawMs = elapsed_ms(start);
+
+                start = std::chrono::steady_clock::now();
+                fiddleContext->end(nullptr, &readback);
+                double flushMs = elapsed_ms(start);
+
+                times.drawMs = i == 0 ? drawMs : std::min(times.drawMs, drawMs);
+                times.flushMs =
+                    i == 0 ? flushMs : std::min(times.flushMs, flushMs);
+
+                // end() waited for the frame, so its timer is done; resolve
+                // it now rather than a few frames later.
+                fiddleContext->finishGPUTimers();
+                GPUFrameTime gpuTime;
+                while (fiddleContext->pollGPUFrameTime(&gpuTime))
+                {
+                    times.gpuMs = times.gpuMs < 0
+                                      ? gpuTime.ms
+                                      : std::min(times.gpuMs, gpuTime.ms);
+                }
+            }
+            ++frameCount;
+
+            // Goldens are stored upright with straight alpha, like --export.
+            convert_readback(actual.data(),
+                             rowBytes,
+                             readback.data(),
+                             rowBytes,
+                             opts.width,
+                             opts.height,
+                             kReadbackFlipY | kReadbackUnpremultiply);
+
+            const char* status = "pass";
+            ImageDiff diff;
+            uint32_t expectedWidth = 0, expectedHeight = 0;
+            auto baseline = baselineTimings.find(name);
+            const double baselineMs =
+                baseline != baselineTimings.end() ? baseline->second : 0;
+            if (opts.update)
+            {
+                status = write_png(goldenPath.c_str(),
+                                   opts.width,
+                                   opts.height,
+                                   actual.data(),
+                                   rowBytes)
+                             ? "updated"
+                             : "error";
+            }
+            else if (!read_png(goldenPath.c_str(),
+                               &expectedWidth,
+                               &expectedHeight,
+                               &expected))
+            {
+                status = "missing";
+            }
+            else if (expectedWidth != opts.width ||
+                     expectedHeight != opts.height)
+            {
+                status = "size";
+            }
+            else
+            {
+                diff = diff_images(actual.data(),
+                                   rowBytes,
+                                   expected.data(),
+                                   rowBytes,
+                                   opts.width,
+                                   opts.height,
+                                   opts.tolerance);
+                if (diff.mismatchedPixels > opts.maxMismatchedPixels)
+                {
+                    status = "mismatch";
+                }
+                else if (baselineMs > 0 &&
+                         times.frameMs() >
+                             baselineMs *
+                                 (1 + opts.timeTolerancePercent / 100) &&
+                         times.frameMs() - baselineMs > kSlowFloorMs)
+                {
+                    status = "slow";
+                }
+            }
+
+            if (!strcmp(status, "slow"))
+            {
+                ++slowCount;
+            }
+            else if (strcmp(status, "pass") && strcmp(status, "updated"))
+            {
+                ++failedCount;
+                if (!strcmp(status, "mismatch") || !strcmp(status, "size"))
+                {
+                    // Keep the rendered frame next to the golden for review.
+                    std::string actualPath = goldenPath;
+                    actualPath.replace(actualPath.size() - 4, 4, ".actual.png");
+                    write_png(actualPath.c_str(),
+                              opts.width,
+                              opts.height,
+                              actual.data(),
+                              rowBytes);
+                }
+            }
+
+            printf("%-8s %-48s %8llu px  max %3u  cpu %7.3fms  flush %7.3fms",
+                   status,
+                   name,
+                   static_cast<unsigned long long>(diff.mismatchedPixels),
+                   diff.maxChannelDelta,
+                   times.cpuMs(),
+                   times.flushMs);
+            if (times.gpuMs >= 0)
+            {
+                printf("  gpu %7.3fms", times.gpuMs);
+            }
+            if (baselineMs > 0)
+            {
+                printf("  (was %.3fms)", baselineMs);
+            }
+            printf("\n");
+            if (report != nullptr)
+            {
+                // gpu_ms is left empty when the backend has no GPU timers.
+                char gpuMs[32] = "";
+                if (times.gpuMs >= 0)
+                {
+                    snprintf(gpuMs, sizeof(gpuMs), "%.4f", times.gpuMs);
+                }
+                fprintf(report,
+                        "%s,%s,%llu,%u,%.4f,%.4f,%.4f,%s,%.4f,%.4f\n",
+                        name,
+                        status,
+                        static_cast<unsigned long long>(diff.mismatchedPixels),
+                        diff.maxChannelDelta,
+                        times.advanceMs,
+                        times.drawMs,
+                        times.flushMs,
+                        gpuMs,
+                        times.frameMs(),
+                        baselineMs);
+            }
+            newTimings << name << ',' << times.frameMs() << '\n';
+        }
+    }
+
+    if (report != nullptr)
+    {
+        fclose(report);
+    }
+    if (opts.update)
+    {
+        std::ofstream(timingsPath) << newTimings.str();
+    }
+    printf("%i frames, %i failed, %i slow\n", frameCount, failedCount, slowCount);
+    return failedCount + slowCount == 0 ? 0 : 1;
+}
@@ -0,0 +1,329 @@
+// Microbenchmarks for each stage renderFrame() and make_scenes() chain
+// together, run over a corpus of .riv files:
+//
+//     import     File::import of the file's bytes (and its release)
+//     instance   artboardDefault() (and its release)
+//     sm         stateMachineAt(0) (and its release)
+//     bindVM     bindViewModelInstance on the artboard and scene
+//     advance    advanceAndApply(1/60)
+//     draw       Scene::draw into the null backend's counting renderer
+//
+// Every stage reports ns/op and allocations/op, so a frame-time regression
+// can be pinned to the stage that caused it. Allocations are counted by the
+// alloc_tracker operator new hook; C allocations (e.g. inside image
+// decoders) are not seen.
+
+#include "alloc_tracker.hpp"
+#include "fiddle_context.hpp"
+
+#include "rive/artboard.hpp"
+#include "rive/file.hpp"
+#include "rive/layout.hpp"
+#include "rive/animation/state_machine_instance.hpp"
+#include "rive/viewmodel/viewmodel_instance.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+using namespace rive;
+
+struct BenchResult
+{
+    uint64_t iterations = 0;
+    double nsPerOp = 0;
+    double allocsPerOp = 0;
+    double bytesPerOp = 0;
+};
+
+// Runs `op` in doubling batches until one batch takes at least minSeconds,
+// and reports that batch.
+template <typename Op> static BenchResult measure(double minSeconds, Op&& op)
+{
+    BenchResult result;
+    for (uint64_t n = 1;; n *= 2)
+    {
+        const AllocCounts allocsBefore = alloc_counts();
+        auto start = std::chrono::steady_clock::now();
+        for (uint64_t i = 0; i < n; ++i)
+        {
+            op();
+        }
+        const double seconds = std::chrono::duration<double>(
+                                   std::chrono::steady_clock::now() - start)
+                                   .count();
+        const AllocCounts allocs = alloc_counts() - allocsBefore;
+        if (seconds >= minSeconds || n >= (uint64_t(1) << 30))
+        {
+            result.iterations = n;
+            result.nsPerOp = seconds * 1e9 / n;
+            result.allocsPerOp = static_cast<double>(allocs.totalAllocs()) / n;
+            result.bytesPerOp = static_cast<double>(allocs.totalBytes()) / n;
+            return result;
+        }
+    }
+}
+
+struct Options
+{
+    std::vector<std::string> rivPaths;
+    std::string filter;
+    std::string csvPath;
+    double minSeconds = .25;
+};
+
+class Reporter
+{
+public:
+    explicit Reporter(FILE* csv) : m_csv(csv)
+    {
+        printf("%-32s %-10s %12s %14s %12s %12s\n",
+               "file",
+               "bench",
+               "iterations",
+               "ns/op",
+               "allocs/op",
+               "bytes/op");
+        if (m_csv != nullptr)
+        {
+            fprintf(m_csv,
+                    "file,bench,iterations,ns_per_op,allocs_per_op,"
+                    "bytes_per_op\n");
+        }
+    }
+
+    void report(const std::string& file,
+                const char* bench,
+                const BenchResult& result)
+    {
+        printf("%-32s %-10s %12llu %14.1f %12.2f %12.0f\n",
+               file.c_str(),
+               bench,
+               static_cast<unsigned long long>(result.iterations),
+               result.nsPerOp,
+               result.allocsPerOp,
+               result.bytesPerOp);
+        if (m_csv != nullptr)
+        {
+            fprintf(m_csv,
+                    "%s,%s,%llu,%.1f,%.3f,%.1f\n",
+                    file.c_str(),
+                    bench,
+                    static_cast<unsigned long long>(result.iterations),
+                    result.nsPerOp,
+                    result.allocsPerOp,
+                    result.bytesPerOp);
+        }
+    }
+
+private:
+    FILE* const m_csv;
+};
+
+static bool read_file(const std::string& path, std::vector<uint8_t>* bytes)
+{
+    std::ifstream stream(path, std::ios::binary);
+    if (!stream.is_open())
+    {
+        return false;
+    }
+    bytes->assign(std::istreambuf_iterator<char>(stream), {});
+    return true;
+}
+
+static void bench_file(const std::string& path,
+                       const Options& options,
+                       FiddleContext* fiddleContext,
+                       Reporter* reporter)
+{
+    const std::string name = std::filesystem::path(path).filename().string();
+    auto enabled = [&](const char* bench) {
+        return options.filter.empty() ||
+               strstr(bench, options.filter.c_str()) != nullptr;
+    };
+
+    std::vector<uint8_t> bytes;
+    if (!read_file(path, &bytes))
+    {
+        fprintf(stderr, "%s: failed to read\n", path.c_str());
+        return;
+    }
+    Factory* factory = fiddleContext->factory();
+    auto file = File::import(bytes, factory);
+    if (!file)
+    {
+        fprintf(stderr, "%s: failed to import\n", path.c_str());
+        return;
+    }
+
+    if (enabled("import"))
+    {
+        reporter->report(name, "import", measure(options.minSeconds, [&]() {
+                             auto imported = File::import(bytes, factory);
+                         }));
+    }
+    if (enabled("instance"))
+    {
+        reporter->report(name, "instance", measure(options.minSeconds, [&]() {
+                             auto artboard = file->artboardDefault();
+                         }));
+    }
+
+    auto artboard = file->artboardDefault();
+    if (!artboard)
+    {
+        fprintf(stderr, "%s: no default artboard\n", path.c_str());
+        return;
+    }
+    if (artboard->stateMachineCount() == 0)
+    {
+        fprintf(stderr,
+                "%s: no state machines; skipping the rest\n",
+                name.c_str());
+        return;
+    }
+    if (enabled("sm"))
+    {
+        reporter->report(name, "sm", measure(options.minSeconds, [&]() {
+                             auto scene = artboard->stateMachineAt(0);
+                         }));
+    }
+
+    std::unique_ptr<Scene> scene = artboard->stateMachineAt(0);
+    // Bound the way make_scenes() binds it.
+    int viewModelId = artboard->viewModelId();
+    rcp<ViewModelInstance> viewModelInstance =
+        viewModelId == -1 ? file->createViewModelInstance(artboard.get())
+                          : file->createViewModelInstance(viewModelId, 0);
+    if (viewModelInstance != nullptr && enabled("bindVM"))
+    {
+        reporter->report(name, "bindVM", measure(options.minSeconds, [&]() {
+                             artboard->bindViewModelInstance(viewModelInstance);
+                             scene->bindViewModelInstance(viewModelInstance);
+                         }));
+    }
+    artboard->bindViewModelInstance(viewModelInstance);
+    if (viewModelInstance != nullptr)
+    {
+        scene->bindViewModelInstance(viewModelInstance);
+    }
+
+    if (enabled("advance"))
+    {
+        reporter->report(name, "advance", measure(options.minSeconds, [&]() {
+                             scene->advanceAndApply(1.f / 60);
+                         }));
+    }
+    if (enabled("draw"))
+    {
+        const AABB bounds = artboard->bounds();
+        std::unique_ptr<Renderer> renderer =
+            fiddleContext->makeRenderer(static_cast<int>(bounds.width()),
+                                        static_cast<int>(bounds.height()));
+        const Mat2D m = computeAlignment(Fit::contain,
+                                         Alignment::center,
+                                         bounds,
+                                         bounds);
+        reporter->report(name, "draw", measure(options.minSeconds, [&]() {
+                             renderer->save();
+                             renderer->transform(m);
+                             scene->draw(renderer.get());
+                             renderer->restore();
+                         }));
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    setvbuf(stdout, NULL, _IONBF, 0);
+
+    Options options;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (!strcmp(argv[i], "--filter") && i + 1 < argc)
+        {
+            options.filter = argv[++i];
+        }
+        else if (!strcmp(argv[i], "--min-time") && i + 1 < argc)
+        {
+            options.minSeconds = atof(argv[++i]);
+        }
+        else if (!strcmp(argv[i], "--csv") && i + 1 < argc)
+        {
+            options.csvPath = argv[++i];
+        }
+        else if (argv[i][0] != '-')
+        {
+            std::error_code ec;
+            if (std::filesystem::is_directory(argv[i], ec))
+            {
+                std::vector<std::string> found;
+                for (const auto& entry :
+                     std::filesystem::directory_iterator(argv[i], ec))
+                {
+                    if (entry.path().extension() == ".riv")
+                    {
+                        found.push_back(entry.path().string());
+                    }
+                }
+                std::sort(found.begin(), found.end());
+                options.rivPaths.insert(options.rivPaths.end(),
+                                        found.begin(),
+                                        found.end());
+            }
+            else
+            {
+                options.rivPaths.push_back(argv[i]);
+            }
+        }
+        else
+        {
+            fprintf(stderr, "unknown argument %s\n", argv[i]);
+            options.rivPaths.clear();
+            break;
+        }
+    }
+    if (options.rivPaths.empty())
+    {
+        fprintf(stderr,
+                "usage: lp_microbench FILE.riv|DIR... [--filter BENCH] "
+                "[--min-time SECONDS] [--csv PATH]\n"
+                "benches: import instance sm bindVM advance draw\n");
+        return 2;
+    }
+
+    FILE* csv = nullptr;
+    if (!options.csvPath.empty())
+    {
+        csv = fopen(options.csvPath.c_str(), "w");
+        if (csv == nullptr)
+        {
+            fprintf(stderr,
+                    "Failed to open %s for writing\n",
+                    options.csvPath.c_str());
+            return 1;
+        }
+    }
+
+    // The null backend's factory builds the same CPU-side paths as the GPU
+    // backends, and its renderer counts draws without rasterizing.
+    std::unique_ptr<FiddleContext> fiddleContext = FiddleContext::MakeNull();
+    alloc_tracking_enable();
+    Reporter reporter(csv);
+    for (const std::string& path : options.rivPaths)
+    {
+        bench_file(path, options, fiddleContext.get(), &reporter);
+    }
+    if (csv != nullptr)
+    {
+        fclose(csv);
+    }
+    return 0;
+}
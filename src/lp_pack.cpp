@@ -0,0 +1,246 @@
+// Packs a directory of assets into one bundle (see asset_bundle.hpp), or
+// lists and verifies an existing one.
+//
+//   lp_pack OUT.lpb DIR [--level N]
+//   lp_pack --verify BUNDLE.lpb [--threads N]
+
+#include "asset_bundle.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <zlib.h>
+
+static double elapsed_ms(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(
+               std::chrono::steady_clock::now() - start)
+        .count();
+}
+
+struct PackedFile
+{
+    std::string name;
+    BundleEntry entry;
+    std::vector<uint8_t> stored;
+};
+
+static bool read_file(const std::filesystem::path& path,
+                      std::vector<uint8_t>* bytes)
+{
+    std::ifstream stream(path, std::ios::binary);
+    if (!stream)
+    {
+        return false;
+    }
+    bytes->assign(std::istreambuf_iterator<char>(stream),
+                  std::istreambuf_iterator<char>());
+    return !stream.bad();
+}
+
+static int pack(const char* outPath, const char* dir, int level)
+{
+    auto start = std::chrono::steady_clock::now();
+    std::vector<PackedFile> files;
+    std::error_code error;
+    for (auto it = std::filesystem::recursive_directory_iterator(dir, error);
+         !error && it != std::filesystem::recursive_directory_iterator();
+         it.increment(error))
+    {
+        if (!it->is_regular_file())
+        {
+            continue;
+        }
+        PackedFile file;
+        file.name =
+            std::filesystem::relative(it->path(), dir).generic_string();
+        if (file.name.size() > UINT16_MAX)
+        {
+            fprintf(stderr, "%s: name too long\n", file.name.c_str());
+            return 1;
+        }
+        std::vector<uint8_t> bytes;
+        if (!read_file(it->path(), &bytes))
+        {
+            fprintf(stderr, "Failed to read %s\n", it->path().string().c_str());
+            return 1;
+        }
+        file.entry = {};
+        file.entry.nameHash = bundle_hash(file.name.data(), file.name.size());
+        file.entry.contentHash = bundle_hash(bytes.data(), bytes.size());
+        file.entry.size = bytes.size();
+        file.entry.nameLength = static_cast<uint16_t>(file.name.size());
+
+        uLongf compressedSize = compressBound(static_cast<uLong>(bytes.size()));
+        file.stored.resize(compressedSize);
+        if (level > 0 &&
+            compress2(file.stored.data(),
+                      &compressedSize,
+                      bytes.data(),
+                      static_cast<uLong>(bytes.size()),
+                      level) == Z_OK &&
+            compressedSize < bytes.size())
+        {
+            file.stored.resize(compressedSize);
+            file.entry.compression = kBundleZlib;
+        }
+        else
+        {
+            // Already compressed (PNG, WebP, fonts) or too small to gain:
+            // store it so loading is a plain view into the mapping.
+            file.stored = std::move(bytes);
+            file.entry.compression = kBundleStored;
+        }
+        file.entry.storedSize = file.stored.size();
+        files.push_back(std::move(file));
+    }
+    if (error)
+    {
+        fprintf(stderr, "Failed to scan %s: %s\n", dir, error.message().c_str());
+        return 1;
+    }
+    std::sort(files.begin(),
+              files.end(),
+              [](const PackedFile& a, const PackedFile& b) {
+                  return a.entry.nameHash < b.entry.nameHash;
+              });
+
+    BundleHeader header = {};
+    memcpy(header.magic, kBundleMagic, sizeof(kBundleMagic));
+    header.version = kBundleVersion;
+    header.entryCount = static_cast<uint32_t>(files.size());
+    uint64_t offset = sizeof(header) + files.size() * sizeof(BundleEntry);
+    uint32_t nameOffset = 0;
+    for (PackedFile& file : files)
+    {
+        file.entry.nameOffset = nameOffset;
+        nameOffset += file.entry.nameLength;
+    }
+    offset += nameOffset;
+    for (PackedFile& file : files)
+    {
+        // 16-byte aligned, so decoders reading the stored bytes in place get
+        // aligned pointers.
+        offset = (offset + 15) & ~uint64_t(15);
+        file.entry.dataOffset = offset;
+        offset += file.entry.storedSize;
+    }
+
+    FILE* out = fopen(outPath, "wb");
+    if (out == nullptr)
+    {
+        fprintf(stderr, "Failed to open %s for writing\n", outPath);
+        return 1;
+    }
+    fwrite(&header, sizeof(header), 1, out);
+    for (const PackedFile& file : files)
+    {
+        fwrite(&file.entry, sizeof(file.entry), 1, out);
+    }
+    for (const PackedFile& file : files)
+    {
+        fwrite(file.name.data(), 1, file.name.size(), out);
+    }
+    uint64_t inputBytes = 0;
+    for (const PackedFile& file : files)
+    {
+        static const uint8_t padding[16] = {};
+        const long position = ftell(out);
+        fwrite(padding, 1, file.entry.dataOffset - position, out);
+        if (!file.stored.empty())
+        {
+            fwrite(file.stored.data(), 1, file.stored.size(), out);
+        }
+        inputBytes += file.entry.size;
+    }
+    if (fclose(out) != 0)
+    {
+        fprintf(stderr, "Failed to write %s\n", outPath);
+        return 1;
+    }
+    printf("Packed %zu files, %.2f MB -> %.2f MB, into %s in %.1f ms\n",
+           files.size(),
+           inputBytes / (1024.0 * 1024.0),
+           offset / (1024.0 * 1024.0),
+           outPath,
+           elapsed_ms(start));
+    return 0;
+}
+
+static int verify(const char* path, int threadCount)
+{
+    auto start = std::chrono::steady_clock::now();
+    std::unique_ptr<AssetBundle> bundle = AssetBundle::Open(path);
+    if (!bundle)
+    {
+        return 1;
+    }
+    const double openMs = elapsed_ms(start);
+    std::vector<const BundleEntry*> entries;
+    for (size_t i = 0; i < bundle->entryCount(); ++i)
+    {
+        const BundleEntry& entry = bundle->entry(i);
+        printf("  %-40.*s %10llu -> %10llu bytes%s\n",
+               static_cast<int>(entry.nameLength),
+               bundle->name(entry).data(),
+               static_cast<unsigned long long>(entry.size),
+               static_cast<unsigned long long>(entry.storedSize),
+               entry.compression == kBundleZlib ? " (zlib)" : "");
+        entries.push_back(&entry);
+    }
+    start = std::chrono::steady_clock::now();
+    std::vector<BundleAsset> assets;
+    const bool ok = bundle->loadAll(entries, &assets, threadCount, true);
+    printf("%s: %zu entries, open %.2f ms, load and verify %.2f ms\n",
+           ok ? "OK" : "FAILED",
+           entries.size(),
+           openMs,
+           elapsed_ms(start));
+    return ok ? 0 : 1;
+}
+
+int main(int argc, char* argv[])
+{
+    const char* paths[2] = {};
+    int pathCount = 0;
+    bool verifyMode = false;
+    int level = Z_BEST_COMPRESSION;
+    int threadCount = 0;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (!strcmp(argv[i], "--verify"))
+        {
+            verifyMode = true;
+        }
+        else if (!strcmp(argv[i], "--level") && i + 1 < argc)
+        {
+            level = std::clamp(atoi(argv[++i]), 0, 9);
+        }
+        else if (!strcmp(argv[i], "--threads") && i + 1 < argc)
+        {
+            threadCount = atoi(argv[++i]);
+        }
+        else if (pathCount < 2)
+        {
+            paths[pathCount++] = argv[i];
+        }
+    }
+    if (verifyMode && pathCount == 1)
+    {
+        return verify(paths[0], threadCount);
+    }
+    if (!verifyMode && pathCount == 2)
+    {
+        return pack(paths[0], paths[1], level);
+    }
+    fprintf(stderr,
+            "usage: lp_pack OUT.lpb DIR [--level N]\n"
+            "       lp_pack --verify BUNDLE.lpb [--threads N]\n");
+    return 1;
+}
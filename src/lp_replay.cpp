@@ -0,0 +1,242 @@
+// Replays a draw-command trace (path_fiddle --record-trace) against a
+// headless FiddleContext in a tight loop. No .riv, no runtime: only the
+// renderer and the backend are measured.
+
+#include "fiddle_context.hpp"
+
+#include "render_trace.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+using namespace rive;
+
+enum class API
+{
+    gl,
+    metal,
+    vulkan,
+    null,
+};
+
+static double elapsed_ms(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(
+               std::chrono::steady_clock::now() - start)
+        .count();
+}
+
+int main(int argc, char* argv[])
+{
+    setvbuf(stdout, NULL, _IONBF, 0);
+
+    API api =
+#if defined(__APPLE__)
+        API::metal
+#elif defined(_WIN32)
+        API::vulkan
+#else
+        API::gl
+#endif
+        ;
+    const char* tracePath = nullptr;
+    int loops = 10;
+    uint32_t width = 0, height = 0;
+    int msaa = 0;
+    bool forceAtomicMode = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (!strcmp(argv[i], "--gl"))
+        {
+            api = API::gl;
+        }
+        else if (!strcmp(argv[i], "--metal"))
+        {
+            api = API::metal;
+        }
+        else if (!strcmp(argv[i], "--vulkan") || !strcmp(argv[i], "--vk"))
+        {
+            api = API::vulkan;
+        }
+        else if (!strcmp(argv[i], "--null"))
+        {
+            api = API::null;
+        }
+        else if (!strcmp(argv[i], "--atomic"))
+        {
+            forceAtomicMode = true;
+        }
+        else if (!strncmp(argv[i], "--msaa", 6))
+        {
+            msaa = argv[i][6] - '0';
+        }
+        else if (!strcmp(argv[i], "--loops") && i + 1 < argc)
+        {
+            loops = std::max(1, atoi(argv[++i]));
+        }
+        else if (!strcmp(argv[i], "--size") && i + 1 < argc)
+        {
+            sscanf(argv[++i], "%ux%u", &width, &height);
+        }
+        else if (argv[i][0] != '-' && tracePath == nullptr)
+        {
+            tracePath = argv[i];
+        }
+        else
+        {
+            fprintf(stderr, "unknown argument %s\n", argv[i]);
+            tracePath = nullptr;
+            break;
+        }
+    }
+    if (tracePath == nullptr)
+    {
+        fprintf(stderr,
+                "usage: lp_replay TRACE [--gl|--metal|--vk|--null] "
+                "[--loops N] [--size WxH] [--atomic] [--msaaN]\n");
+        return 2;
+    }
+
+    std::unique_ptr<RenderTracePlayer> player =
+        RenderTracePlayer::Load(tracePath);
+    if (!player)
+    {
+        return 1;
+    }
+    if (width == 0 || height == 0)
+    {
+        width = player->width();
+        height = player->height();
+    }
+
+    FiddleContextOptions options;
+    options.allowHeadlessRendering = true;
+    options.synchronousShaderCompilations = true;
+    std::unique_ptr<FiddleContext> fiddleContext;
+    switch (api)
+    {
+        case API::gl:
+            fiddleContext = FiddleContext::MakeGLPLS(options);
+            break;
+        case API::metal:
+            fiddleContext = FiddleContext::MakeMetalPLS(options);
+            break;
+        case API::vulkan:
+            fiddleContext = FiddleContext::MakeVulkanPLS(options);
+            break;
+        case API::null:
+            fiddleContext = FiddleContext::MakeNull();
+            break;
+    }
+    if (!fiddleContext)
+    {
+        fprintf(stderr, "Failed to create a headless fiddle context.\n");
+        return 1;
+    }
+    fiddleContext->onSizeChanged(nullptr, width, height, msaa);
+    std::unique_ptr<Renderer> renderer =
+        fiddleContext->makeRenderer(width, height);
+
+    printf("Replaying %u frames from %s at %ux%u, %i loops\n",
+           player->frameCount(),
+           tracePath,
+           width,
+           height,
+           loops);
+
+    // The first loop creates every object and compiles shaders; report it
+    // separately from the steady state.
+    double recordMs = 0, flushMs = 0;
+    double fastestLoopMs = 0, slowestLoopMs = 0;
+    int frames = 0;
+    // Per end() call: whether it was a measured frame. GPU times resolve a
+    // few frames late and are matched back by frame number.
+    std::vector<bool> measuredFrames;
+    double gpuMs = 0;
+    int gpuFrames = 0;
+    auto pollGPUTimes = [&]() {
+        GPUFrameTime gpuTime;
+        while (fiddleContext->pollGPUFrameTime(&gpuTime))
+        {
+            if (measuredFrames[gpuTime.frameNumber])
+            {
+                gpuMs += gpuTime.ms;
+                ++gpuFrames;
+            }
+        }
+    };
+    for (int loop = 0; loop <= loops; ++loop)
+    {
+        player->rewind();
+        auto loopStart = std::chrono::steady_clock::now();
+        int loopFrames = 0;
+        for (;;)
+        {
+            fiddleContext->begin({
+                .renderTargetWidth = width,
+                .renderTargetHeight = height,
+                .clearColor = 0xff303030,
+                .msaaSampleCount = msaa,
+                .disableRasterOrdering = forceAtomicMode,
+            });
+            auto start = std::chrono::steady_clock::now();
+            bool played = player->playFrame(fiddleContext->factory(),
+                                            renderer.get());
+            double frameRecordMs = elapsed_ms(start);
+            start = std::chrono::steady_clock::now();
+            fiddleContext->end(nullptr);
+            double frameFlushMs = elapsed_ms(start);
+            measuredFrames.push_back(played && loop > 0);
+            pollGPUTimes();
+            if (!played)
+            {
+                break;
+            }
+            ++loopFrames;
+            if (loop > 0)
+            {
+                recordMs += frameRecordMs;
+                flushMs += frameFlushMs;
+                ++frames;
+            }
+        }
+        fiddleContext->tick();
+        double loopMs = elapsed_ms(loopStart);
+        if (loopFrames == 0)
+        {
+            fprintf(stderr, "Trace contains no frames\n");
+            return 1;
+        }
+        if (loop == 0)
+        {
+            printf("warmup: %i frames in %.2fms\n", loopFrames, loopMs);
+            continue;
+        }
+        fastestLoopMs = loop == 1 ? loopMs : std::min(fastestLoopMs, loopMs);
+        slowestLoopMs = std::max(slowestLoopMs, loopMs);
+    }
+
+    const double totalMs = recordMs + flushMs;
+    printf("%i frames: %.3fms/frame (record %.3fms, flush %.3fms), "
+           "%.1f frames/s\n",
+           frames,
+           totalMs / frames,
+           recordMs / frames,
+           flushMs / frames,
+           frames * 1000 / totalMs);
+    printf("loop time: fastest %.2fms, slowest %.2fms\n",
+           fastestLoopMs,
+           slowestLoopMs);
+    fiddleContext->finishGPUTimers();
+    pollGPUTimes();
+    if (gpuFrames > 0)
+    {
+        printf("gpu: %.3fms/frame over %i resolved frames\n",
+               gpuMs / gpuFrames,
+               gpuFrames);
+    }
+    return 0;
+}
@@ -7,12 +7,34 @@
 #include "rive/animation/state_machine_instance.hpp"
 #include "rive/static_scene.hpp"
 
-#include <fstream>
 #include <iterator>
+#include <optional>
 #include <vector>
-#include <sstream>
 
+#include "alloc_tracker.hpp"
 #include "asset_utils.hpp"
+#include "async_import.hpp"
+#include "frame_arena.hpp"
+#include "frame_encoder.hpp"
+#include "frame_stats.hpp"
+#include "frame_telemetry.hpp"
+#include "hitch_recorder.hpp"
+#include "image_cache.hpp"
+#include "input_recording.hpp"
+#include "json_writer.hpp"
+#include "perf_counters.hpp"
+#include "readback_convert.hpp"
+#include "render_trace.hpp"
+#include "sampling_profiler.hpp"
+#include "trace_events.hpp"
+#include "video_writer.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <filesystem>
 
 #ifdef _WIN32
 #include <windows.h>
@@ -54,6 +76,120 @@ static bool disableFill = false;
 static bool disableStroke = false;
 static bool clockwiseFill = false;
 static bool hotloadShaders = false;
+// Nonzero when rendering offscreen with no SDL window (--headless WxH).
+static int headlessWidth = 0;
+static int headlessHeight = 0;
+// Frames between the null backend's draw-count reports (--null-report); 0
+// keeps it quiet.
+static int nullReportInterval = 0;
+
+// Offline capture (--fps N --duration SECONDS). Scenes advance by a fixed
+// 1/fps step instead of wall-clock time, and every frame is read back
+// asynchronously as fast as the backend can render. Frames go to image
+// files (--export DIR) and/or a raw video stream (--video-out PATH|-).
+static double captureFps = 60;
+static double captureDuration = 5;
+static int captureFrameCount = 0;
+static int captureRenderedFrames = 0;
+static int capturedFrames = 0;
+static std::chrono::steady_clock::time_point captureStartTime;
+static bool captureFailed = false;
+
+static std::string exportDir;
+static FrameEncoderOptions exportEncoderOptions;
+static std::unique_ptr<FrameEncoder> exportEncoder;
+
+static std::string videoOutPath;
+static VideoFormat videoFormat = VideoFormat::y4m;
+static int videoThreads = 0;
+static std::unique_ptr<VideoWriter> videoWriter;
+
+// Draw-command trace for lp_replay (--record-trace PATH [--record-frames N]).
+static std::string recordTracePath;
+static int recordTraceFrames = 0;
+static std::unique_ptr<RenderTraceRecorder> traceRecorder;
+
+// Event/delta/input logs (--record-input FILE, --replay FILE). While
+// replaying, live input is ignored and the log drives the loop.
+static std::string inputRecordPath;
+static std::string inputReplayPath;
+static std::unique_ptr<InputRecorder> inputRecorder;
+static std::unique_ptr<InputReplayer> inputReplayer;
+static bool replayFinished = false;
+
+// Benchmark (--bench N [--warmup M] [--json PATH]): M untimed frames, then
+// N timed ones on the virtual clock with vsync off, then exit.
+static int benchFrames = 0;
+static int benchWarmupFrames = 0;
+static int benchRenderedFrames = 0;
+static std::string benchJsonPath;
+static FrameStats benchStats;
+static FrameTimings frameTimings;
+// end() calls so far, and the first one that was measured; GPU times are
+// matched to frames by this count.
+static uint64_t framesEnded = 0;
+static uint64_t benchFirstFrameNumber = 0;
+// Hardware counters per phase (--perf-counters, with --bench on Linux).
+static bool benchPerfCounters = false;
+static PerfCounterGroup perfCounters;
+static PerfCounts framePerf[kFramePhaseCount];
+
+// Heap allocation counts by subsystem (--track-allocs). Reported by --bench
+// and dumped, since the previous dump, whenever A is pressed.
+static bool trackAllocs = false;
+static AllocCounts allocsAtLastDump;
+static uint64_t framesAtLastDump = 0;
+
+// --trap-allocs: abort on any heap allocation between begin() and end() of a
+// steady-state frame. Frames that import, (re)create scenes or resize are
+// exempt, as are the kTrapAllocsGraceFrames after them while caches warm up,
+// and render trace recording, which allocates by design.
+static bool trapAllocs = false;
+constexpr static int kTrapAllocsGraceFrames = 60;
+static int framesSinceSceneChange = 0;
+
+// Frame/advance/flush histograms, always recorded once a .riv is loaded.
+// --telemetry-interval SECONDS prints the rolling window's percentiles every
+// interval; --telemetry PATH also appends them to a CSV or JSON Lines file.
+static FrameTelemetry telemetry;
+static std::string telemetryPath;
+static double telemetryIntervalSeconds = 0;
+static std::chrono::steady_clock::time_point telemetryStartTime;
+static std::chrono::steady_clock::time_point lastTelemetrySnapshot;
+static std::chrono::steady_clock::time_point lastFrameEndTime;
+// Frame times since the title last updated, for its p99/max.
+static LatencyHistogram titleFrameTimes;
+
+// Flight recorder (--hitch-ms MS [--hitch-dir DIR]): always keeps the last
+// few hundred frames; one over budget gets them written out as a Chrome
+// trace. hitchFrame collects the current frame as it runs.
+static std::unique_ptr<HitchRecorder> hitchRecorder;
+static double hitchBudgetMs = 0;
+static std::string hitchDir = ".";
+static HitchFrame hitchFrame;
+// "artboard/scene" of the current scene, cached when scenes are made so
+// frames can copy it without allocating.
+static char currentSceneName[sizeof(HitchFrame::scene)];
+
+// Per-frame temporaries (window title, log lines). Reset right before
+// begin(), so anything formatted into it lives until the next frame starts.
+static FrameArena frameArena(64 * 1024);
+
+// Sampling profiler (--profile PATH [--profile-hz N]): render thread stacks,
+// written as folded stacks on exit. The default rate is prime so it doesn't
+// lock step with the frame rate.
+static std::string profilePath;
+static int profileHz = 997;
+
+// Decoded .riv images kept across launches (--image-cache DIR
+// [--image-cache-mb N]), so a cold start maps pixels instead of decoding.
+static std::string imageCacheDir;
+static double imageCacheMB = 512;
+static std::unique_ptr<DecodedImageCache> imageCache;
+
+// Chrome trace of the LP_TRACE_SCOPE timers (--trace PATH). Written on exit
+// and whenever T is pressed.
+static std::string traceOutputPath;
 
 static std::unique_ptr<FiddleContext> fiddleContext;
 
@@ -78,6 +214,7 @@ enum class API
     d3d12,
     dawn,
     vulkan,
+    null,
 };
 
 API api =
@@ -93,15 +230,63 @@ API api =
 bool angle = false;
 bool skia = false;
 
+static const char* api_name(API api)
+{
+    switch (api)
+    {
+        case API::gl:
+            return "gl";
+        case API::metal:
+            return "metal";
+        case API::d3d:
+            return "d3d";
+        case API::d3d12:
+            return "d3d12";
+        case API::dawn:
+            return "dawn";
+        case API::vulkan:
+            return "vulkan";
+        case API::null:
+            return "null";
+    }
+    return "unknown";
+}
+
+static double elapsed_ms(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(
+               std::chrono::steady_clock::now() - start)
+        .count();
+}
+
+// Adds the counters since *mark to `phase` and moves the mark to now.
+static void end_perf_phase(PerfCounts* mark, FramePhase phase)
+{
+    if (perfCounters.isOpen())
+    {
+        const PerfCounts now = perfCounters.read();
+        framePerf[phase] += now - *mark;
+        *mark = now;
+    }
+}
+
 // Remove mouse_button_callback, mousemove_callback, key_callback, and all related variables and code for dragging, interactive points, and view manipulation.
 // Remove registration of these callbacks in main.
 // Remove code that draws interactive points or handles dragging/translation/scale in the render loop.
 // Keep launch-time options and core Rive file loading/playing logic.
 
+// Owns the .riv's bytes (a mapping or a bundle entry), kept for as long as
+// rivFile.
+static std::unique_ptr<AsyncRivImport::Result> rivBytes;
+// Loads rivName off the render thread; null once the file has arrived.
+static std::unique_ptr<AsyncRivImport> rivImport;
+static bool rivImportFailed = false;
 std::unique_ptr<File> rivFile;
 std::vector<std::unique_ptr<Artboard>> artboards;
 std::vector<std::unique_ptr<Scene>> scenes;
 std::vector<rive::rcp<rive::ViewModelInstance>> viewModelInstances;
+// Artboard -> render target pixels, for routing pointer events.
+static Mat2D sceneTransform;
 
 static void clear_scenes()
 {
@@ -113,6 +298,8 @@ static void clear_scenes()
 // Remove all references to stateMachine, animation, horzRepeat, upRepeat, downRepeat, paused, scale, and translate.
 // In make_scenes, always create a single scene: use the first state machine if available, else the first animation.
 static void make_scenes(int width = 0, int height = 0) {
+    LP_TRACE_SCOPE("make_scenes");
+    AllocTagScope allocTag(AllocTag::makeScenes);
     clear_scenes();
     auto artboard = rivFile->artboardDefault();
     
@@ -143,6 +330,11 @@ static void make_scenes(int width = 0, int height = 0) {
     if (viewModelInstances.back() != nullptr) {
         scene->bindViewModelInstance(viewModelInstances.back());
     }
+    snprintf(currentSceneName,
+             sizeof(currentSceneName),
+             "%s/%s",
+             artboard->name().c_str(),
+             scene->name().c_str());
     artboards.push_back(std::move(artboard));
     scenes.push_back(std::move(scene));
 }
@@ -190,6 +382,7 @@ std::unique_ptr<Renderer> renderer;
 std::string rivName;
 
 void renderFrame();
+static void capture_frame(const ReadbackFrame&);
 
 // Add the window refresh callback
 void window_refresh_callback(SDL_Window* window) {
@@ -202,14 +395,196 @@ void window_refresh_callback(SDL_Window* window) {
 static double lastFrameTime = 0.0;
 static bool appInitialized = false;
 
+// Render target size in pixels, as renderFrame() will size it.
+static void render_target_size(int* width, int* height)
+{
+    if (window == nullptr)
+    {
+        *width = headlessWidth;
+        *height = headlessHeight;
+    }
+    else if (api == API::metal)
+    {
+        int windowWidth, windowHeight;
+        SDL_GetWindowSize(window, &windowWidth, &windowHeight);
+        const float scale = fiddleContext->dpiScale(window);
+        *width = static_cast<int>(windowWidth * scale);
+        *height = static_cast<int>(windowHeight * scale);
+    }
+    else
+    {
+        SDL_GetWindowSizeInPixels(window, width, height);
+    }
+}
+
+// Opens the --record-input log, or puts a --replay at the size it was
+// recorded at. Needs the fiddle context for the Metal backing scale.
+static bool start_input_log()
+{
+    int width, height;
+    if (inputReplayer)
+    {
+        const int recordedWidth = static_cast<int>(inputReplayer->width());
+        const int recordedHeight = static_cast<int>(inputReplayer->height());
+        if (window != nullptr)
+        {
+            const float density = SDL_GetWindowPixelDensity(window);
+            SDL_SetWindowSize(window,
+                              static_cast<int>(recordedWidth / density),
+                              static_cast<int>(recordedHeight / density));
+            SDL_SyncWindow(window);
+        }
+        render_target_size(&width, &height);
+        if (width != recordedWidth || height != recordedHeight)
+        {
+            fprintf(stderr,
+                    "%s was recorded at %ix%i but this run renders at "
+                    "%ix%i%s\n",
+                    inputReplayPath.c_str(),
+                    recordedWidth,
+                    recordedHeight,
+                    width,
+                    height,
+                    window ? "" : " (pass --headless WIDTHxHEIGHT)");
+            return false;
+        }
+    }
+    else if (!inputRecordPath.empty())
+    {
+        render_target_size(&width, &height);
+        inputRecorder = InputRecorder::Open(inputRecordPath.c_str(),
+                                            static_cast<uint32_t>(width),
+                                            static_cast<uint32_t>(height));
+        if (!inputRecorder)
+        {
+            return false;
+        }
+        printf("Recording input to %s\n", inputRecordPath.c_str());
+    }
+    return true;
+}
+
+static SDL_AppResult create_fiddle_context()
+{
+    printf("SDL_AppInit: Creating fiddle context for API %d\n", (int)api);
+    switch (api)
+    {
+        case API::metal:
+            fiddleContext = FiddleContext::MakeMetalPLS(options);
+            break;
+        //case API::d3d:
+         //   fiddleContext = FiddleContext::MakeD3DPLS(options);
+          //  break;
+        //case API::d3d12:
+        //    fiddleContext = FiddleContext::MakeD3D12PLS(options);
+        //    break;
+       // case API::dawn:
+       //     fiddleContext = FiddleContext::MakeDawnPLS(options);
+        //    break;
+        case API::vulkan:
+            fiddleContext = FiddleContext::MakeVulkanPLS(options);
+            break;
+        case API::gl:
+            // Only the Linux build compiles the GL backend; elsewhere this
+            // returns null.
+            fiddleContext = FiddleContext::MakeGLPLS(options);
+            break;
+        case API::null:
+            fiddleContext = FiddleContext::MakeNull(nullReportInterval);
+            break;
+        default:
+            break;
+    }
+    if (!fiddleContext)
+    {
+        fprintf(stderr, "Failed to create a fiddle context.\n");
+        abort();
+    }
+    if (captureFrameCount > 0)
+    {
+        fiddleContext->setReadbackCallback(capture_frame);
+    }
+    if (!start_input_log())
+    {
+        return SDL_APP_FAILURE;
+    }
+    if (!recordTracePath.empty())
+    {
+        traceRecorder = RenderTraceRecorder::Open(recordTracePath.c_str(),
+                                                  fiddleContext->factory(),
+                                                  recordTraceFrames);
+        if (!traceRecorder)
+        {
+            return SDL_APP_FAILURE;
+        }
+        printf("Recording draw commands to %s\n", recordTracePath.c_str());
+    }
+    // After context creation, so the profile is the frame loop (import
+    // included) rather than device setup.
+    if (!profilePath.empty() && !profiler_start(profileHz))
+    {
+        return SDL_APP_FAILURE;
+    }
+
+    appInitialized = true;
+    return SDL_APP_CONTINUE;
+}
+
+// Parses a flag's whole-number value in [min, max]. Garbage, trailing
+// characters and out-of-range values print the reason and return false.
+static bool parse_int_arg(const char* flag,
+                          const char* value,
+                          long min,
+                          long max,
+                          int* out)
+{
+    char* end = nullptr;
+    errno = 0;
+    const long parsed = strtol(value, &end, 10);
+    if (end == value || *end != '\0' || errno == ERANGE || parsed < min ||
+        parsed > max)
+    {
+        fprintf(stderr,
+                "%s expects a whole number in %ld..%ld, got \"%s\"\n",
+                flag,
+                min,
+                max,
+                value);
+        return false;
+    }
+    *out = static_cast<int>(parsed);
+    return true;
+}
+
+// Parses a flag's finite, positive (or, with allowZero, non-negative)
+// numeric value.
+static bool parse_double_arg(const char* flag,
+                             const char* value,
+                             bool allowZero,
+                             double* out)
+{
+    char* end = nullptr;
+    const double parsed = strtod(value, &end);
+    if (end == value || *end != '\0' || !std::isfinite(parsed) ||
+        parsed < 0 || (parsed == 0 && !allowZero))
+    {
+        fprintf(stderr,
+                "%s expects a %s number, got \"%s\"\n",
+                flag,
+                allowZero ? "non-negative" : "positive",
+                value);
+        return false;
+    }
+    *out = parsed;
+    return true;
+}
+
 // SDL3 App Callbacks
 extern "C" SDL_AppResult SDL_AppInit(void** applicationstate, int argc, char* argv[])
 {
     // Cause stdout and stderr to print immediately without buffering.
     setvbuf(stdout, NULL, _IONBF, 0);
     setvbuf(stderr, NULL, _IONBF, 0);
-    
-    printf("SDL_AppInit: Starting initialization...\n");
 
 #ifdef DEBUG
     options.enableVulkanValidationLayers = true;
@@ -308,10 +683,251 @@ extern "C" SDL_AppResult SDL_AppInit(void** applicationstate, int argc, char* ar
             api = API::vulkan;
             forceAtomicMode = true;
         }
+        else if (!strcmp(argv[i], "--null"))
+        {
+            // No graphics API: measures the runtime's CPU cost alone.
+            api = API::null;
+        }
+        else if (!strcmp(argv[i], "--null-report"))
+        {
+            // Periodic draw counts from the null backend.
+            nullReportInterval = 120;
+        }
         else if (!strcmp(argv[i], "--skia"))
         {
             skia = true;
         }
+        else if (!strcmp(argv[i], "--headless"))
+        {
+            if (i + 1 >= argc ||
+                sscanf(argv[++i], "%ix%i", &headlessWidth, &headlessHeight) !=
+                    2 ||
+                headlessWidth <= 0 || headlessHeight <= 0)
+            {
+                fprintf(stderr, "usage: --headless WIDTHxHEIGHT\n");
+                return SDL_APP_FAILURE;
+            }
+            options.allowHeadlessRendering = true;
+        }
+        else if (!strcmp(argv[i], "--export") && i + 1 < argc)
+        {
+            exportDir = argv[++i];
+        }
+        else if (!strcmp(argv[i], "--fps") && i + 1 < argc)
+        {
+            if (!parse_double_arg("--fps", argv[++i], false, &captureFps))
+            {
+                return SDL_APP_FAILURE;
+            }
+        }
+        else if (!strcmp(argv[i], "--duration") && i + 1 < argc)
+        {
+            if (!parse_double_arg("--duration",
+                                  argv[++i],
+                                  false,
+                                  &captureDuration))
+            {
+                return SDL_APP_FAILURE;
+            }
+        }
+        else if (!strcmp(argv[i], "--export-format") && i + 1 < argc)
+        {
+            const char* format = argv[++i];
+            if (!strcmp(format, "png"))
+            {
+                exportEncoderOptions.encoding = FrameEncoding::png;
+            }
+            else if (!strcmp(format, "webp"))
+            {
+                exportEncoderOptions.encoding = FrameEncoding::webpLossless;
+            }
+            else if (!strcmp(format, "webp-lossy"))
+            {
+                exportEncoderOptions.encoding = FrameEncoding::webpLossy;
+            }
+            else
+            {
+                fprintf(stderr,
+                        "unknown --export-format %s (png, webp, webp-lossy)\n",
+                        format);
+                return SDL_APP_FAILURE;
+            }
+        }
+        else if (!strcmp(argv[i], "--encode-threads") && i + 1 < argc)
+        {
+            if (!parse_int_arg("--encode-threads",
+                               argv[++i],
+                               0,
+                               1024,
+                               &exportEncoderOptions.workerCount))
+            {
+                return SDL_APP_FAILURE;
+            }
+        }
+        else if (!strcmp(argv[i], "--encode-queue") && i + 1 < argc)
+        {
+            if (!parse_int_arg("--encode-queue",
+                               argv[++i],
+                               1,
+                               1024,
+                               &exportEncoderOptions.queueDepth))
+            {
+                return SDL_APP_FAILURE;
+            }
+        }
+        else if (!strcmp(argv[i], "--video-out") && i + 1 < argc)
+        {
+            videoOutPath = argv[++i];
+        }
+        else if (!strcmp(argv[i], "--video-format") && i + 1 < argc)
+        {
+            const char* format = argv[++i];
+            if (!strcmp(format, "y4m"))
+            {
+                videoFormat = VideoFormat::y4m;
+            }
+            else if (!strcmp(format, "nv12"))
+            {
+                videoFormat = VideoFormat::nv12;
+            }
+            else
+            {
+                fprintf(stderr,
+                        "unknown --video-format %s (y4m, nv12)\n",
+                        format);
+                return SDL_APP_FAILURE;
+            }
+        }
+        else if (!strcmp(argv[i], "--video-threads") && i + 1 < argc)
+        {
+            if (!parse_int_arg("--video-threads",
+                               argv[++i],
+                               0,
+                               1024,
+                               &videoThreads))
+            {
+                return SDL_APP_FAILURE;
+            }
+        }
+        else if (!strcmp(argv[i], "--record-trace") && i + 1 < argc)
+        {
+            recordTracePath = argv[++i];
+        }
+        else if (!strcmp(argv[i], "--record-frames") && i + 1 < argc)
+        {
+            if (!parse_int_arg("--record-frames",
+                               argv[++i],
+                               0,
+                               INT_MAX,
+                               &recordTraceFrames))
+            {
+                return SDL_APP_FAILURE;
+            }
+        }
+        else if (!strcmp(argv[i], "--record-input") && i + 1 < argc)
+        {
+            inputRecordPath = argv[++i];
+        }
+        else if (!strcmp(argv[i], "--replay") && i + 1 < argc)
+        {
+            inputReplayPath = argv[++i];
+        }
+        else if (!strcmp(argv[i], "--bench") && i + 1 < argc)
+        {
+            if (!parse_int_arg("--bench", argv[++i], 1, INT_MAX, &benchFrames))
+            {
+                return SDL_APP_FAILURE;
+            }
+        }
+        else if (!strcmp(argv[i], "--warmup") && i + 1 < argc)
+        {
+            if (!parse_int_arg("--warmup",
+                               argv[++i],
+                               0,
+                               INT_MAX,
+                               &benchWarmupFrames))
+            {
+                return SDL_APP_FAILURE;
+            }
+        }
+        else if (!strcmp(argv[i], "--json") && i + 1 < argc)
+        {
+            benchJsonPath = argv[++i];
+        }
+        else if (!strcmp(argv[i], "--perf-counters"))
+        {
+            benchPerfCounters = true;
+        }
+        else if (!strcmp(argv[i], "--track-allocs"))
+        {
+            trackAllocs = true;
+        }
+        else if (!strcmp(argv[i], "--trap-allocs"))
+        {
+            trackAllocs = true;
+            trapAllocs = true;
+        }
+        else if (!strcmp(argv[i], "--telemetry") && i + 1 < argc)
+        {
+            telemetryPath = argv[++i];
+        }
+        else if (!strcmp(argv[i], "--telemetry-interval") && i + 1 < argc)
+        {
+            if (!parse_double_arg("--telemetry-interval",
+                                  argv[++i],
+                                  false,
+                                  &telemetryIntervalSeconds))
+            {
+                return SDL_APP_FAILURE;
+            }
+        }
+        else if (!strcmp(argv[i], "--hitch-ms") && i + 1 < argc)
+        {
+            if (!parse_double_arg("--hitch-ms",
+                                  argv[++i],
+                                  false,
+                                  &hitchBudgetMs))
+            {
+                return SDL_APP_FAILURE;
+            }
+        }
+        else if (!strcmp(argv[i], "--hitch-dir") && i + 1 < argc)
+        {
+            hitchDir = argv[++i];
+        }
+        else if (!strcmp(argv[i], "--profile") && i + 1 < argc)
+        {
+            profilePath = argv[++i];
+        }
+        else if (!strcmp(argv[i], "--profile-hz") && i + 1 < argc)
+        {
+            if (!parse_int_arg("--profile-hz",
+                               argv[++i],
+                               1,
+                               1000000000,
+                               &profileHz))
+            {
+                return SDL_APP_FAILURE;
+            }
+        }
+        else if (!strcmp(argv[i], "--image-cache") && i + 1 < argc)
+        {
+            imageCacheDir = argv[++i];
+        }
+        else if (!strcmp(argv[i], "--image-cache-mb") && i + 1 < argc)
+        {
+            if (!parse_double_arg("--image-cache-mb",
+                                  argv[++i],
+                                  true,
+                                  &imageCacheMB))
+            {
+                return SDL_APP_FAILURE;
+            }
+        }
+        else if (!strcmp(argv[i], "--trace") && i + 1 < argc)
+        {
+            traceOutputPath = argv[++i];
+        }
         else if (sscanf(argv[i], "-a%i", &animation))
         {
             // Already updated animation.
@@ -349,6 +965,144 @@ extern "C" SDL_AppResult SDL_AppInit(void** applicationstate, int argc, char* ar
     // Always use the hardcoded .riv file path
     rivName = getAssetPath("lp_unity_v10.riv");
 
+    if (api == API::null)
+    {
+        if (!exportDir.empty() || !videoOutPath.empty())
+        {
+            fprintf(stderr, "--null renders no pixels to capture\n");
+            return SDL_APP_FAILURE;
+        }
+        // There is no surface to present to; size the artboard as the
+        // default window would be unless --headless says otherwise.
+        options.allowHeadlessRendering = true;
+        if (headlessWidth == 0)
+        {
+            headlessWidth = headlessHeight = 1600;
+        }
+    }
+
+    if (!exportDir.empty() || !videoOutPath.empty())
+    {
+        if (captureFps <= 0 || captureDuration <= 0)
+        {
+            fprintf(stderr, "--fps and --duration must be positive\n");
+            return SDL_APP_FAILURE;
+        }
+        captureFrameCount =
+            std::max(1, static_cast<int>(captureDuration * captureFps + .5));
+        options.enableReadPixels = true;
+    }
+    if (!videoOutPath.empty())
+    {
+        // Open first: streaming to stdout moves the logs below to stderr.
+        videoWriter = VideoWriter::Open(videoOutPath.c_str(),
+                                        videoFormat,
+                                        captureFps,
+                                        videoThreads);
+        if (!videoWriter)
+        {
+            return SDL_APP_FAILURE;
+        }
+        printf("Streaming %i frames at %g fps to %s\n",
+               captureFrameCount,
+               captureFps,
+               videoOutPath.c_str());
+    }
+    if (!exportDir.empty())
+    {
+        std::error_code ec;
+        std::filesystem::create_directories(exportDir, ec);
+        if (ec)
+        {
+            fprintf(stderr,
+                    "Failed to create %s: %s\n",
+                    exportDir.c_str(),
+                    ec.message().c_str());
+            return SDL_APP_FAILURE;
+        }
+        exportEncoder = std::make_unique<FrameEncoder>(exportEncoderOptions);
+        printf("Exporting %i frames at %g fps to %s\n",
+               captureFrameCount,
+               captureFps,
+               exportDir.c_str());
+    }
+
+    if (benchFrames > 0)
+    {
+        benchWarmupFrames = std::max(benchWarmupFrames, 0);
+        benchStats.reserve(benchFrames);
+        printf("Benchmarking %i frames after %i warmup frames\n",
+               benchFrames,
+               benchWarmupFrames);
+    }
+    else if (!benchJsonPath.empty() || benchPerfCounters)
+    {
+        fprintf(stderr, "--json and --perf-counters require --bench N\n");
+        return SDL_APP_FAILURE;
+    }
+    // Counters are per thread; renderFrame() runs on this one.
+    if (benchPerfCounters && perfCounters.open())
+    {
+        benchStats.setPerfCounters(perfCounters);
+    }
+
+    if (trackAllocs)
+    {
+        alloc_tracking_enable();
+    }
+
+    if (hitchBudgetMs > 0)
+    {
+        hitchRecorder = std::make_unique<HitchRecorder>(hitchBudgetMs, hitchDir);
+    }
+
+    if (!imageCacheDir.empty())
+    {
+        // Not fatal: without the cache images are just decoded every launch.
+        imageCache = DecodedImageCache::Open(
+            imageCacheDir,
+            static_cast<uint64_t>(std::max(imageCacheMB, 0.0) * 1024 * 1024));
+    }
+
+    if (!telemetryPath.empty())
+    {
+        if (!telemetry.openLog(telemetryPath.c_str()))
+        {
+            return SDL_APP_FAILURE;
+        }
+        if (telemetryIntervalSeconds <= 0)
+        {
+            telemetryIntervalSeconds = 10;
+        }
+    }
+
+    if (!traceOutputPath.empty())
+    {
+        trace_start();
+        trace_set_thread_name("main");
+    }
+
+    if (!inputReplayPath.empty())
+    {
+        inputReplayer = InputReplayer::Open(inputReplayPath.c_str());
+        if (!inputReplayer)
+        {
+            return SDL_APP_FAILURE;
+        }
+        printf("Replaying input from %s\n", inputReplayPath.c_str());
+    }
+
+    // Logged after --video-out had a chance to move logging off stdout.
+    printf("SDL_AppInit: Starting initialization...\n");
+
+    if (options.allowHeadlessRendering)
+    {
+        printf("SDL_AppInit: Rendering headless at %ix%i\n",
+               headlessWidth,
+               headlessHeight);
+        return create_fiddle_context();
+    }
+
     printf("SDL_AppInit: About to create window with API %d\n", (int)api);
 
     // Set up SDL window hints based on API
@@ -369,6 +1123,8 @@ extern "C" SDL_AppResult SDL_AppInit(void** applicationstate, int argc, char* ar
         case API::vulkan:
             SDL_SetHint(SDL_HINT_RENDER_DRIVER, "vulkan");
             break;
+        case API::null:
+            break;
         case API::gl:
             if (angle)
             {
@@ -396,6 +1152,7 @@ extern "C" SDL_AppResult SDL_AppInit(void** applicationstate, int argc, char* ar
         case API::d3d:
         case API::d3d12:
         case API::dawn:
+        case API::null:
             // For D3D/Dawn, we don't need special window flags
             // SDL will handle the rendering through the render driver hint
             break;
@@ -442,54 +1199,77 @@ extern "C" SDL_AppResult SDL_AppInit(void** applicationstate, int argc, char* ar
 
 
 
-    printf("SDL_AppInit: Creating fiddle context for API %d\n", (int)api);
-    switch (api)
+    return create_fiddle_context();
+}
+
+enum class PointerAction
+{
+    move,
+    down,
+    up,
+};
+
+// Sends a pointer event, in render target pixels, to the state machine.
+static void pointer_event(PointerAction action, float x, float y)
+{
+    if (scenes.empty())
     {
-        case API::metal:
-            fiddleContext = FiddleContext::MakeMetalPLS(options);
-            break;
-        //case API::d3d:
-         //   fiddleContext = FiddleContext::MakeD3DPLS(options);
-          //  break;
-        //case API::d3d12:
-        //    fiddleContext = FiddleContext::MakeD3D12PLS(options);
-        //    break;
-       // case API::dawn:
-       //     fiddleContext = FiddleContext::MakeDawnPLS(options);
-        //    break;
-        case API::vulkan:
-            fiddleContext = FiddleContext::MakeVulkanPLS(options);
-            break;
-       // case API::gl:
-        //    printf("SDL_AppInit: Creating GL fiddle context (skia=%d)\n", skia);
-        //    fiddleContext =
-        //        skia ? FiddleContext::MakeGLSkia() : FiddleContext::MakeGLPLS();
-        //    break;
+        return;
     }
-    if (!fiddleContext)
+    Scene* scene = scenes.front().get();
+    Vec2D position = sceneTransform.invertOrIdentity() * Vec2D(x, y);
+    switch (action)
     {
-        fprintf(stderr, "Failed to create a fiddle context.\n");
-        abort();
+        case PointerAction::move:
+            scene->pointerMove(position);
+            break;
+        case PointerAction::down:
+            scene->pointerDown(position);
+            break;
+        case PointerAction::up:
+            scene->pointerUp(position);
+            break;
     }
-
-    appInitialized = true;
-    return SDL_APP_CONTINUE;
 }
 
-extern "C" SDL_AppResult SDL_AppEvent(void* applicationstate, SDL_Event* event)
+// Handles a live event, or a recorded one during --replay.
+static SDL_AppResult handle_event(const SDL_Event& event)
 {
-    switch (event->type)
+    switch (event.type)
     {
         case SDL_EVENT_QUIT:
             return SDL_APP_FAILURE; // Return failure to quit
         case SDL_EVENT_KEY_DOWN:
-            if (event->key.key == SDLK_ESCAPE)
+            if (event.key.key == SDLK_ESCAPE)
             {
                 return SDL_APP_FAILURE; // Return failure to quit
             }
             break;
+        case SDL_EVENT_MOUSE_MOTION:
+            pointer_event(PointerAction::move, event.motion.x, event.motion.y);
+            break;
+        case SDL_EVENT_MOUSE_BUTTON_DOWN:
+            pointer_event(PointerAction::down, event.button.x, event.button.y);
+            break;
+        case SDL_EVENT_MOUSE_BUTTON_UP:
+            pointer_event(PointerAction::up, event.button.x, event.button.y);
+            break;
         case SDL_EVENT_WINDOW_RESIZED:
-            // Force an immediate render to update the display
+            if (inputReplayer)
+            {
+                // Resize to match the recording. The next record already
+                // holds the frame the recording rendered here. Headless
+                // replays stay at the recorded starting size.
+                if (window != nullptr)
+                {
+                    SDL_SetWindowSize(window,
+                                      event.window.data1,
+                                      event.window.data2);
+                    SDL_SyncWindow(window);
+                }
+                break;
+            }
+            // Force an immediate render to update the display.
             if (appInitialized) {
                 renderFrame();
                 if (api == API::gl) {
@@ -501,18 +1281,257 @@ extern "C" SDL_AppResult SDL_AppEvent(void* applicationstate, SDL_Event* event)
     return SDL_APP_CONTINUE; // Return continue to keep running
 }
 
+extern "C" SDL_AppResult SDL_AppEvent(void* applicationstate, SDL_Event* event)
+{
+    if (!traceOutputPath.empty() && event->type == SDL_EVENT_KEY_DOWN &&
+        event->key.key == SDLK_T)
+    {
+        trace_write(traceOutputPath.c_str());
+        return SDL_APP_CONTINUE;
+    }
+    if (trackAllocs && event->type == SDL_EVENT_KEY_DOWN &&
+        event->key.key == SDLK_A)
+    {
+        AllocCounts counts = alloc_counts();
+        print_alloc_counts(counts - allocsAtLastDump,
+                           framesEnded - framesAtLastDump);
+        allocsAtLastDump = counts;
+        framesAtLastDump = framesEnded;
+        return SDL_APP_CONTINUE;
+    }
+
+    if (inputReplayer)
+    {
+        // Only let the user stop a replay; everything else comes from the log.
+        if (event->type == SDL_EVENT_QUIT ||
+            (event->type == SDL_EVENT_KEY_DOWN && event->key.key == SDLK_ESCAPE))
+        {
+            return SDL_APP_FAILURE;
+        }
+        return SDL_APP_CONTINUE;
+    }
+
+    // Pointer positions are logged in render target pixels so a replay does
+    // not depend on the recording display's pixel density.
+    SDL_Event pixelEvent = *event;
+    const float density = window ? SDL_GetWindowPixelDensity(window) : 1.f;
+    if (event->type == SDL_EVENT_MOUSE_MOTION)
+    {
+        pixelEvent.motion.x *= density;
+        pixelEvent.motion.y *= density;
+    }
+    else if (event->type == SDL_EVENT_MOUSE_BUTTON_DOWN ||
+             event->type == SDL_EVENT_MOUSE_BUTTON_UP)
+    {
+        pixelEvent.button.x *= density;
+        pixelEvent.button.y *= density;
+    }
+    if (inputRecorder)
+    {
+        inputRecorder->recordEvent(pixelEvent);
+    }
+    return handle_event(pixelEvent);
+}
+
+static SDL_AppResult finish_bench()
+{
+    // The last frames' timers are still in flight; wait for them rather than
+    // summarizing without them.
+    fiddleContext->finishGPUTimers();
+    GPUFrameTime gpuTime;
+    while (fiddleContext->pollGPUFrameTime(&gpuTime))
+    {
+        if (gpuTime.frameNumber >= benchFirstFrameNumber)
+        {
+            benchStats.addGPUTime(gpuTime.ms);
+        }
+    }
+    printf("Bench: %s, msaa %i, %s, %ix%i\n",
+           api_name(api),
+           msaa,
+           forceAtomicMode ? "atomic" : "rasterOrdering",
+           lastWidth,
+           lastHeight);
+    benchStats.print();
+    if (benchJsonPath.empty())
+    {
+        return SDL_APP_SUCCESS;
+    }
+    FILE* file = fopen(benchJsonPath.c_str(), "w");
+    if (file == nullptr)
+    {
+        fprintf(stderr, "Failed to open %s for writing\n", benchJsonPath.c_str());
+        return SDL_APP_FAILURE;
+    }
+    JSONWriter json(file);
+    json.beginObject();
+    json.string("file", rivName.c_str());
+    json.string("backend", api_name(api));
+    json.integer("msaa", msaa);
+    json.boolean("atomic", forceAtomicMode);
+    json.integer("width", lastWidth);
+    json.integer("height", lastHeight);
+    json.integer("warmup_frames", benchWarmupFrames);
+    json.integer("frames", static_cast<int64_t>(benchStats.frameCount()));
+    benchStats.writeJSON(&json);
+    json.endObject();
+    fclose(file);
+    printf("Wrote %s\n", benchJsonPath.c_str());
+    return SDL_APP_SUCCESS;
+}
+
 extern "C" SDL_AppResult SDL_AppIterate(void* applicationstate)
 {
     if (!appInitialized) {
         return SDL_APP_CONTINUE;
     }
+    LP_TRACE_SCOPE("SDL_AppIterate");
 
+    const AllocCounts allocsBeforeFrame =
+        trackAllocs ? alloc_counts() : AllocCounts();
+    hitchFrame = {};
     renderFrame();
     fiddleContext->tick();
     
-    if (api == API::gl)
+    if (api == API::gl && window != nullptr)
     {
+        LP_TRACE_SCOPE("SDL_GL_SwapWindow");
+        auto presentStart = std::chrono::steady_clock::now();
         SDL_GL_SwapWindow(window);
+        frameTimings.ms[kPresentPhase] = elapsed_ms(presentStart);
+    }
+
+    auto frameEndTime = std::chrono::steady_clock::now();
+    // Frame time is end to end, so it also catches stalls outside the timed
+    // phases (event handling, the OS, a blocked present).
+    const double frameMs =
+        lastFrameEndTime == std::chrono::steady_clock::time_point()
+            ? 0
+            : std::chrono::duration<double, std::milli>(frameEndTime -
+                                                        lastFrameEndTime)
+                  .count();
+    if (hitchRecorder && frameMs > 0)
+    {
+        hitchFrame.frameNumber = framesEnded - 1;
+        hitchFrame.endNs = trace_now_ns();
+        hitchFrame.frameMs = frameMs;
+        hitchFrame.timings = frameTimings;
+        if (hitchRecorder->record(hitchFrame))
+        {
+            hitchRecorder->writeDump();
+            // Don't bill the dump to the next frame.
+            frameEndTime = std::chrono::steady_clock::now();
+        }
+    }
+    if (rivFile && !replayFinished && frameMs > 0)
+    {
+        telemetry.record(frameMs,
+                         frameTimings.ms[kAdvancePhase],
+                         frameTimings.ms[kFlushPhase]);
+        titleFrameTimes.record(frameMs);
+        if (telemetryIntervalSeconds > 0)
+        {
+            if (telemetryStartTime == std::chrono::steady_clock::time_point())
+            {
+                telemetryStartTime = lastTelemetrySnapshot = frameEndTime;
+            }
+            else if (std::chrono::duration<double>(frameEndTime -
+                                                   lastTelemetrySnapshot)
+                         .count() >= telemetryIntervalSeconds)
+            {
+                telemetry.snapshot(std::chrono::duration<double>(
+                                       frameEndTime - telemetryStartTime)
+                                       .count());
+                lastTelemetrySnapshot = frameEndTime;
+            }
+        }
+    }
+    lastFrameEndTime = frameEndTime;
+
+    // Frames before the .riv loads draw nothing; don't count them.
+    if (benchFrames > 0 && rivFile && !replayFinished &&
+        ++benchRenderedFrames > benchWarmupFrames)
+    {
+        if (benchStats.frameCount() == 0)
+        {
+            benchFirstFrameNumber = framesEnded - 1;
+        }
+        GPUFrameTime gpuTime;
+        while (fiddleContext->pollGPUFrameTime(&gpuTime))
+        {
+            if (gpuTime.frameNumber >= benchFirstFrameNumber)
+            {
+                benchStats.addGPUTime(gpuTime.ms);
+            }
+        }
+        benchStats.add(frameTimings);
+        if (trackAllocs)
+        {
+            benchStats.addAllocations(alloc_counts() - allocsBeforeFrame);
+        }
+        if (perfCounters.isOpen())
+        {
+            benchStats.addPerfCounts(framePerf);
+        }
+        if (static_cast<int>(benchStats.frameCount()) >= benchFrames)
+        {
+            return finish_bench();
+        }
+    }
+
+    if (captureFailed)
+    {
+        return SDL_APP_FAILURE;
+    }
+    if (benchFrames > 0 && rivImportFailed)
+    {
+        // Only frames with a file count, so the bench would never finish.
+        fprintf(stderr, "Nothing to benchmark.\n");
+        return SDL_APP_FAILURE;
+    }
+    if (replayFinished)
+    {
+        printf("Replayed %u frames, %u input divergences\n",
+               inputReplayer->frameNumber(),
+               inputReplayer->divergenceCount());
+        return inputReplayer->divergenceCount() == 0 &&
+                       !inputReplayer->failed()
+                   ? SDL_APP_SUCCESS
+                   : SDL_APP_FAILURE;
+    }
+    if (captureFrameCount > 0 && captureRenderedFrames >= captureFrameCount)
+    {
+        fiddleContext->finishReadbacks();
+        if (exportEncoder)
+        {
+            exportEncoder->finish();
+        }
+        // Frames delivered by finishReadbacks() can still fail the capture,
+        // as can the video output's final flush.
+        if (videoWriter && !videoWriter->close())
+        {
+            captureFailed = true;
+        }
+        videoWriter = nullptr;
+        double seconds = std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - captureStartTime)
+                             .count();
+        printf("Captured %i frames in %.2fs (%.1f frames/s)\n",
+               capturedFrames,
+               seconds,
+               capturedFrames / seconds);
+        if (exportEncoder)
+        {
+            exportEncoder->printStats();
+            if (const uint64_t failures = exportEncoder->failureCount())
+            {
+                fprintf(stderr,
+                        "Failed to write %llu frames\n",
+                        static_cast<unsigned long long>(failures));
+                return SDL_APP_FAILURE;
+            }
+        }
+        return captureFailed ? SDL_APP_FAILURE : SDL_APP_SUCCESS;
     }
     // For Metal and other APIs, we don't need to do anything
     // The Rive renderer handles the presentation internally
@@ -523,11 +1542,41 @@ extern "C" SDL_AppResult SDL_AppIterate(void* applicationstate)
 
 extern "C" void SDL_AppQuit(void* applicationstate, SDL_AppResult result)
 {
+    if (!profilePath.empty())
+    {
+        profiler_stop();
+        profiler_write_folded(profilePath.c_str());
+    }
+    if (telemetryIntervalSeconds > 0 &&
+        telemetry.total(FrameTelemetry::kFrameMetric).count() > 0)
+    {
+        if (telemetry.window(FrameTelemetry::kFrameMetric).count() > 0)
+        {
+            telemetry.snapshot(
+                std::chrono::duration<double>(lastFrameEndTime -
+                                              telemetryStartTime)
+                    .count());
+        }
+        telemetry.printTotals();
+    }
+    if (!traceOutputPath.empty())
+    {
+        trace_write(traceOutputPath.c_str());
+    }
+    // The import thread may still be using the context's factory, and the
+    // image cache.
+    rivImport = nullptr;
+    imageCache = nullptr;
+    inputRecorder = nullptr;
+    inputReplayer = nullptr;
+    traceRecorder = nullptr;
     fiddleContext = nullptr;
     if (glContext) {
         SDL_GL_DestroyContext(glContext);
     }
-    SDL_DestroyWindow(window);
+    if (window) {
+        SDL_DestroyWindow(window);
+    }
 }
 
 // No main function needed when using SDL_MAIN_USE_CALLBACKS
@@ -538,63 +1587,143 @@ static void update_window_title(double fps,
                                 int width,
                                 int height)
 {
-    std::ostringstream title;
+    AllocTagScope allocTag(AllocTag::titleUpdate);
+    // Arguments are formatted first, so the pieces land in the arena ahead of
+    // the title that copies them.
+    // p99 and max since the last update show the hitches an average hides.
+    const char* fpsText = "";
     if (fps != 0)
     {
-        title << '[' << fps << " FPS]";
-    }
-    if (instances > 1)
-    {
-        title << " (x" << instances << " instances)";
+        fpsText = titleFrameTimes.count() > 0
+                      ? frameArena.format("[%g FPS, p99 %.1f ms, max %.1f ms]",
+                                          fps,
+                                          titleFrameTimes.percentile(99),
+                                          titleFrameTimes.max())
+                      : frameArena.format("[%g FPS]", fps);
+        titleFrameTimes.reset();
     }
-    if (skia)
+    const char* title = frameArena.format(
+        "%s%s | %s Renderer%s | %i x %i",
+        fpsText,
+        instances > 1 ? frameArena.format(" (x%i instances)", instances) : "",
+        skia ? "SKIA" : "RIVE",
+        msaa               ? frameArena.format(" (msaa%i)", msaa)
+        : forceAtomicMode ? " (atomic)"
+                          : "",
+        width,
+        height);
+    if (window == nullptr)
     {
-        title << " | SKIA Renderer";
+        printf("%s\n", title);
+        return;
     }
-    else
+    SDL_SetWindowTitle(window, title);
+}
+
+static void capture_frame(const ReadbackFrame& frame)
+{
+    if (videoWriter && !videoWriter->writeFrame(frame.width,
+                                                frame.height,
+                                                frame.pixels,
+                                                frame.conversions))
     {
-        title << " | RIVE Renderer";
+        captureFailed = true;
     }
-    if (msaa)
+
+    if (exportEncoder)
     {
-        title << " (msaa" << msaa << ')';
+        char path[1024];
+        snprintf(path,
+             sizeof(path),
+             "%s/frame_%05i.%s",
+                 exportDir.c_str(),
+                 static_cast<int>(frame.frameNumber),
+                 exportEncoder->fileExtension());
+        // Image files want top-down RGBA with straight alpha. Readback is
+        // premultiplied, and frame.conversions says how far its layout is
+        // from bottom-up RGBA, so one pass in the encoder fixes everything
+        // while copying the frame out of the readback ring; it then encodes
+        // off the render thread.
+        exportEncoder->push(path,
+                            frame.width,
+                            frame.height,
+                            frame.pixels,
+                            (frame.conversions ^ kReadbackFlipY) |
+                                kReadbackUnpremultiply);
     }
-    else if (forceAtomicMode)
+
+    if (++capturedFrames % std::max(1, static_cast<int>(captureFps)) == 0)
     {
-        title << " (atomic)";
+        printf("Captured %i/%i frames\n", capturedFrames, captureFrameCount);
     }
-    title << " | " << width << " x " << height;
-    SDL_SetWindowTitle(window, title.str().c_str());
 }
 
 void renderFrame() {
-    double currentTime = SDL_GetTicks() / 1000.0;
-    double deltaSeconds = lastFrameTime > 0.0 ? (currentTime - lastFrameTime) : (1.0 / 60.0);
-    lastFrameTime = currentTime;
+    LP_TRACE_SCOPE("renderFrame");
+    double deltaSeconds;
+    if (inputReplayer) {
+        if (!inputReplayer->nextFrame()) {
+            replayFinished = true;
+            return;
+        }
+        deltaSeconds = inputReplayer->frame().deltaSeconds;
+        for (const SDL_Event& event : inputReplayer->frame().events) {
+            handle_event(event);
+        }
+    } else if (captureFrameCount > 0 || benchFrames > 0) {
+        // Virtual clock: output must not depend on how fast frames render.
+        deltaSeconds = 1.0 / captureFps;
+    } else {
+        double currentTime = SDL_GetTicks() / 1000.0;
+        deltaSeconds = lastFrameTime > 0.0 ? (currentTime - lastFrameTime) : (1.0 / 60.0);
+        lastFrameTime = currentTime;
+    }
 
     int width = 0, height = 0;
     int windowWidth = 0, windowHeight = 0;
-    // Get both window size and pixel size to understand the scaling
-    SDL_GetWindowSize(window, &windowWidth, &windowHeight);
-    SDL_GetWindowSizeInPixels(window, &width, &height);
+    if (window == nullptr) {
+        // Headless: the render target size is fixed for the whole run.
+        width = windowWidth = headlessWidth;
+        height = windowHeight = headlessHeight;
+    } else {
+        // Get both window size and pixel size to understand the scaling
+        SDL_GetWindowSize(window, &windowWidth, &windowHeight);
+        SDL_GetWindowSizeInPixels(window, &width, &height);
+    }
     
     // For Metal on macOS, we need to manually scale the dimensions based on the backing scale factor
-    if (api == API::metal) {
+    float scale = 0;
+    if (api == API::metal && window != nullptr) {
         // Get the backing scale factor from the Metal context
-        float scale = fiddleContext->dpiScale(window);
+        scale = fiddleContext->dpiScale(window);
         width = static_cast<int>(windowWidth * scale);
         height = static_cast<int>(windowHeight * scale);
-        printf("Window size: %dx%d, Scaled pixel size: %dx%d (scale: %f)\n", windowWidth, windowHeight, width, height, scale);
-    } else {
-        printf("Window size: %dx%d, Pixel size: %dx%d\n", windowWidth, windowHeight, width, height);
     }
     if (lastWidth != width || lastHeight != height)
     {
+        // Logged on change only; printing every frame cost more than some
+        // of the frames it described.
+        {
+            AllocTagScope allocTag(AllocTag::logging);
+            if (scale != 0) {
+                printf("Window size: %dx%d, Scaled pixel size: %dx%d (scale: %f)\n", windowWidth, windowHeight, width, height, scale);
+            } else {
+                printf("Window size: %dx%d, Pixel size: %dx%d\n", windowWidth, windowHeight, width, height);
+            }
+        }
         printf("size changed to %ix%i\n", width, height);
+        framesSinceSceneChange = 0;
         lastWidth = width;
         lastHeight = height;
         fiddleContext->onSizeChanged(window, width, height, msaa);
+        hitchFrame.sizeChanged = true;
         renderer = fiddleContext->makeRenderer(width, height);
+        if (traceRecorder)
+        {
+            renderer = traceRecorder->wrapRenderer(std::move(renderer),
+                                                   width,
+                                                   height);
+        }
         needsTitleUpdate = true;
         
         // Update artboard dimensions immediately when size changes
@@ -610,21 +1739,94 @@ void renderFrame() {
         needsTitleUpdate = false;
     }
 
-    if (!rivName.empty() && !rivFile)
+    if (!rivName.empty() && !rivFile && !rivImportFailed)
     {
-        std::ifstream rivStream(rivName, std::ios::binary);
-        if (!rivStream.is_open()) {
-            fprintf(stderr, "Failed to open .riv file: %s\n", rivName.c_str());
-        } else {
-            printf("Loading Rive file: %s\n", rivName.c_str());
-            std::vector<uint8_t> rivBytes(std::istreambuf_iterator<char>(rivStream),
-                                          {});
-            rivFile = File::import(rivBytes, fiddleContext->factory());
+        // Objects drawn through a recording renderer must come from the
+        // recorder's factory.
+        Factory* factory = traceRecorder ? traceRecorder->factory()
+                                         : fiddleContext->factory();
+        // Images can be predecoded into bitmaps only when the render context
+        // is the factory itself; the null and recording factories decode
+        // through decodeImage() as usual.
+        rive::gpu::RenderContext* uploadContext =
+            traceRecorder ? nullptr : fiddleContext->renderContextOrNull();
+        if (!rivImport)
+        {
+            const AssetBundle* bundle = getAssetBundle();
+            const BundleEntry* entry =
+                bundle ? bundle->find("lp_unity_v10.riv") : nullptr;
+            if (entry)
+            {
+                printf("Loading Rive file: lp_unity_v10.riv from the asset "
+                       "bundle\n");
+                rivImport = AsyncRivImport::Start(bundle,
+                                                  entry,
+                                                  factory,
+                                                  uploadContext,
+                                                  imageCache.get());
+            }
+            else
+            {
+                printf("Loading Rive file: %s\n", rivName.c_str());
+                rivImport = AsyncRivImport::Start(rivName,
+                                                  factory,
+                                                  uploadContext,
+                                                  imageCache.get());
+            }
+        }
+        // Recordings and replays must see the file on the same frame every
+        // run, so they wait for it; otherwise frames keep presenting the
+        // clear color until it arrives.
+        std::unique_ptr<AsyncRivImport::Result> imported =
+            traceRecorder || inputRecorder || inputReplayer ? rivImport->get()
+                                                            : rivImport->poll();
+        if (imported)
+        {
+            LP_TRACE_SCOPE("import");
+            AllocTagScope allocTag(AllocTag::import);
+            auto attachStart = std::chrono::steady_clock::now();
+            rivImport = nullptr;
+            const size_t imageCount = imported->deferredImages.size();
+            AsyncRivImport::AttachImages(imported.get(), factory);
+            rivFile = std::move(imported->file);
+            framesSinceSceneChange = 0;
+            hitchFrame.importMs = elapsed_ms(attachStart);
             if (rivFile) {
                 printf("Successfully loaded Rive file with %zu artboards\n", rivFile->artboardCount());
+                // Page faults on the mapping land in import, so throughput
+                // covers reading and parsing together.
+                const double megabytes = imported->byteCount / (1024.0 * 1024.0);
+                printf("Loaded %.2f MB (%s) in %.2f ms on the import thread "
+                       "(open %.2f ms, %.1f MB/s, %.2f ms of decoding on %d "
+                       "threads), then %zu images in %.2f ms on this one\n",
+                       megabytes,
+                       imported->source,
+                       imported->importMs,
+                       imported->openMs,
+                       megabytes * 1000 / std::max(imported->importMs, 1e-3),
+                       imported->decodeMs,
+                       imported->decodeThreads,
+                       imageCount,
+                       hitchFrame.importMs);
+                if (imageCache) {
+                    printf("%d of %zu images came from the image cache\n",
+                           imported->imageCacheHits,
+                           imageCount);
+                    imageCache->printStats();
+                }
             } else {
-                printf("Failed to import Rive file\n");
+                fprintf(stderr, "Failed to load Rive file: %s\n", rivName.c_str());
+                rivImportFailed = true;
+            }
+            if (rivFile) {
+                rivBytes = std::move(imported);
+            }
+            if (captureFrameCount > 0 && !rivFile) {
+                // Capturing empty frames would just fill the disk.
+                fprintf(stderr, "Nothing to capture.\n");
+                captureFailed = true;
             }
+            captureStartTime = std::chrono::steady_clock::now();
         }
     }
 
@@ -632,38 +1834,69 @@ void renderFrame() {
     if (hotloadShaders)
     {
         hotloadShaders = false;
+        framesSinceSceneChange = 0;
 
 #ifndef RIVE_BUILD_FOR_IOS
         std::system("sh rebuild_shaders.sh /tmp/rive");
 #endif
         fiddleContext->hotloadShaders();
     }
-    fiddleContext->begin({
-        .renderTargetWidth = static_cast<uint32_t>(width),
-        .renderTargetHeight = static_cast<uint32_t>(height),
-        .clearColor = 0xff303030,
-        .msaaSampleCount = msaa,
-        .disableRasterOrdering = forceAtomicMode,
-        .wireframe = wireframe,
-        .fillsDisabled = disableFill,
-        .strokesDisabled = disableStroke,
-        .clockwiseFillOverride = clockwiseFill,
-    });
+    // Scenes are (re)made after begin(), so a frame that will make them is
+    // known here and is never trapped.
+    std::optional<AllocTrapScope> allocTrap;
+    if (trapAllocs && rivFile && !traceRecorder && artboards.size() == 1 &&
+        scenes.size() == 1 &&
+        ++framesSinceSceneChange > kTrapAllocsGraceFrames)
+    {
+        allocTrap.emplace();
+    }
+
+    frameArena.reset();
+    frameTimings = {};
+    std::fill(std::begin(framePerf), std::end(framePerf), PerfCounts());
+    PerfCounts perfMark = perfCounters.read();
+    auto phaseStart = std::chrono::steady_clock::now();
+    {
+        AllocTagScope allocTag(AllocTag::flush);
+        fiddleContext->begin({
+            .renderTargetWidth = static_cast<uint32_t>(width),
+            .renderTargetHeight = static_cast<uint32_t>(height),
+            .clearColor = 0xff303030,
+            .msaaSampleCount = msaa,
+            .disableRasterOrdering = forceAtomicMode,
+            .wireframe = wireframe,
+            .fillsDisabled = disableFill,
+            .strokesDisabled = disableStroke,
+            .clockwiseFillOverride = clockwiseFill,
+        });
+    }
+    frameTimings.ms[kDrawPhase] = elapsed_ms(phaseStart);
+    end_perf_phase(&perfMark, kDrawPhase);
 
     if (rivFile)
     {
+        phaseStart = std::chrono::steady_clock::now();
         if (artboards.size() != 1 || scenes.size() != 1)
         {
             make_scenes(width, height);
+            framesSinceSceneChange = 0;
+            hitchFrame.madeScenes = true;
             printf("Created %d scenes\n", (int)scenes.size());
         }
         else
         {
+            LP_TRACE_SCOPE("advanceAndApply");
+            AllocTagScope allocTag(AllocTag::advance);
             for (const auto& scene : scenes)
             {
                 scene->advanceAndApply(static_cast<float>(deltaSeconds));
             }
+            memcpy(hitchFrame.scene,
+                   currentSceneName,
+                   sizeof(currentSceneName));
         }
+        frameTimings.ms[kAdvancePhase] = elapsed_ms(phaseStart);
+        end_perf_phase(&perfMark, kAdvancePhase);
         // Artboard dimensions are now updated immediately when window size changes
         auto artboard = artboards.front().get();
 
@@ -674,13 +1907,30 @@ void renderFrame() {
             artboard->bounds()
         );
 
+        phaseStart = std::chrono::steady_clock::now();
+        AllocTagScope allocTag(AllocTag::draw);
+        if (traceRecorder)
+        {
+            traceRecorder->beginFrame();
+        }
+        sceneTransform = m;
         renderer->save();
         renderer->transform(m);
-        scenes.front()->draw(renderer.get());
+        {
+            LP_TRACE_SCOPE("Scene::draw");
+            scenes.front()->draw(renderer.get());
+        }
         renderer->restore();
+        if (traceRecorder)
+        {
+            traceRecorder->endFrame();
+        }
+        frameTimings.ms[kDrawPhase] += elapsed_ms(phaseStart);
+        end_perf_phase(&perfMark, kDrawPhase);
         
         static int frameCount = 0;
         if (++frameCount % 60 == 0) {
+            AllocTagScope allocTag(AllocTag::logging);
             printf("Rendered frame %d\n", frameCount);
         }
     }
@@ -692,7 +1942,34 @@ void renderFrame() {
         }
     }
 
-    fiddleContext->end(window);
+    phaseStart = std::chrono::steady_clock::now();
+    {
+        AllocTagScope allocTag(AllocTag::flush);
+        if (captureFrameCount > 0 && rivFile)
+        {
+            fiddleContext->endAsyncReadback(window);
+            ++captureRenderedFrames;
+        }
+        else
+        {
+            fiddleContext->end(window);
+        }
+    }
+    frameTimings.ms[kFlushPhase] = elapsed_ms(phaseStart);
+    end_perf_phase(&perfMark, kFlushPhase);
+    hitchFrame.acquireMs = fiddleContext->acquireWaitMs();
+    ++framesEnded;
+    allocTrap.reset();
+
+    Scene* scene = scenes.empty() ? nullptr : scenes.front().get();
+    if (inputRecorder)
+    {
+        inputRecorder->endFrame(deltaSeconds, scene);
+    }
+    else if (inputReplayer)
+    {
+        inputReplayer->syncInputs(scene);
+    }
 
     if (rivFile)
     {
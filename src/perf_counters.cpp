@@ -0,0 +1,182 @@
+#include "perf_counters.hpp"
+
+#include <cstdio>
+
+#ifdef __linux__
+#include <cerrno>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+const char* perf_counter_name(int counter)
+{
+    switch (counter)
+    {
+        case kPerfInstructions:
+            return "instructions";
+        case kPerfCycles:
+            return "cycles";
+        case kPerfCacheMisses:
+            return "cache_misses";
+        case kPerfBranchMisses:
+            return "branch_misses";
+        case kPerfContextSwitches:
+            return "context_switches";
+    }
+    return "unknown";
+}
+
+PerfCounts PerfCounts::operator-(const PerfCounts& earlier) const
+{
+    PerfCounts delta;
+    for (int i = 0; i < kPerfCounterCount; ++i)
+    {
+        delta.value[i] = value[i] - earlier.value[i];
+    }
+    return delta;
+}
+
+PerfCounts& PerfCounts::operator+=(const PerfCounts& other)
+{
+    for (int i = 0; i < kPerfCounterCount; ++i)
+    {
+        value[i] += other.value[i];
+    }
+    return *this;
+}
+
+#ifdef __linux__
+
+PerfCounterGroup::~PerfCounterGroup()
+{
+    for (int fd : m_fds)
+    {
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+    }
+}
+
+bool PerfCounterGroup::open()
+{
+    constexpr static struct
+    {
+        uint32_t type;
+        uint64_t config;
+    } kEvents[kPerfCounterCount] = {
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+        {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES},
+    };
+
+    int errors[kPerfCounterCount] = {};
+    for (int i = 0; i < kPerfCounterCount; ++i)
+    {
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = kEvents[i].type;
+        attr.config = kEvents[i].config;
+        attr.read_format = PERF_FORMAT_GROUP |
+                           PERF_FORMAT_TOTAL_TIME_ENABLED |
+                           PERF_FORMAT_TOTAL_TIME_RUNNING;
+        // User space only, so perf_event_paranoid=2 still allows it.
+        // Context switches happen in the kernel, so they can't be.
+        attr.exclude_kernel = kEvents[i].type == PERF_TYPE_HARDWARE;
+        attr.exclude_hv = 1;
+        // The leader starts disabled and enables the whole group at once.
+        attr.disabled = m_leaderFD < 0;
+        const int fd = static_cast<int>(syscall(SYS_perf_event_open,
+                                                &attr,
+                                                0,  // This thread,
+                                                -1, // on any CPU.
+                                                m_leaderFD,
+                                                0));
+        if (fd < 0)
+        {
+            errors[i] = errno;
+            continue;
+        }
+        m_fds[i] = fd;
+        m_groupIndex[i] = m_groupSize++;
+        if (m_leaderFD < 0)
+        {
+            m_leaderFD = fd;
+        }
+    }
+
+    if (m_leaderFD < 0)
+    {
+        fprintf(stderr,
+                "perf_event_open failed: %s (see "
+                "/proc/sys/kernel/perf_event_paranoid)\n",
+                strerror(errors[0]));
+        return false;
+    }
+    for (int i = 0; i < kPerfCounterCount; ++i)
+    {
+        if (m_groupIndex[i] < 0)
+        {
+            fprintf(stderr,
+                    "warning: perf counter %s is unavailable (%s)\n",
+                    perf_counter_name(i),
+                    strerror(errors[i]));
+        }
+    }
+    ioctl(m_leaderFD, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(m_leaderFD, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    return true;
+}
+
+PerfCounts PerfCounterGroup::read() const
+{
+    PerfCounts counts;
+    if (m_leaderFD < 0)
+    {
+        return counts;
+    }
+    // {nr, time_enabled, time_running, value[nr]}
+    uint64_t data[3 + kPerfCounterCount];
+    if (::read(m_leaderFD, data, sizeof(data)) <
+        static_cast<ssize_t>((3 + m_groupSize) * sizeof(uint64_t)))
+    {
+        return counts;
+    }
+    const uint64_t enabled = data[1];
+    const uint64_t running = data[2];
+    for (int i = 0; i < kPerfCounterCount; ++i)
+    {
+        if (m_groupIndex[i] < 0)
+        {
+            continue;
+        }
+        uint64_t value = data[3 + m_groupIndex[i]];
+        if (running != 0 && running < enabled)
+        {
+            value = static_cast<uint64_t>(static_cast<double>(value) *
+                                          enabled / running);
+        }
+        counts.value[i] = value;
+    }
+    return counts;
+}
+
+#else
+
+PerfCounterGroup::~PerfCounterGroup() {}
+
+bool PerfCounterGroup::open()
+{
+    fprintf(stderr, "perf counters are only supported on Linux\n");
+    return false;
+}
+
+PerfCounts PerfCounterGroup::read() const { return PerfCounts(); }
+
+#endif
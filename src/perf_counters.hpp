@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+
+// Hardware and scheduler counters for the calling thread via
+// perf_event_open (Linux only). All counters are one group, read with a
+// single syscall, so they cover exactly the same span. Counters the machine
+// lacks (VMs often expose no PMU) are left out and read as zero.
+enum PerfCounter
+{
+    kPerfInstructions,
+    kPerfCycles,
+    kPerfCacheMisses,
+    kPerfBranchMisses,
+    kPerfContextSwitches,
+    kPerfCounterCount,
+};
+
+const char* perf_counter_name(int counter);
+
+struct PerfCounts
+{
+    uint64_t value[kPerfCounterCount] = {};
+
+    PerfCounts operator-(const PerfCounts& earlier) const;
+    PerfCounts& operator+=(const PerfCounts&);
+};
+
+class PerfCounterGroup
+{
+public:
+    PerfCounterGroup() = default;
+    ~PerfCounterGroup();
+
+    PerfCounterGroup(const PerfCounterGroup&) = delete;
+    PerfCounterGroup& operator=(const PerfCounterGroup&) = delete;
+
+    // Opens and starts the group for this thread. Prints why and returns
+    // false when no counter could be opened.
+    bool open();
+    bool isOpen() const { return m_leaderFD >= 0; }
+    bool has(int counter) const { return m_groupIndex[counter] >= 0; }
+
+    // Counts since open(), scaled up if the kernel had to multiplex the
+    // group off the PMU part of the time.
+    PerfCounts read() const;
+
+private:
+    int m_leaderFD = -1;
+    int m_fds[kPerfCounterCount] = {-1, -1, -1, -1, -1};
+    // Position of each counter in the group read, or -1 if unavailable.
+    int m_groupIndex[kPerfCounterCount] = {-1, -1, -1, -1, -1};
+    int m_groupSize = 0;
+};
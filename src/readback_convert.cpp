@@ -0,0 +1,297 @@
+#include "readback_convert.hpp"
+
+#include "cpu_features.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// All kernels unpremultiply as round(c * (255 / a)) in single precision with
+// round-half-to-even, so every ISA produces bit-identical output. Opaque
+// pixels are left untouched, and a == 0 yields transparent black.
+
+using ConvertRowFn = void (*)(uint8_t* dst,
+                              const uint8_t* src,
+                              uint32_t width,
+                              uint32_t conversions);
+
+static uint8_t unpremultiply_channel(uint8_t c, uint8_t a)
+{
+    if (a == 0)
+    {
+        return 0;
+    }
+    float scale = 255.f / a;
+    return static_cast<uint8_t>(
+        std::min(255.f, std::nearbyint(static_cast<float>(c) * scale)));
+}
+
+static void convert_row_scalar(uint8_t* dst,
+                               const uint8_t* src,
+                               uint32_t width,
+                               uint32_t conversions)
+{
+    const int r = (conversions & kReadbackSwizzleRB) ? 2 : 0;
+    const int b = 2 - r;
+    const bool unpremultiply = conversions & kReadbackUnpremultiply;
+    for (uint32_t x = 0; x < width; ++x, src += 4, dst += 4)
+    {
+        uint8_t a = src[3];
+        uint8_t px[4] = {src[r], src[1], src[b], a};
+        if (unpremultiply && a != 255)
+        {
+            px[0] = unpremultiply_channel(px[0], a);
+            px[1] = unpremultiply_channel(px[1], a);
+            px[2] = unpremultiply_channel(px[2], a);
+        }
+        memcpy(dst, px, 4);
+    }
+}
+
+#ifdef LP_X86
+LP_TARGET_SSE41 static __m128i unpremultiply_1px_sse41(__m128 px)
+{
+    const __m128 alpha = _mm_shuffle_ps(px, px, _MM_SHUFFLE(3, 3, 3, 3));
+    __m128 scale = _mm_div_ps(_mm_set1_ps(255.f), alpha);
+    scale = _mm_and_ps(scale, _mm_cmpgt_ps(alpha, _mm_setzero_ps()));
+    // Keep the original alpha in lane 3.
+    return _mm_cvtps_epi32(_mm_blend_ps(_mm_mul_ps(px, scale), px, 0x8));
+}
+
+LP_TARGET_SSE41 static __m128i unpremultiply_4px_sse41(__m128i px)
+{
+    __m128i p0 = unpremultiply_1px_sse41(
+        _mm_cvtepi32_ps(_mm_cvtepu8_epi32(px)));
+    __m128i p1 = unpremultiply_1px_sse41(
+        _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_srli_si128(px, 4))));
+    __m128i p2 = unpremultiply_1px_sse41(
+        _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_srli_si128(px, 8))));
+    __m128i p3 = unpremultiply_1px_sse41(
+        _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_srli_si128(px, 12))));
+    return _mm_packus_epi16(_mm_packs_epi32(p0, p1), _mm_packs_epi32(p2, p3));
+}
+
+LP_TARGET_SSE41 static void convert_row_sse41(uint8_t* dst,
+                                              const uint8_t* src,
+                                              uint32_t width,
+                                              uint32_t conversions)
+{
+    const bool swizzle = conversions & kReadbackSwizzleRB;
+    const bool unpremultiply = conversions & kReadbackUnpremultiply;
+    const __m128i swizzleMask =
+        _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+    const __m128i allOnes = _mm_set1_epi8(-1);
+    uint32_t x = 0;
+    for (; x + 4 <= width; x += 4, src += 16, dst += 16)
+    {
+        __m128i px = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+        if (swizzle)
+        {
+            px = _mm_shuffle_epi8(px, swizzleMask);
+        }
+        if (unpremultiply &&
+            (_mm_movemask_epi8(_mm_cmpeq_epi8(px, allOnes)) & 0x8888) != 0x8888)
+        {
+            px = unpremultiply_4px_sse41(px);
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), px);
+    }
+    convert_row_scalar(dst, src, width - x, conversions);
+}
+
+LP_TARGET_AVX2 static __m256i unpremultiply_2px_avx2(__m128i px)
+{
+    const __m256 p = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(px));
+    const __m256 alpha = _mm256_shuffle_ps(p, p, _MM_SHUFFLE(3, 3, 3, 3));
+    __m256 scale = _mm256_div_ps(_mm256_set1_ps(255.f), alpha);
+    scale = _mm256_and_ps(
+        scale,
+        _mm256_cmp_ps(alpha, _mm256_setzero_ps(), _CMP_GT_OQ));
+    return _mm256_cvtps_epi32(
+        _mm256_blend_ps(_mm256_mul_ps(p, scale), p, 0x88));
+}
+
+LP_TARGET_AVX2 static __m256i unpremultiply_8px_avx2(__m256i px)
+{
+    const __m128i lo = _mm256_castsi256_si128(px);
+    const __m128i hi = _mm256_extracti128_si256(px, 1);
+    // Each result holds two pixels, one per 128-bit lane.
+    __m256i p01 = unpremultiply_2px_avx2(lo);
+    __m256i p23 = unpremultiply_2px_avx2(_mm_srli_si128(lo, 8));
+    __m256i p45 = unpremultiply_2px_avx2(hi);
+    __m256i p67 = unpremultiply_2px_avx2(_mm_srli_si128(hi, 8));
+    // The in-lane packs leave pixels ordered 0,2,4,6 | 1,3,5,7.
+    __m256i packed =
+        _mm256_packus_epi16(_mm256_packs_epi32(p01, p23),
+                            _mm256_packs_epi32(p45, p67));
+    return _mm256_permutevar8x32_epi32(
+        packed,
+        _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7));
+}
+
+LP_TARGET_AVX2 static void convert_row_avx2(uint8_t* dst,
+                                            const uint8_t* src,
+                                            uint32_t width,
+                                            uint32_t conversions)
+{
+    const bool swizzle = conversions & kReadbackSwizzleRB;
+    const bool unpremultiply = conversions & kReadbackUnpremultiply;
+    const __m256i swizzleMask = _mm256_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7,
+                                                 10, 9, 8, 11, 14, 13, 12, 15,
+                                                 2, 1, 0, 3, 6, 5, 4, 7,
+                                                 10, 9, 8, 11, 14, 13, 12, 15);
+    const __m256i allOnes = _mm256_set1_epi8(-1);
+    uint32_t x = 0;
+    for (; x + 8 <= width; x += 8, src += 32, dst += 32)
+    {
+        __m256i px =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src));
+        if (swizzle)
+        {
+            px = _mm256_shuffle_epi8(px, swizzleMask);
+        }
+        if (unpremultiply &&
+            (static_cast<uint32_t>(
+                 _mm256_movemask_epi8(_mm256_cmpeq_epi8(px, allOnes))) &
+             0x88888888u) != 0x88888888u)
+        {
+            px = unpremultiply_8px_avx2(px);
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), px);
+    }
+    convert_row_scalar(dst, src, width - x, conversions);
+}
+#endif
+
+#ifdef LP_ARM_NEON
+static uint8x16_t unpremultiply_channel_neon(uint8x16_t c,
+                                             const float32x4_t scale[4])
+{
+    uint16x8_t lo = vmovl_u8(vget_low_u8(c));
+    uint16x8_t hi = vmovl_u8(vget_high_u8(c));
+    float32x4_t f[4] = {
+        vcvtq_f32_u32(vmovl_u16(vget_low_u16(lo))),
+        vcvtq_f32_u32(vmovl_u16(vget_high_u16(lo))),
+        vcvtq_f32_u32(vmovl_u16(vget_low_u16(hi))),
+        vcvtq_f32_u32(vmovl_u16(vget_high_u16(hi))),
+    };
+    uint32x4_t u[4];
+    for (int i = 0; i < 4; ++i)
+    {
+        // Round to nearest, ties to even; saturates like the x86 packs.
+        u[i] = vcvtnq_u32_f32(vmulq_f32(f[i], scale[i]));
+    }
+    uint16x8_t lo16 = vcombine_u16(vqmovn_u32(u[0]), vqmovn_u32(u[1]));
+    uint16x8_t hi16 = vcombine_u16(vqmovn_u32(u[2]), vqmovn_u32(u[3]));
+    return vcombine_u8(vqmovn_u16(lo16), vqmovn_u16(hi16));
+}
+
+static void convert_row_neon(uint8_t* dst,
+                             const uint8_t* src,
+                             uint32_t width,
+                             uint32_t conversions)
+{
+    const bool swizzle = conversions & kReadbackSwizzleRB;
+    const bool unpremultiply = conversions & kReadbackUnpremultiply;
+    uint32_t x = 0;
+    for (; x + 16 <= width; x += 16, src += 64, dst += 64)
+    {
+        // De-interleaving load: the swizzle is free on store.
+        uint8x16x4_t px = vld4q_u8(src);
+        if (swizzle)
+        {
+            std::swap(px.val[0], px.val[2]);
+        }
+        if (unpremultiply && vminvq_u8(px.val[3]) != 255)
+        {
+            uint16x8_t alo = vmovl_u8(vget_low_u8(px.val[3]));
+            uint16x8_t ahi = vmovl_u8(vget_high_u8(px.val[3]));
+            float32x4_t alpha[4] = {
+                vcvtq_f32_u32(vmovl_u16(vget_low_u16(alo))),
+                vcvtq_f32_u32(vmovl_u16(vget_high_u16(alo))),
+                vcvtq_f32_u32(vmovl_u16(vget_low_u16(ahi))),
+                vcvtq_f32_u32(vmovl_u16(vget_high_u16(ahi))),
+            };
+            float32x4_t scale[4];
+            for (int i = 0; i < 4; ++i)
+            {
+                uint32x4_t nonzero = vcgtq_f32(alpha[i], vdupq_n_f32(0));
+                scale[i] = vreinterpretq_f32_u32(vandq_u32(
+                    vreinterpretq_u32_f32(
+                        vdivq_f32(vdupq_n_f32(255.f), alpha[i])),
+                    nonzero));
+            }
+            for (int c = 0; c < 3; ++c)
+            {
+                px.val[c] = unpremultiply_channel_neon(px.val[c], scale);
+            }
+        }
+        vst4q_u8(dst, px);
+    }
+    convert_row_scalar(dst, src, width - x, conversions);
+}
+#endif
+
+struct ConvertKernel
+{
+    ConvertRowFn convertRow;
+    const char* name;
+};
+
+static ConvertKernel select_kernel()
+{
+    const CPUFeatures& features = cpu_features();
+#ifdef LP_X86
+    if (features.avx2)
+    {
+        return {convert_row_avx2, "avx2"};
+    }
+    if (features.sse41)
+    {
+        return {convert_row_sse41, "sse4.1"};
+    }
+#endif
+#ifdef LP_ARM_NEON
+    if (features.neon)
+    {
+        return {convert_row_neon, "neon"};
+    }
+#endif
+    (void)features;
+    return {convert_row_scalar, "scalar"};
+}
+
+static const ConvertKernel& kernel()
+{
+    static const ConvertKernel selected = select_kernel();
+    return selected;
+}
+
+void convert_readback(uint8_t* dst,
+                      size_t dstRowBytes,
+                      const uint8_t* src,
+                      size_t srcRowBytes,
+                      uint32_t width,
+                      uint32_t height,
+                      uint32_t conversions)
+{
+    const bool flipY = conversions & kReadbackFlipY;
+    const bool rowCopyOnly =
+        (conversions & (kReadbackSwizzleRB | kReadbackUnpremultiply)) == 0;
+    const ConvertRowFn convertRow = kernel().convertRow;
+    for (uint32_t y = 0; y < height; ++y)
+    {
+        const uint8_t* srcRow = src + srcRowBytes * y;
+        uint8_t* dstRow = dst + dstRowBytes * (flipY ? height - 1 - y : y);
+        if (rowCopyOnly)
+        {
+            memcpy(dstRow, srcRow, width * 4);
+        }
+        else
+        {
+            convertRow(dstRow, srcRow, width, conversions);
+        }
+    }
+}
+
+const char* readback_convert_kernel_name() { return kernel().name; }
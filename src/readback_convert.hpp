@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Fixes up read-back pixels in a single pass over the buffer. Each backend
+// reads its render target back in its own layout (BGRA swapchains, top-down
+// vs. bottom-up rows, driver row pitch); this normalizes them, picking an
+// AVX2, SSE4.1 or NEON kernel at runtime.
+enum ReadbackConversion : uint32_t
+{
+    // Swap the R and B channels (BGRA <-> RGBA).
+    kReadbackSwizzleRB = 1 << 0,
+    // Write source row 0 to the last destination row.
+    kReadbackFlipY = 1 << 1,
+    // Divide color by alpha (premultiplied -> straight alpha).
+    kReadbackUnpremultiply = 1 << 2,
+};
+
+// Converts a width x height block of 4-byte pixels. The source and
+// destination may use different row pitches but must not overlap.
+void convert_readback(uint8_t* dst,
+                      size_t dstRowBytes,
+                      const uint8_t* src,
+                      size_t srcRowBytes,
+                      uint32_t width,
+                      uint32_t height,
+                      uint32_t conversions);
+
+// Name of the kernel convert_readback() dispatches to on this machine.
+const char* readback_convert_kernel_name();
@@ -0,0 +1,1434 @@
+#include "render_trace.hpp"
+
+#include "rive/math/raw_path.hpp"
+
+#include <cstring>
+#include <type_traits>
+
+using namespace rive;
+
+namespace
+{
+constexpr char kTraceMagic[8] = {'L', 'P', 'T', 'R', 'A', 'C', 'E', '1'};
+
+// Header: magic, then width, height and frame count as uint32.
+constexpr long kHeaderSizeOffset = sizeof(kTraceMagic);
+
+enum class Op : uint8_t
+{
+    beginFrame,
+    endFrame,
+    // id, then the object's contents.
+    definePath,
+    definePaint,
+    defineShader,
+    defineImage,
+    defineBuffer,
+    // id
+    releasePath,
+    releasePaint,
+    releaseShader,
+    releaseImage,
+    releaseBuffer,
+    save,
+    restore,
+    transform,
+    clipPath,
+    drawPath,
+    drawImage,
+    drawImageMesh,
+};
+
+enum class ShaderType : uint8_t
+{
+    linear,
+    radial,
+};
+
+// Objects of each kind get ids from their own sequence, starting at 1.
+enum ObjectKind
+{
+    kPathKind,
+    kPaintKind,
+    kShaderKind,
+    kImageKind,
+    kBufferKind,
+    kObjectKindCount,
+};
+} // namespace
+
+class RenderTraceWriter
+{
+public:
+    RenderTraceWriter(FILE* file) : m_file(file)
+    {
+        write(kTraceMagic, sizeof(kTraceMagic));
+        uint32_t placeholder[3] = {};
+        write(placeholder, sizeof(placeholder));
+    }
+
+    ~RenderTraceWriter() { close(); }
+
+    // Draws and definitions are only serialized inside a recorded frame.
+    bool isRecording() const { return m_file != nullptr && m_inFrame; }
+    bool isOpen() const { return m_file != nullptr; }
+
+    void setInFrame(bool inFrame) { m_inFrame = inFrame; }
+    void setSize(uint32_t width, uint32_t height)
+    {
+        m_width = width;
+        m_height = height;
+    }
+    void countFrame() { ++m_frameCount; }
+
+    uint32_t nextId(ObjectKind kind) { return ++m_lastIds[kind]; }
+
+    void op(Op value) { pod(value); }
+
+    template <typename T> void pod(const T& value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        write(&value, sizeof(T));
+    }
+
+    void write(const void* data, size_t size)
+    {
+        if (m_file != nullptr && size != 0)
+        {
+            fwrite(data, 1, size, m_file);
+        }
+    }
+
+    void close()
+    {
+        if (m_file == nullptr)
+        {
+            return;
+        }
+        uint32_t header[3] = {m_width, m_height, m_frameCount};
+        fseek(m_file, kHeaderSizeOffset, SEEK_SET);
+        fwrite(header, sizeof(header), 1, m_file);
+        fclose(m_file);
+        m_file = nullptr;
+        printf("Recorded %u frames of draw commands\n", m_frameCount);
+    }
+
+private:
+    FILE* m_file;
+    bool m_inFrame = false;
+    uint32_t m_width = 0;
+    uint32_t m_height = 0;
+    uint32_t m_frameCount = 0;
+    uint32_t m_lastIds[kObjectKindCount] = {};
+};
+
+namespace
+{
+// Bookkeeping shared by every traced object: its id, and whether the trace
+// already holds its current contents.
+class TracedObject
+{
+public:
+    TracedObject(std::shared_ptr<RenderTraceWriter> writer,
+                 ObjectKind kind,
+                 Op releaseOp) :
+        m_writer(std::move(writer)),
+        m_id(m_writer->nextId(kind)),
+        m_releaseOp(releaseOp)
+    {}
+
+    ~TracedObject()
+    {
+        if (m_emittedVersion != 0 && m_writer->isOpen())
+        {
+            m_writer->op(m_releaseOp);
+            m_writer->pod(m_id);
+        }
+    }
+
+    uint32_t id() const { return m_id; }
+
+protected:
+    void changed() { ++m_version; }
+    // True (once per change) when the definition must be (re)written.
+    bool needsDefinition()
+    {
+        if (!m_writer->isRecording() || m_emittedVersion == m_version)
+        {
+            return false;
+        }
+        m_emittedVersion = m_version;
+        return true;
+    }
+
+    const std::shared_ptr<RenderTraceWriter> m_writer;
+
+private:
+    const uint32_t m_id;
+    const Op m_releaseOp;
+    uint64_t m_version = 1;
+    uint64_t m_emittedVersion = 0;
+};
+
+class TracedRenderPath : public RenderPath, public TracedObject
+{
+public:
+    TracedRenderPath(std::shared_ptr<RenderTraceWriter> writer,
+                     rcp<RenderPath> inner,
+                     RawPath rawPath,
+                     FillRule fillRule) :
+        TracedObject(std::move(writer), kPathKind, Op::releasePath),
+        m_inner(std::move(inner)),
+        m_rawPath(std::move(rawPath)),
+        m_fillRule(fillRule)
+    {}
+
+    RenderPath* inner() const { return m_inner.get(); }
+
+    void rewind() override
+    {
+        m_inner->rewind();
+        m_rawPath.rewind();
+        changed();
+    }
+    void fillRule(FillRule value) override
+    {
+        m_inner->fillRule(value);
+        m_fillRule = value;
+        changed();
+    }
+    void moveTo(float x, float y) override
+    {
+        m_inner->moveTo(x, y);
+        m_rawPath.moveTo(x, y);
+        changed();
+    }
+    void lineTo(float x, float y) override
+    {
+        m_inner->lineTo(x, y);
+        m_rawPath.lineTo(x, y);
+        changed();
+    }
+    void cubicTo(float ox, float oy, float ix, float iy, float x, float y)
+        override
+    {
+        m_inner->cubicTo(ox, oy, ix, iy, x, y);
+        m_rawPath.cubicTo(ox, oy, ix, iy, x, y);
+        changed();
+    }
+    void close() override
+    {
+        m_inner->close();
+        m_rawPath.close();
+        changed();
+    }
+    void addRenderPath(RenderPath* path, const Mat2D& matrix) override
+    {
+        auto* traced = static_cast<TracedRenderPath*>(path);
+        m_inner->addRenderPath(traced->m_inner.get(), matrix);
+        m_rawPath.addPath(traced->m_rawPath, &matrix);
+        changed();
+    }
+    void addRawPath(const RawPath& path) override
+    {
+        m_inner->addRawPath(path);
+        m_rawPath.addPath(path);
+        changed();
+    }
+
+    void define()
+    {
+        if (!needsDefinition())
+        {
+            return;
+        }
+        Span<const PathVerb> verbs = m_rawPath.verbs();
+        Span<const Vec2D> points = m_rawPath.points();
+        m_writer->op(Op::definePath);
+        m_writer->pod(id());
+        m_writer->pod(static_cast<uint8_t>(m_fillRule));
+        m_writer->pod(static_cast<uint32_t>(verbs.size()));
+        m_writer->pod(static_cast<uint32_t>(points.size()));
+        m_writer->write(verbs.data(), verbs.size() * sizeof(PathVerb));
+        m_writer->write(points.data(), points.size() * sizeof(Vec2D));
+    }
+
+private:
+    const rcp<RenderPath> m_inner;
+    RawPath m_rawPath;
+    FillRule m_fillRule;
+};
+
+class TracedRenderShader : public RenderShader, public TracedObject
+{
+public:
+    TracedRenderShader(std::shared_ptr<RenderTraceWriter> writer,
+                       rcp<RenderShader> inner,
+                       ShaderType type,
+                       const float (&params)[4],
+                       const ColorInt colors[],
+                       const float stops[],
+                       size_t count) :
+        TracedObject(std::move(writer), kShaderKind, Op::releaseShader),
+        m_inner(std::move(inner)),
+        m_type(type),
+        m_colors(colors, colors + count),
+        m_stops(stops, stops + count)
+    {
+        memcpy(m_params, params, sizeof(m_params));
+    }
+
+    RenderShader* inner() const { return m_inner.get(); }
+
+    void define()
+    {
+        if (!needsDefinition())
+        {
+            return;
+        }
+        m_writer->op(Op::defineShader);
+        m_writer->pod(id());
+        m_writer->pod(m_type);
+        m_writer->pod(m_params);
+        m_writer->pod(static_cast<uint32_t>(m_colors.size()));
+        m_writer->write(m_colors.data(), m_colors.size() * sizeof(ColorInt));
+        m_writer->write(m_stops.data(), m_stops.size() * sizeof(float));
+    }
+
+private:
+    const rcp<RenderShader> m_inner;
+    const ShaderType m_type;
+    float m_params[4];
+    const std::vector<ColorInt> m_colors;
+    const std::vector<float> m_stops;
+};
+
+class TracedRenderPaint : public RenderPaint, public TracedObject
+{
+public:
+    TracedRenderPaint(std::shared_ptr<RenderTraceWriter> writer,
+                      rcp<RenderPaint> inner) :
+        TracedObject(std::move(writer), kPaintKind, Op::releasePaint),
+        m_inner(std::move(inner))
+    {}
+
+    RenderPaint* inner() const { return m_inner.get(); }
+
+    void style(RenderPaintStyle value) override
+    {
+        m_inner->style(value);
+        m_style = value;
+        changed();
+    }
+    void color(ColorInt value) override
+    {
+        m_inner->color(value);
+        m_color = value;
+        changed();
+    }
+    void thickness(float value) override
+    {
+        m_inner->thickness(value);
+        m_thickness = value;
+        changed();
+    }
+    void join(StrokeJoin value) override
+    {
+        m_inner->join(value);
+        m_join = value;
+        changed();
+    }
+    void cap(StrokeCap value) override
+    {
+        m_inner->cap(value);
+        m_cap = value;
+        changed();
+    }
+    void feather(float value) override
+    {
+        m_inner->feather(value);
+        m_feather = value;
+        changed();
+    }
+    void blendMode(BlendMode value) override
+    {
+        m_inner->blendMode(value);
+        m_blendMode = value;
+        changed();
+    }
+    void shader(rcp<RenderShader> value) override
+    {
+        m_shader = ref_rcp(static_cast<TracedRenderShader*>(value.get()));
+        m_inner->shader(m_shader ? ref_rcp(m_shader->inner())
+                                 : rcp<RenderShader>());
+        changed();
+    }
+    void invalidateStroke() override { m_inner->invalidateStroke(); }
+
+    void define()
+    {
+        if (m_shader)
+        {
+            m_shader->define();
+        }
+        if (!needsDefinition())
+        {
+            return;
+        }
+        m_writer->op(Op::definePaint);
+        m_writer->pod(id());
+        m_writer->pod(static_cast<uint8_t>(m_style));
+        m_writer->pod(m_color);
+        m_writer->pod(m_thickness);
+        m_writer->pod(static_cast<uint8_t>(m_join));
+        m_writer->pod(static_cast<uint8_t>(m_cap));
+        m_writer->pod(m_feather);
+        m_writer->pod(static_cast<uint8_t>(m_blendMode));
+        m_writer->pod(m_shader ? m_shader->id() : 0u);
+    }
+
+private:
+    const rcp<RenderPaint> m_inner;
+    RenderPaintStyle m_style = RenderPaintStyle::fill;
+    ColorInt m_color = 0xff000000;
+    float m_thickness = 1;
+    StrokeJoin m_join = StrokeJoin::miter;
+    StrokeCap m_cap = StrokeCap::butt;
+    float m_feather = 0;
+    BlendMode m_blendMode = BlendMode::srcOver;
+    rcp<TracedRenderShader> m_shader;
+};
+
+class TracedRenderImage : public RenderImage, public TracedObject
+{
+public:
+    TracedRenderImage(std::shared_ptr<RenderTraceWriter> writer,
+                      rcp<RenderImage> inner,
+                      Span<const uint8_t> encodedBytes) :
+        RenderImage(inner->uvTransform()),
+        TracedObject(std::move(writer), kImageKind, Op::releaseImage),
+        m_inner(std::move(inner)),
+        m_encodedBytes(encodedBytes.data(),
+                       encodedBytes.data() + encodedBytes.size())
+    {
+        m_Width = m_inner->width();
+        m_Height = m_inner->height();
+    }
+
+    const RenderImage* inner() const { return m_inner.get(); }
+
+    // Images are stored encoded; playback decodes them with its own factory.
+    void define()
+    {
+        if (!needsDefinition())
+        {
+            return;
+        }
+        m_writer->op(Op::defineImage);
+        m_writer->pod(id());
+        m_writer->pod(static_cast<uint32_t>(m_encodedBytes.size()));
+        m_writer->write(m_encodedBytes.data(), m_encodedBytes.size());
+    }
+
+private:
+    const rcp<RenderImage> m_inner;
+    const std::vector<uint8_t> m_encodedBytes;
+};
+
+// Keeps a CPU copy of the contents so they can be written to the trace.
+class TracedRenderBuffer : public RenderBuffer, public TracedObject
+{
+public:
+    TracedRenderBuffer(std::shared_ptr<RenderTraceWriter> writer,
+                       rcp<RenderBuffer> inner,
+                       RenderBufferType type,
+                       RenderBufferFlags flags,
+                       size_t sizeInBytes) :
+        RenderBuffer(type, flags, sizeInBytes),
+        TracedObject(std::move(writer), kBufferKind, Op::releaseBuffer),
+        m_inner(std::move(inner)),
+        m_contents(sizeInBytes)
+    {}
+
+    rcp<RenderBuffer> inner() const { return m_inner; }
+
+    void define()
+    {
+        if (!needsDefinition())
+        {
+            return;
+        }
+        m_writer->op(Op::defineBuffer);
+        m_writer->pod(id());
+        m_writer->pod(static_cast<uint8_t>(type()));
+        m_writer->pod(static_cast<uint8_t>(flags()));
+        m_writer->pod(static_cast<uint32_t>(m_contents.size()));
+        m_writer->write(m_contents.data(), m_contents.size());
+    }
+
+protected:
+    void* onMap() override { return m_contents.data(); }
+    void onUnmap() override
+    {
+        memcpy(m_inner->map(), m_contents.data(), m_contents.size());
+        m_inner->unmap();
+        changed();
+    }
+
+private:
+    const rcp<RenderBuffer> m_inner;
+    std::vector<uint8_t> m_contents;
+};
+
+class TracingFactory : public Factory
+{
+public:
+    TracingFactory(std::shared_ptr<RenderTraceWriter> writer, Factory* inner) :
+        m_writer(std::move(writer)), m_inner(inner)
+    {}
+
+    rcp<RenderBuffer> makeRenderBuffer(RenderBufferType type,
+                                       RenderBufferFlags flags,
+                                       size_t sizeInBytes) override
+    {
+        rcp<RenderBuffer> inner =
+            m_inner->makeRenderBuffer(type, flags, sizeInBytes);
+        if (!inner)
+        {
+            return nullptr;
+        }
+        return make_rcp<TracedRenderBuffer>(m_writer,
+                                            std::move(inner),
+                                            type,
+                                            flags,
+                                            sizeInBytes);
+    }
+
+    rcp<RenderShader> makeLinearGradient(float sx,
+                                         float sy,
+                                         float ex,
+                                         float ey,
+                                         const ColorInt colors[],
+                                         const float stops[],
+                                         size_t count) override
+    {
+        rcp<RenderShader> inner =
+            m_inner->makeLinearGradient(sx, sy, ex, ey, colors, stops, count);
+        if (!inner)
+        {
+            return nullptr;
+        }
+        const float params[4] = {sx, sy, ex, ey};
+        return make_rcp<TracedRenderShader>(m_writer,
+                                            std::move(inner),
+                                            ShaderType::linear,
+                                            params,
+                                            colors,
+                                            stops,
+                                            count);
+    }
+
+    rcp<RenderShader> makeRadialGradient(float cx,
+                                         float cy,
+                                         float radius,
+                                         const ColorInt colors[],
+                                         const float stops[],
+                                         size_t count) override
+    {
+        rcp<RenderShader> inner =
+            m_inner->makeRadialGradient(cx, cy, radius, colors, stops, count);
+        if (!inner)
+        {
+            return nullptr;
+        }
+        const float params[4] = {cx, cy, radius, 0};
+        return make_rcp<TracedRenderShader>(m_writer,
+                                            std::move(inner),
+                                            ShaderType::radial,
+                                            params,
+                                            colors,
+                                            stops,
+                                            count);
+    }
+
+    rcp<RenderPath> makeRenderPath(RawPath& rawPath, FillRule fillRule) override
+    {
+        // The inner factory may steal rawPath's storage; copy it first.
+        RawPath copy = rawPath;
+        return make_rcp<TracedRenderPath>(
+            m_writer,
+            m_inner->makeRenderPath(rawPath, fillRule),
+            std::move(copy),
+            fillRule);
+    }
+
+    rcp<RenderPath> makeEmptyRenderPath() override
+    {
+        return make_rcp<TracedRenderPath>(m_writer,
+                                          m_inner->makeEmptyRenderPath(),
+                                          RawPath(),
+                                          FillRule::nonZero);
+    }
+
+    rcp<RenderPaint> makeRenderPaint() override
+    {
+        return make_rcp<TracedRenderPaint>(m_writer,
+                                           m_inner->makeRenderPaint());
+    }
+
+    rcp<RenderImage> decodeImage(Span<const uint8_t> encodedBytes) override
+    {
+        rcp<RenderImage> inner = m_inner->decodeImage(encodedBytes);
+        if (!inner)
+        {
+            return nullptr;
+        }
+        return make_rcp<TracedRenderImage>(m_writer,
+                                           std::move(inner),
+                                           encodedBytes);
+    }
+
+private:
+    const std::shared_ptr<RenderTraceWriter> m_writer;
+    Factory* const m_inner;
+};
+
+class TracingRenderer : public Renderer
+{
+public:
+    TracingRenderer(std::shared_ptr<RenderTraceWriter> writer,
+                    std::unique_ptr<Renderer> inner) :
+        m_writer(std::move(writer)), m_inner(std::move(inner))
+    {}
+
+    void save() override
+    {
+        m_inner->save();
+        if (m_writer->isRecording())
+        {
+            m_writer->op(Op::save);
+        }
+    }
+
+    void restore() override
+    {
+        m_inner->restore();
+        if (m_writer->isRecording())
+        {
+            m_writer->op(Op::restore);
+        }
+    }
+
+    void transform(const Mat2D& matrix) override
+    {
+        m_inner->transform(matrix);
+        if (m_writer->isRecording())
+        {
+            m_writer->op(Op::transform);
+            for (int i = 0; i < 6; ++i)
+            {
+                m_writer->pod(matrix[i]);
+            }
+        }
+    }
+
+    void clipPath(RenderPath* path) override
+    {
+        auto* tracedPath = static_cast<TracedRenderPath*>(path);
+        m_inner->clipPath(tracedPath->inner());
+        if (m_writer->isRecording())
+        {
+            tracedPath->define();
+            m_writer->op(Op::clipPath);
+            m_writer->pod(tracedPath->id());
+        }
+    }
+
+    void drawPath(RenderPath* path, RenderPaint* paint) override
+    {
+        auto* tracedPath = static_cast<TracedRenderPath*>(path);
+        auto* tracedPaint = static_cast<TracedRenderPaint*>(paint);
+        m_inner->drawPath(tracedPath->inner(), tracedPaint->inner());
+        if (m_writer->isRecording())
+        {
+            tracedPath->define();
+            tracedPaint->define();
+            m_writer->op(Op::drawPath);
+            m_writer->pod(tracedPath->id());
+            m_writer->pod(tracedPaint->id());
+        }
+    }
+
+    void drawImage(const RenderImage* image,
+                   ImageSampler sampler,
+                   BlendMode blendMode,
+                   float opacity) override
+    {
+        auto* tracedImage =
+            const_cast<TracedRenderImage*>(
+                static_cast<const TracedRenderImage*>(image));
+        m_inner->drawImage(tracedImage->inner(), sampler, blendMode, opacity);
+        if (m_writer->isRecording())
+        {
+            tracedImage->define();
+            m_writer->op(Op::drawImage);
+            m_writer->pod(tracedImage->id());
+            m_writer->pod(sampler);
+            m_writer->pod(static_cast<uint8_t>(blendMode));
+            m_writer->pod(opacity);
+        }
+    }
+
+    void drawImageMesh(const RenderImage* image,
+                       ImageSampler sampler,
+                       rcp<RenderBuffer> vertices_f32,
+                       rcp<RenderBuffer> uvCoords_f32,
+                       rcp<RenderBuffer> indices_u16,
+                       uint32_t vertexCount,
+                       uint32_t indexCount,
+                       BlendMode blendMode,
+                       float opacity) override
+    {
+        auto* tracedImage =
+            const_cast<TracedRenderImage*>(
+                static_cast<const TracedRenderImage*>(image));
+        TracedRenderBuffer* buffers[3] = {
+            static_cast<TracedRenderBuffer*>(vertices_f32.get()),
+            static_cast<TracedRenderBuffer*>(uvCoords_f32.get()),
+            static_cast<TracedRenderBuffer*>(indices_u16.get()),
+        };
+        m_inner->drawImageMesh(tracedImage->inner(),
+                               sampler,
+                               buffers[0]->inner(),
+                               buffers[1]->inner(),
+                               buffers[2]->inner(),
+                               vertexCount,
+                               indexCount,
+                               blendMode,
+                               opacity);
+        if (m_writer->isRecording())
+        {
+            tracedImage->define();
+            for (TracedRenderBuffer* buffer : buffers)
+            {
+                buffer->define();
+            }
+            m_writer->op(Op::drawImageMesh);
+            m_writer->pod(tracedImage->id());
+            m_writer->pod(sampler);
+            for (TracedRenderBuffer* buffer : buffers)
+            {
+                m_writer->pod(buffer->id());
+            }
+            m_writer->pod(vertexCount);
+            m_writer->pod(indexCount);
+            m_writer->pod(static_cast<uint8_t>(blendMode));
+            m_writer->pod(opacity);
+        }
+    }
+
+private:
+    const std::shared_ptr<RenderTraceWriter> m_writer;
+    const std::unique_ptr<Renderer> m_inner;
+};
+} // namespace
+
+std::unique_ptr<RenderTraceRecorder> RenderTraceRecorder::Open(
+    const char* path,
+    Factory* factory,
+    int maxFrames)
+{
+    FILE* file = fopen(path, "wb");
+    if (file == nullptr)
+    {
+        fprintf(stderr, "Failed to open %s for writing\n", path);
+        return nullptr;
+    }
+    return std::unique_ptr<RenderTraceRecorder>(new RenderTraceRecorder(
+        std::make_shared<RenderTraceWriter>(file),
+        factory,
+        maxFrames));
+}
+
+RenderTraceRecorder::RenderTraceRecorder(
+    std::shared_ptr<RenderTraceWriter> writer,
+    Factory* factory,
+    int maxFrames) :
+    m_writer(std::move(writer)),
+    m_factory(std::make_unique<TracingFactory>(m_writer, factory)),
+    m_maxFrames(maxFrames)
+{}
+
+RenderTraceRecorder::~RenderTraceRecorder() { finish(); }
+
+std::unique_ptr<Renderer> RenderTraceRecorder::wrapRenderer(
+    std::unique_ptr<Renderer> renderer,
+    uint32_t width,
+    uint32_t height)
+{
+    m_writer->setSize(width, height);
+    return std::make_unique<TracingRenderer>(m_writer, std::move(renderer));
+}
+
+void RenderTraceRecorder::beginFrame()
+{
+    if (!m_writer->isOpen())
+    {
+        return;
+    }
+    m_writer->setInFrame(true);
+    m_writer->op(Op::beginFrame);
+}
+
+void RenderTraceRecorder::endFrame()
+{
+    if (!m_writer->isRecording())
+    {
+        return;
+    }
+    m_writer->op(Op::endFrame);
+    m_writer->setInFrame(false);
+    m_writer->countFrame();
+    if (m_maxFrames > 0 && ++m_recordedFrames >= m_maxFrames)
+    {
+        finish();
+    }
+}
+
+void RenderTraceRecorder::finish()
+{
+    m_writer->setInFrame(false);
+    m_writer->close();
+}
+
+bool RenderTraceRecorder::isRecording() const { return m_writer->isOpen(); }
+
+struct RenderTracePlayer::Objects
+{
+    std::vector<rcp<RenderPath>> paths;
+    std::vector<rcp<RenderPaint>> paints;
+    std::vector<rcp<RenderShader>> shaders;
+    std::vector<rcp<RenderImage>> images;
+    std::vector<rcp<RenderBuffer>> buffers;
+    RawPath scratchPath;
+    std::vector<Vec2D> scratchPoints;
+};
+
+// Enum bytes read from a trace are checked before they're cast; anything
+// else is a corrupt trace.
+static bool is_path_verb(PathVerb verb)
+{
+    switch (verb)
+    {
+        case PathVerb::move:
+        case PathVerb::line:
+        case PathVerb::quad:
+        case PathVerb::cubic:
+        case PathVerb::close:
+            return true;
+    }
+    return false;
+}
+
+static bool is_fill_rule(uint8_t value)
+{
+    switch (static_cast<FillRule>(value))
+    {
+        case FillRule::nonZero:
+        case FillRule::evenOdd:
+        case FillRule::clockwise:
+            return true;
+    }
+    return false;
+}
+
+static bool is_blend_mode(uint8_t value)
+{
+    switch (static_cast<BlendMode>(value))
+    {
+        case BlendMode::srcOver:
+        case BlendMode::screen:
+        case BlendMode::overlay:
+        case BlendMode::darken:
+        case BlendMode::lighten:
+        case BlendMode::colorDodge:
+        case BlendMode::colorBurn:
+        case BlendMode::hardLight:
+        case BlendMode::softLight:
+        case BlendMode::difference:
+        case BlendMode::exclusion:
+        case BlendMode::multiply:
+        case BlendMode::hue:
+        case BlendMode::saturation:
+        case BlendMode::color:
+        case BlendMode::luminosity:
+            return true;
+    }
+    return false;
+}
+
+static bool is_paint_style(uint8_t value)
+{
+    return value <= static_cast<uint8_t>(RenderPaintStyle::fill);
+}
+
+static bool is_stroke_join(uint8_t value)
+{
+    return value <= static_cast<uint8_t>(StrokeJoin::bevel);
+}
+
+static bool is_stroke_cap(uint8_t value)
+{
+    return value <= static_cast<uint8_t>(StrokeCap::square);
+}
+
+static uint32_t verb_point_count(PathVerb verb)
+{
+    switch (verb)
+    {
+        case PathVerb::move:
+        case PathVerb::line:
+            return 1;
+        case PathVerb::quad:
+            return 2;
+        case PathVerb::cubic:
+            return 3;
+        case PathVerb::close:
+            return 0;
+    }
+    return 0;
+}
+
+// Ids are handed out in sequence per kind, but objects that are never drawn
+// are never written, so a trace can skip ids; a definition may only grow the
+// table up to this cap. Anything higher is a corrupt (or hostile) trace.
+constexpr static uint32_t kMaxTraceObjectId = 1 << 22;
+
+// The slot a definition fills in, or null if the id is out of range.
+template <typename T>
+static rcp<T>* define_slot(std::vector<rcp<T>>& objects, uint32_t id)
+{
+    if (id >= kMaxTraceObjectId)
+    {
+        return nullptr;
+    }
+    if (id >= objects.size())
+    {
+        objects.resize(id + 1);
+    }
+    return &objects[id];
+}
+
+// Lookups never grow the table; unknown ids read as null.
+template <typename T>
+static const rcp<T>& find_slot(const std::vector<rcp<T>>& objects, uint32_t id)
+{
+    static const rcp<T> none;
+    return id < objects.size() ? objects[id] : none;
+}
+
+template <typename T>
+static void release_slot(std::vector<rcp<T>>& objects, uint32_t id)
+{
+    if (id < objects.size())
+    {
+        objects[id] = nullptr;
+    }
+}
+
+namespace
+{
+// Bounds-checked cursor over the trace bytes.
+class TraceReader
+{
+public:
+    TraceReader(const std::vector<uint8_t>& data, size_t cursor) :
+        m_data(data), m_cursor(cursor)
+    {}
+
+    template <typename T> T pod()
+    {
+        T value{};
+        read(&value, sizeof(T));
+        return value;
+    }
+
+    const uint8_t* bytes(size_t size)
+    {
+        if (size > m_data.size() - m_cursor)
+        {
+            m_failed = true;
+            m_cursor = m_data.size();
+            return nullptr;
+        }
+        const uint8_t* data = m_data.data() + m_cursor;
+        m_cursor += size;
+        return data;
+    }
+
+    void read(void* dst, size_t size)
+    {
+        if (const uint8_t* src = bytes(size))
+        {
+            memcpy(dst, src, size);
+        }
+    }
+
+    bool atEnd() const { return m_cursor >= m_data.size(); }
+    size_t remaining() const { return m_data.size() - m_cursor; }
+    bool failed() const { return m_failed; }
+    size_t cursor() const { return m_cursor; }
+
+private:
+    const std::vector<uint8_t>& m_data;
+    size_t m_cursor;
+    bool m_failed = false;
+};
+} // namespace
+
+std::unique_ptr<RenderTracePlayer> RenderTracePlayer::Load(const char* path)
+{
+    FILE* file = fopen(path, "rb");
+    if (file == nullptr)
+    {
+        fprintf(stderr, "Failed to open trace %s\n", path);
+        return nullptr;
+    }
+    std::unique_ptr<RenderTracePlayer> player(new RenderTracePlayer());
+    fseek(file, 0, SEEK_END);
+    player->m_data.resize(ftell(file));
+    fseek(file, 0, SEEK_SET);
+    bool readOK = fread(player->m_data.data(), 1, player->m_data.size(), file) ==
+                  player->m_data.size();
+    fclose(file);
+
+    TraceReader reader(player->m_data, 0);
+    char magic[sizeof(kTraceMagic)] = {};
+    reader.read(magic, sizeof(magic));
+    player->m_width = reader.pod<uint32_t>();
+    player->m_height = reader.pod<uint32_t>();
+    player->m_frameCount = reader.pod<uint32_t>();
+    if (!readOK || reader.failed() ||
+        memcmp(magic, kTraceMagic, sizeof(magic)) != 0)
+    {
+        fprintf(stderr, "%s is not a draw-command trace\n", path);
+        return nullptr;
+    }
+    player->m_opsBegin = player->m_cursor = reader.cursor();
+    player->m_objects = std::make_unique<Objects>();
+    return player;
+}
+
+RenderTracePlayer::~RenderTracePlayer() {}
+
+void RenderTracePlayer::reset()
+{
+    m_objects = std::make_unique<Objects>();
+    rewind();
+}
+
+bool RenderTracePlayer::playFrame(Factory* factory, Renderer* renderer)
+{
+    TraceReader reader(m_data, m_cursor);
+    Objects& objects = *m_objects;
+    // Stops playback at a corrupt record.
+    auto malformed = [&](const char* what) {
+        fprintf(stderr, "Malformed %s in draw-command trace\n", what);
+        m_cursor = m_data.size();
+        return false;
+    };
+    // Objects can be released between frames, so process everything up to
+    // the next endFrame rather than expecting a beginFrame first.
+    while (!reader.atEnd())
+    {
+        const Op op = reader.pod<Op>();
+        if (reader.failed())
+        {
+            fprintf(stderr, "Truncated draw-command trace\n");
+            m_cursor = m_data.size();
+            return false;
+        }
+        switch (op)
+        {
+            case Op::beginFrame:
+                break;
+            case Op::endFrame:
+                m_cursor = reader.cursor();
+                return true;
+            case Op::definePath:
+            {
+                const uint32_t id = reader.pod<uint32_t>();
+                const uint8_t fillRule = reader.pod<uint8_t>();
+                const uint32_t verbCount = reader.pod<uint32_t>();
+                const uint32_t pointCount = reader.pod<uint32_t>();
+                const uint8_t* verbs = reader.bytes(verbCount * sizeof(PathVerb));
+                const uint8_t* pointBytes =
+                    reader.bytes(pointCount * sizeof(Vec2D));
+                if (reader.failed())
+                {
+                    break;
+                }
+                std::vector<Vec2D>& points = objects.scratchPoints;
+                points.resize(pointCount);
+                memcpy(points.data(), pointBytes, pointCount * sizeof(Vec2D));
+                std::vector<PathVerb> pathVerbs(verbCount);
+                memcpy(pathVerbs.data(), verbs, verbCount * sizeof(PathVerb));
+                uint64_t expectedPoints = 0;
+                for (PathVerb verb : pathVerbs)
+                {
+                    if (!is_path_verb(verb))
+                    {
+                        return malformed("path");
+                    }
+                    expectedPoints += verb_point_count(verb);
+                }
+                if (expectedPoints != pointCount || !is_fill_rule(fillRule))
+                {
+                    return malformed("path");
+                }
+                // Rebuild the path with the same calls the runtime makes, so
+                // path construction is part of what gets measured.
+                RawPath& raw = objects.scratchPath;
+                raw.rewind();
+                const Vec2D* pt = points.data();
+                Vec2D pen = {0, 0};
+                for (PathVerb verb : pathVerbs)
+                {
+                    switch (verb)
+                    {
+                        case PathVerb::move:
+                            raw.moveTo(pt[0].x, pt[0].y);
+                            break;
+                        case PathVerb::line:
+                            raw.lineTo(pt[0].x, pt[0].y);
+                            break;
+                        case PathVerb::quad:
+                        {
+                            // Elevate to a cubic.
+                            Vec2D c0 = pen + (pt[0] - pen) * (2 / 3.f);
+                            Vec2D c1 = pt[1] + (pt[0] - pt[1]) * (2 / 3.f);
+                            raw.cubicTo(c0.x, c0.y, c1.x, c1.y, pt[1].x, pt[1].y);
+                            break;
+                        }
+                        case PathVerb::cubic:
+                            raw.cubicTo(pt[0].x,
+                                        pt[0].y,
+                                        pt[1].x,
+                                        pt[1].y,
+                                        pt[2].x,
+                                        pt[2].y);
+                            break;
+                        case PathVerb::close:
+                            raw.close();
+                            continue;
+                    }
+                    if (const uint32_t n = verb_point_count(verb))
+                    {
+                        pt += n;
+                        pen = pt[-1];
+                    }
+                }
+                rcp<RenderPath>* pathSlot = define_slot(objects.paths, id);
+                if (pathSlot == nullptr)
+                {
+                    fprintf(stderr,
+                            "Object id %u out of range in draw-command "
+                            "trace\n",
+                            id);
+                    m_cursor = m_data.size();
+                    return false;
+                }
+                rcp<RenderPath>& path = *pathSlot;
+                if (!path)
+                {
+                    path = factory->makeEmptyRenderPath();
+                }
+                path->rewind();
+                path->fillRule(static_cast<FillRule>(fillRule));
+                path->addRawPath(raw);
+                break;
+            }
+            case Op::definePaint:
+            {
+                const uint32_t id = reader.pod<uint32_t>();
+                const uint8_t style = reader.pod<uint8_t>();
+                const auto color = reader.pod<ColorInt>();
+                const float thickness = reader.pod<float>();
+                const uint8_t join = reader.pod<uint8_t>();
+                const uint8_t cap = reader.pod<uint8_t>();
+                const float feather = reader.pod<float>();
+                const uint8_t blendMode = reader.pod<uint8_t>();
+                const uint32_t shaderId = reader.pod<uint32_t>();
+                if (reader.failed())
+                {
+                    break;
+                }
+                if (!is_paint_style(style) || !is_stroke_join(join) ||
+                    !is_stroke_cap(cap) || !is_blend_mode(blendMode))
+                {
+                    return malformed("paint");
+                }
+                rcp<RenderPaint>* paintSlot = define_slot(objects.paints, id);
+                if (paintSlot == nullptr)
+                {
+                    fprintf(stderr,
+                            "Object id %u out of range in draw-command "
+                            "trace\n",
+                            id);
+                    m_cursor = m_data.size();
+                    return false;
+                }
+                rcp<RenderPaint>& paint = *paintSlot;
+                if (!paint)
+                {
+                    paint = factory->makeRenderPaint();
+                }
+                paint->style(static_cast<RenderPaintStyle>(style));
+                paint->color(color);
+                paint->thickness(thickness);
+                paint->join(static_cast<StrokeJoin>(join));
+                paint->cap(static_cast<StrokeCap>(cap));
+                paint->feather(feather);
+                paint->blendMode(static_cast<BlendMode>(blendMode));
+                paint->shader(find_slot(objects.shaders, shaderId));
+                break;
+            }
+            case Op::defineShader:
+            {
+                const uint32_t id = reader.pod<uint32_t>();
+                const uint8_t typeByte = reader.pod<uint8_t>();
+                float params[4];
+                reader.read(params, sizeof(params));
+                const uint32_t count = reader.pod<uint32_t>();
+                if (reader.failed())
+                {
+                    break;
+                }
+                // Checked before sizing anything from the count.
+                if (typeByte > static_cast<uint8_t>(ShaderType::radial) ||
+                    uint64_t(count) * (sizeof(ColorInt) + sizeof(float)) >
+                        reader.remaining())
+                {
+                    return malformed("shader");
+                }
+                const auto type = static_cast<ShaderType>(typeByte);
+                std::vector<ColorInt> colors(count);
+                std::vector<float> stops(count);
+                reader.read(colors.data(), count * sizeof(ColorInt));
+                reader.read(stops.data(), count * sizeof(float));
+                if (reader.failed())
+                {
+                    break;
+                }
+                rcp<RenderShader>* shader = define_slot(objects.shaders, id);
+                if (shader == nullptr)
+                {
+                    fprintf(stderr,
+                            "Object id %u out of range in draw-command "
+                            "trace\n",
+                            id);
+                    m_cursor = m_data.size();
+                    return false;
+                }
+                *shader =
+                    type == ShaderType::linear
+                        ? factory->makeLinearGradient(params[0],
+                                                      params[1],
+                                                      params[2],
+                                                      params[3],
+                                                      colors.data(),
+                                                      stops.data(),
+                                                      count)
+                        : factory->makeRadialGradient(params[0],
+                                                      params[1],
+                                                      params[2],
+                                                      colors.data(),
+                                                      stops.data(),
+                                                      count);
+                break;
+            }
+            case Op::defineImage:
+            {
+                const uint32_t id = reader.pod<uint32_t>();
+                const uint32_t size = reader.pod<uint32_t>();
+                const uint8_t* encoded = reader.bytes(size);
+                if (reader.failed())
+                {
+                    break;
+                }
+                // Decoding is setup, not steady state: keep the first decode
+                // across rewinds.
+                rcp<RenderImage>* imageSlot = define_slot(objects.images, id);
+                if (imageSlot == nullptr)
+                {
+                    fprintf(stderr,
+                            "Object id %u out of range in draw-command "
+                            "trace\n",
+                            id);
+                    m_cursor = m_data.size();
+                    return false;
+                }
+                rcp<RenderImage>& image = *imageSlot;
+                if (!image)
+                {
+                    image = factory->decodeImage({encoded, size});
+                }
+                break;
+            }
+            case Op::defineBuffer:
+            {
+                const uint32_t id = reader.pod<uint32_t>();
+                const auto type =
+                    static_cast<RenderBufferType>(reader.pod<uint8_t>());
+                const auto flags =
+                    static_cast<RenderBufferFlags>(reader.pod<uint8_t>());
+                const uint32_t size = reader.pod<uint32_t>();
+                const uint8_t* contents = reader.bytes(size);
+                if (reader.failed())
+                {
+                    break;
+                }
+                rcp<RenderBuffer>* bufferSlot =
+                    define_slot(objects.buffers, id);
+                if (bufferSlot == nullptr)
+                {
+                    fprintf(stderr,
+                            "Object id %u out of range in draw-command "
+                            "trace\n",
+                            id);
+                    m_cursor = m_data.size();
+                    return false;
+                }
+                rcp<RenderBuffer>& buffer = *bufferSlot;
+                // Buffers flagged for a single map have to be recreated.
+                if (!buffer || buffer->sizeInBytes() != size ||
+                    static_cast<uint8_t>(flags) != 0)
+                {
+                    buffer = factory->makeRenderBuffer(type, flags, size);
+                }
+                if (buffer)
+                {
+                    memcpy(buffer->map(), contents, size);
+                    buffer->unmap();
+                }
+                break;
+            }
+            case Op::releasePath:
+                release_slot(objects.paths, reader.pod<uint32_t>());
+                break;
+            case Op::releasePaint:
+                release_slot(objects.paints, reader.pod<uint32_t>());
+                break;
+            case Op::releaseShader:
+                release_slot(objects.shaders, reader.pod<uint32_t>());
+                break;
+            case Op::releaseImage:
+                // Kept, like the decode above.
+                reader.pod<uint32_t>();
+                break;
+            case Op::releaseBuffer:
+                release_slot(objects.buffers, reader.pod<uint32_t>());
+                break;
+            case Op::save:
+                renderer->save();
+                break;
+            case Op::restore:
+                renderer->restore();
+                break;
+            case Op::transform:
+            {
+                float m[6];
+                reader.read(m, sizeof(m));
+                renderer->transform(Mat2D(m[0], m[1], m[2], m[3], m[4], m[5]));
+                break;
+            }
+            case Op::clipPath:
+                if (RenderPath* path =
+                        find_slot(objects.paths, reader.pod<uint32_t>()).get())
+                {
+                    renderer->clipPath(path);
+                }
+                break;
+            case Op::drawPath:
+            {
+                RenderPath* path =
+                    find_slot(objects.paths, reader.pod<uint32_t>()).get();
+                RenderPaint* paint =
+                    find_slot(objects.paints, reader.pod<uint32_t>()).get();
+                if (path != nullptr && paint != nullptr)
+                {
+                    renderer->drawPath(path, paint);
+                }
+                break;
+            }
+            case Op::drawImage:
+            {
+                RenderImage* image =
+                    find_slot(objects.images, reader.pod<uint32_t>()).get();
+                const auto sampler = reader.pod<ImageSampler>();
+                const uint8_t blendMode = reader.pod<uint8_t>();
+                const float opacity = reader.pod<float>();
+                if (reader.failed())
+                {
+                    break;
+                }
+                if (!is_blend_mode(blendMode))
+                {
+                    return malformed("image draw");
+                }
+                if (image != nullptr)
+                {
+                    renderer->drawImage(image,
+                                        sampler,
+                                        static_cast<BlendMode>(blendMode),
+                                        opacity);
+                }
+                break;
+            }
+            case Op::drawImageMesh:
+            {
+                RenderImage* image =
+                    find_slot(objects.images, reader.pod<uint32_t>()).get();
+                const auto sampler = reader.pod<ImageSampler>();
+                rcp<RenderBuffer> buffers[3];
+                for (rcp<RenderBuffer>& buffer : buffers)
+                {
+                    buffer = find_slot(objects.buffers, reader.pod<uint32_t>());
+                }
+                const uint32_t vertexCount = reader.pod<uint32_t>();
+                const uint32_t indexCount = reader.pod<uint32_t>();
+                const uint8_t blendMode = reader.pod<uint8_t>();
+                const float opacity = reader.pod<float>();
+                if (reader.failed())
+                {
+                    break;
+                }
+                if (!is_blend_mode(blendMode))
+                {
+                    return malformed("image mesh");
+                }
+                if (image != nullptr && buffers[0] && buffers[1] && buffers[2])
+                {
+                    renderer->drawImageMesh(image,
+                                            sampler,
+                                            buffers[0],
+                                            buffers[1],
+                                            buffers[2],
+                                            vertexCount,
+                                            indexCount,
+                                            static_cast<BlendMode>(blendMode),
+                                            opacity);
+                }
+                break;
+            }
+            default:
+                fprintf(stderr,
+                        "Unknown opcode %u in draw-command trace\n",
+                        static_cast<unsigned>(op));
+                m_cursor = m_data.size();
+                return false;
+        }
+    }
+    m_cursor = reader.cursor();
+    return false;
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "rive/factory.hpp"
+#include "rive/renderer.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+// Draw-command traces: everything a rive::Renderer was asked to do over a
+// run of frames, with the path, paint, shader, image and buffer contents it
+// referenced. A trace replays against any FiddleContext without the .riv or
+// the runtime, which isolates renderer and backend throughput from
+// animation evaluation.
+//
+// The format is a header followed by a stream of opcodes in host byte order.
+// Object definitions are emitted lazily, right before the first draw that
+// needs them and again whenever they change, so a static scene costs one
+// definition and then only draw opcodes per frame.
+
+class RenderTraceWriter;
+
+class RenderTraceRecorder
+{
+public:
+    // Records the next `maxFrames` frames (0 = until finish()) to `path`.
+    // Everything drawn through wrapRenderer() must have been created by
+    // factory(); the recorder forwards to `factory` underneath.
+    static std::unique_ptr<RenderTraceRecorder> Open(const char* path,
+                                                     rive::Factory* factory,
+                                                     int maxFrames);
+    ~RenderTraceRecorder();
+
+    // Use in place of the backend's factory (e.g. for File::import).
+    rive::Factory* factory() { return m_factory.get(); }
+
+    // Wraps a renderer from FiddleContext::makeRenderer(). Draws are
+    // forwarded to it, and serialized while recording.
+    std::unique_ptr<rive::Renderer> wrapRenderer(
+        std::unique_ptr<rive::Renderer>,
+        uint32_t width,
+        uint32_t height);
+
+    void beginFrame();
+    // Closes the trace once maxFrames have been recorded.
+    void endFrame();
+    void finish();
+    bool isRecording() const;
+
+private:
+    RenderTraceRecorder(std::shared_ptr<RenderTraceWriter>,
+                        rive::Factory*,
+                        int maxFrames);
+
+    std::shared_ptr<RenderTraceWriter> m_writer;
+    std::unique_ptr<rive::Factory> m_factory;
+    int m_maxFrames;
+    int m_recordedFrames = 0;
+    bool m_inFrame = false;
+};
+
+class RenderTracePlayer
+{
+public:
+    static std::unique_ptr<RenderTracePlayer> Load(const char* path);
+    ~RenderTracePlayer();
+
+    // Render target size of the recording.
+    uint32_t width() const { return m_width; }
+    uint32_t height() const { return m_height; }
+    uint32_t frameCount() const { return m_frameCount; }
+
+    // Replays the next frame's commands into `renderer`, creating objects
+    // with `factory`. Returns false, and draws nothing, once every frame has
+    // been played; rewind() starts over. The renderer and factory must come
+    // from the same context on every call until reset().
+    bool playFrame(rive::Factory* factory, rive::Renderer* renderer);
+    void rewind() { m_cursor = m_opsBegin; }
+    // Drops every object created from the trace (e.g. before switching
+    // contexts).
+    void reset();
+
+private:
+    struct Objects;
+
+    RenderTracePlayer() = default;
+
+    std::vector<uint8_t> m_data;
+    size_t m_opsBegin = 0;
+    size_t m_cursor = 0;
+    uint32_t m_width = 0;
+    uint32_t m_height = 0;
+    uint32_t m_frameCount = 0;
+    std::unique_ptr<Objects> m_objects;
+};
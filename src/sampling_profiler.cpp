@@ -0,0 +1,240 @@
+#include "sampling_profiler.hpp"
+
+#include <cstdio>
+
+#ifdef __linux__
+
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <map>
+#include <memory>
+#include <string>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <unordered_map>
+
+// glibc only names the thread id field from 2.35 on.
+#ifndef sigev_notify_thread_id
+#define sigev_notify_thread_id _sigev_un._tid
+#endif
+
+namespace
+{
+constexpr int kMaxDepth = 64;
+// The handler's own frame and the kernel's signal trampoline.
+constexpr int kSkippedFrames = 2;
+// Room for ~100k samples of typical depth; later samples are dropped.
+constexpr size_t kBufferWords = size_t(1) << 22;
+constexpr long kNanosecondsPerSecond = 1000000000;
+
+// Each sample is its depth followed by that many return addresses, leaf
+// first.
+std::unique_ptr<uintptr_t[]> samples;
+std::atomic<size_t> sampleWords{0};
+std::atomic<uint64_t> sampleCount{0};
+std::atomic<uint64_t> droppedSamples{0};
+std::atomic<bool> sampling{false};
+timer_t timer;
+bool timerCreated = false;
+
+void on_sigprof(int, siginfo_t*, void*)
+{
+    if (!sampling.load(std::memory_order_relaxed))
+    {
+        return;
+    }
+    const int savedErrno = errno;
+    void* frames[kMaxDepth + kSkippedFrames];
+    const int depth = backtrace(frames, kMaxDepth + kSkippedFrames) -
+                      kSkippedFrames;
+    const size_t used = sampleWords.load(std::memory_order_relaxed);
+    if (depth <= 0 || used + 1 + depth > kBufferWords)
+    {
+        droppedSamples.fetch_add(1, std::memory_order_relaxed);
+    }
+    else
+    {
+        samples[used] = depth;
+        for (int i = 0; i < depth; ++i)
+        {
+            samples[used + 1 + i] =
+                reinterpret_cast<uintptr_t>(frames[kSkippedFrames + i]);
+        }
+        sampleWords.store(used + 1 + depth, std::memory_order_release);
+        sampleCount.fetch_add(1, std::memory_order_relaxed);
+    }
+    errno = savedErrno;
+}
+
+std::string symbolize(uintptr_t address)
+{
+    Dl_info info;
+    if (dladdr(reinterpret_cast<void*>(address), &info) == 0)
+    {
+        char hex[32];
+        snprintf(hex, sizeof(hex), "0x%zx", static_cast<size_t>(address));
+        return hex;
+    }
+    if (info.dli_sname != nullptr)
+    {
+        int status = 0;
+        char* demangled =
+            abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+        std::string name = status == 0 ? demangled : info.dli_sname;
+        free(demangled);
+        return name;
+    }
+    const char* module = info.dli_fname ? strrchr(info.dli_fname, '/') : nullptr;
+    char name[512];
+    snprintf(name,
+             sizeof(name),
+             "%s+0x%zx",
+             module ? module + 1 : (info.dli_fname ? info.dli_fname : "?"),
+             static_cast<size_t>(address -
+                                 reinterpret_cast<uintptr_t>(info.dli_fbase)));
+    return name;
+}
+} // namespace
+
+bool profiler_start(int hz)
+{
+    if (hz <= 0 || hz > kNanosecondsPerSecond || sampling.load())
+    {
+        return false;
+    }
+    // backtrace() loads libgcc on first use, which must not happen inside the
+    // signal handler.
+    void* warmup[4];
+    backtrace(warmup, 4);
+    if (!samples)
+    {
+        samples.reset(new uintptr_t[kBufferWords]);
+    }
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_sigaction = on_sigprof;
+    action.sa_flags = SA_SIGINFO | SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    if (sigaction(SIGPROF, &action, nullptr) != 0)
+    {
+        perror("sigaction(SIGPROF)");
+        return false;
+    }
+
+    struct sigevent event;
+    memset(&event, 0, sizeof(event));
+    event.sigev_notify = SIGEV_THREAD_ID;
+    event.sigev_signo = SIGPROF;
+    event.sigev_notify_thread_id = static_cast<pid_t>(syscall(SYS_gettid));
+    if (timer_create(CLOCK_THREAD_CPUTIME_ID, &event, &timer) != 0)
+    {
+        perror("timer_create");
+        return false;
+    }
+    timerCreated = true;
+
+    sampling.store(true);
+    struct itimerspec interval;
+    memset(&interval, 0, sizeof(interval));
+    // tv_nsec must stay below a second, so 1 Hz is {1, 0}.
+    const long periodNs = kNanosecondsPerSecond / hz;
+    interval.it_interval.tv_sec = periodNs / kNanosecondsPerSecond;
+    interval.it_interval.tv_nsec = periodNs % kNanosecondsPerSecond;
+    interval.it_value = interval.it_interval;
+    if (timer_settime(timer, 0, &interval, nullptr) != 0)
+    {
+        perror("timer_settime");
+        profiler_stop();
+        return false;
+    }
+    return true;
+}
+
+void profiler_stop()
+{
+    sampling.store(false);
+    if (timerCreated)
+    {
+        timer_delete(timer);
+        timerCreated = false;
+    }
+}
+
+bool profiler_write_folded(const char* path)
+{
+    FILE* file = fopen(path, "w");
+    if (file == nullptr)
+    {
+        fprintf(stderr, "Failed to open %s for writing\n", path);
+        return false;
+    }
+
+    std::unordered_map<uintptr_t, std::string> symbols;
+    std::map<std::string, uint64_t> stacks;
+    const size_t words = sampleWords.load(std::memory_order_acquire);
+    std::string stack;
+    for (size_t i = 0; i < words; i += 1 + samples[i])
+    {
+        const int depth = static_cast<int>(samples[i]);
+        stack.clear();
+        // Folded stacks are root first.
+        for (int frame = depth - 1; frame >= 0; --frame)
+        {
+            // Callers hold return addresses, which can belong to the next
+            // line or function; look up the call instruction instead.
+            uintptr_t address = samples[i + 1 + frame];
+            if (frame > 0)
+            {
+                --address;
+            }
+            auto symbol = symbols.find(address);
+            if (symbol == symbols.end())
+            {
+                symbol = symbols.emplace(address, symbolize(address)).first;
+            }
+            if (!stack.empty())
+            {
+                stack += ';';
+            }
+            stack += symbol->second;
+        }
+        ++stacks[stack];
+    }
+    for (const auto& [folded, count] : stacks)
+    {
+        fprintf(file,
+                "%s %llu\n",
+                folded.c_str(),
+                static_cast<unsigned long long>(count));
+    }
+    const bool ok = fclose(file) == 0;
+    printf("Wrote %llu samples (%zu distinct stacks, %llu dropped) to %s\n",
+           static_cast<unsigned long long>(sampleCount.load()),
+           stacks.size(),
+           static_cast<unsigned long long>(droppedSamples.load()),
+           path);
+    return ok;
+}
+
+#else
+
+bool profiler_start(int)
+{
+    fprintf(stderr, "the sampling profiler is only supported on Linux\n");
+    return false;
+}
+
+void profiler_stop() {}
+
+bool profiler_write_folded(const char*) { return false; }
+
+#endif
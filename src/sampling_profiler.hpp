@@ -0,0 +1,19 @@
+#pragma once
+
+// Self-profiler for places external profilers can't run. Samples the
+// calling thread's stack on its own CPU-time clock (timer_create delivering
+// SIGPROF to just that thread; Linux only), so time blocked in the driver or
+// waiting on vsync is not sampled. Samples go into a buffer allocated up
+// front; the signal handler neither allocates nor locks.
+//
+// The folded-stack output ("root;caller;callee count" per line) is read by
+// flamegraph.pl, inferno and speedscope. Frames are symbolized with dladdr,
+// so only exported symbols get names (LeftoverPasta links with
+// ENABLE_EXPORTS for this); the rest print as module+offset.
+
+// Starts sampling the calling thread `hz` times per CPU-second. Fails for
+// rates outside 1..1e9.
+bool profiler_start(int hz);
+// Stops sampling. Samples are kept for profiler_write_folded().
+void profiler_stop();
+bool profiler_write_folded(const char* path);
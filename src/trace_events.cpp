@@ -0,0 +1,184 @@
+#include "trace_events.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+std::atomic<bool> g_traceEnabled{false};
+
+namespace
+{
+struct TraceEvent
+{
+    const char* name;
+    uint64_t startNs;
+    uint64_t durationNs;
+};
+
+class TraceRing
+{
+public:
+    constexpr static uint64_t kCapacity = 1 << 16;
+
+    explicit TraceRing(uint32_t threadId) :
+        m_threadId(threadId), m_events(kCapacity)
+    {}
+
+    uint32_t threadId() const { return m_threadId; }
+
+    // Owner thread only.
+    void push(const TraceEvent& event)
+    {
+        const uint64_t head = m_head.load(std::memory_order_relaxed);
+        m_events[head & (kCapacity - 1)] = event;
+        m_head.store(head + 1, std::memory_order_release);
+    }
+
+    // Appends the events still in the ring, oldest first. Slots the owner
+    // may have reused during the copy are dropped rather than read torn.
+    void snapshot(std::vector<TraceEvent>* out) const
+    {
+        const uint64_t end = m_head.load(std::memory_order_acquire);
+        const uint64_t begin = end > kCapacity ? end - kCapacity : 0;
+        const size_t base = out->size();
+        for (uint64_t i = begin; i < end; ++i)
+        {
+            out->push_back(m_events[i & (kCapacity - 1)]);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        // The owner may be writing slot `after` right now, which is the one
+        // that held event after - kCapacity.
+        const uint64_t after = m_head.load(std::memory_order_relaxed);
+        const uint64_t firstIntact =
+            after + 1 > kCapacity ? after + 1 - kCapacity : 0;
+        if (firstIntact > begin)
+        {
+            const size_t torn = static_cast<size_t>(
+                std::min<uint64_t>(firstIntact - begin, end - begin));
+            out->erase(out->begin() + base, out->begin() + base + torn);
+        }
+    }
+
+    std::string name; // Guarded by ringsMutex.
+
+private:
+    const uint32_t m_threadId;
+    std::vector<TraceEvent> m_events;
+    std::atomic<uint64_t> m_head{0};
+};
+
+std::mutex ringsMutex;
+// Rings outlive their threads so events from finished workers still export.
+std::vector<TraceRing*> rings;
+thread_local TraceRing* threadRing = nullptr;
+
+const std::chrono::steady_clock::time_point traceEpoch =
+    std::chrono::steady_clock::now();
+
+TraceRing* thread_ring()
+{
+    if (threadRing == nullptr)
+    {
+        std::lock_guard<std::mutex> lock(ringsMutex);
+        threadRing = new TraceRing(static_cast<uint32_t>(rings.size() + 1));
+        rings.push_back(threadRing);
+    }
+    return threadRing;
+}
+} // namespace
+
+uint64_t trace_now_ns()
+{
+    // Offset by one so a real timestamp is never the "not recording" zero.
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now() - traceEpoch)
+               .count() +
+           1;
+}
+
+void trace_complete_event(const char* name, uint64_t startNs)
+{
+    const uint64_t endNs = trace_now_ns();
+    thread_ring()->push({name, startNs, endNs - startNs});
+}
+
+void trace_start()
+{
+    if (!trace_compiled_in())
+    {
+        fprintf(stderr,
+                "warning: tracing is compiled out; configure with "
+                "-DLP_TRACING=ON\n");
+        return;
+    }
+    g_traceEnabled.store(true, std::memory_order_relaxed);
+}
+
+void trace_set_thread_name(const char* name)
+{
+    TraceRing* ring = thread_ring();
+    std::lock_guard<std::mutex> lock(ringsMutex);
+    ring->name = name;
+}
+
+bool trace_write(const char* path)
+{
+    FILE* file = fopen(path, "w");
+    if (file == nullptr)
+    {
+        fprintf(stderr, "Failed to open %s for writing\n", path);
+        return false;
+    }
+    std::vector<TraceRing*> ringsCopy;
+    std::vector<std::string> names;
+    {
+        std::lock_guard<std::mutex> lock(ringsMutex);
+        ringsCopy = rings;
+        for (const TraceRing* ring : rings)
+        {
+            names.push_back(ring->name);
+        }
+    }
+
+    size_t eventCount = 0;
+    const char* separator = "";
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    std::vector<TraceEvent> events;
+    for (size_t i = 0; i < ringsCopy.size(); ++i)
+    {
+        const uint32_t tid = ringsCopy[i]->threadId();
+        if (!names[i].empty())
+        {
+            fprintf(file,
+                    "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+                    "\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+                    separator,
+                    tid,
+                    names[i].c_str());
+            separator = ",\n";
+        }
+        events.clear();
+        ringsCopy[i]->snapshot(&events);
+        for (const TraceEvent& event : events)
+        {
+            // Chrome trace timestamps are microseconds.
+            fprintf(file,
+                    "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,"
+                    "\"ts\":%.3f,\"dur\":%.3f}",
+                    separator,
+                    event.name,
+                    tid,
+                    event.startNs / 1e3,
+                    event.durationNs / 1e3);
+            separator = ",\n";
+        }
+        eventCount += events.size();
+    }
+    fprintf(file, "\n]}\n");
+    const bool ok = fclose(file) == 0;
+    printf("Wrote %zu trace events to %s\n", eventCount, path);
+    return ok;
+}
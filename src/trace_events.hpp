@@ -0,0 +1,70 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Scoped CPU timers exported as Chrome trace JSON (chrome://tracing or
+// ui.perfetto.dev).
+//
+// Configure with -DLP_TRACING=ON to compile the scopes in; otherwise
+// LP_TRACE_SCOPE expands to nothing and costs nothing. When compiled in,
+// nothing is recorded until trace_start().
+//
+// Each thread appends complete events to its own fixed-size ring: one
+// writer, no locks, the oldest events overwritten when it wraps. Names must
+// be string literals; they are stored by pointer and written unescaped.
+
+#ifdef LP_ENABLE_TRACING
+#define LP_TRACE_CONCAT_(a, b) a##b
+#define LP_TRACE_CONCAT(a, b) LP_TRACE_CONCAT_(a, b)
+#define LP_TRACE_SCOPE(name)                                                   \
+    TraceScope LP_TRACE_CONCAT(lpTraceScope, __LINE__)(name)
+#else
+#define LP_TRACE_SCOPE(name)
+#endif
+
+constexpr bool trace_compiled_in()
+{
+#ifdef LP_ENABLE_TRACING
+    return true;
+#else
+    return false;
+#endif
+}
+
+void trace_start();
+// Names the calling thread in the trace.
+void trace_set_thread_name(const char* name);
+// Writes every thread's ring. Safe to call while other threads trace.
+bool trace_write(const char* path);
+
+extern std::atomic<bool> g_traceEnabled;
+
+uint64_t trace_now_ns();
+void trace_complete_event(const char* name, uint64_t startNs);
+
+class TraceScope
+{
+public:
+    explicit TraceScope(const char* name) :
+        m_name(name),
+        m_startNs(g_traceEnabled.load(std::memory_order_relaxed)
+                      ? trace_now_ns()
+                      : 0)
+    {}
+
+    ~TraceScope()
+    {
+        if (m_startNs != 0)
+        {
+            trace_complete_event(m_name, m_startNs);
+        }
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* const m_name;
+    const uint64_t m_startNs;
+};
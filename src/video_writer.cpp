@@ -0,0 +1,245 @@
+#include "video_writer.hpp"
+
+#include "readback_convert.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <csignal>
+#include <unistd.h>
+#endif
+
+// Takes over stdout for binary video and points the original descriptor at
+// stderr, so printf() logging keeps working without landing in the stream.
+static FILE* claim_stdout_for_video()
+{
+    fflush(stdout);
+#ifdef _WIN32
+    int videoFd = _dup(_fileno(stdout));
+    _dup2(_fileno(stderr), _fileno(stdout));
+    _setmode(videoFd, _O_BINARY);
+    return _fdopen(videoFd, "wb");
+#else
+    int videoFd = dup(STDOUT_FILENO);
+    dup2(STDERR_FILENO, STDOUT_FILENO);
+    return fdopen(videoFd, "wb");
+#endif
+}
+
+std::unique_ptr<VideoWriter> VideoWriter::Open(const char* path,
+                                               VideoFormat format,
+                                               double fps,
+                                               int threadCount)
+{
+#ifndef _WIN32
+    // A reader that exits early should end the capture, not kill the app.
+    signal(SIGPIPE, SIG_IGN);
+#endif
+    FILE* file = !strcmp(path, "-") ? claim_stdout_for_video()
+                                    : fopen(path, "wb");
+    if (file == nullptr)
+    {
+        fprintf(stderr, "Failed to open video output %s\n", path);
+        return nullptr;
+    }
+    if (threadCount <= 0)
+    {
+        threadCount =
+            std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    }
+    return std::unique_ptr<VideoWriter>(
+        new VideoWriter(file, format, fps, threadCount));
+}
+
+VideoWriter::VideoWriter(FILE* file,
+                         VideoFormat format,
+                         double fps,
+                         int threadCount) :
+    m_file(file), m_format(format), m_fps(fps), m_bandCount(threadCount)
+{
+    // The calling thread converts band 0 itself.
+    for (int band = 1; band < m_bandCount; ++band)
+    {
+        m_workers.emplace_back(&VideoWriter::workerMain, this, band);
+    }
+}
+
+VideoWriter::~VideoWriter()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_exiting = true;
+    }
+    m_workReady.notify_all();
+    for (std::thread& worker : m_workers)
+    {
+        worker.join();
+    }
+    if (m_file != nullptr)
+    {
+        fclose(m_file);
+    }
+}
+
+bool VideoWriter::close()
+{
+    if (m_file == nullptr)
+    {
+        return !m_failed;
+    }
+    // A full disk or closed pipe can surface only on the final flush.
+    bool ok = ferror(m_file) == 0;
+    ok = fclose(m_file) == 0 && ok;
+    m_file = nullptr;
+    if (!ok && !m_failed)
+    {
+        fprintf(stderr, "Failed to finish writing the video output\n");
+        m_failed = true;
+    }
+    return !m_failed;
+}
+
+bool VideoWriter::writeFrame(uint32_t width,
+                             uint32_t height,
+                             const uint8_t* pixels,
+                             uint32_t conversions)
+{
+    if (m_failed)
+    {
+        return false;
+    }
+    if (m_framesWritten == 0)
+    {
+        m_width = width;
+        m_height = height;
+        size_t chromaWidth = (width + 1) / 2;
+        size_t chromaHeight = (height + 1) / 2;
+        m_frame.resize(width * height + chromaWidth * chromaHeight * 2);
+        uint8_t* chroma = m_frame.data() + width * height;
+        if (m_format == VideoFormat::nv12)
+        {
+            m_planes = {m_frame.data(), width, chroma, chroma + 1,
+                        chromaWidth * 2, 2};
+        }
+        else
+        {
+            m_planes = {m_frame.data(), width, chroma,
+                        chroma + chromaWidth * chromaHeight, chromaWidth, 1};
+        }
+
+        if (m_format == VideoFormat::y4m)
+        {
+            // Express the frame rate as a ratio so 29.97 etc. survive.
+            double rounded = std::round(m_fps);
+            bool integral = std::abs(m_fps - rounded) < 1e-6;
+            fprintf(m_file,
+                    "YUV4MPEG2 W%u H%u F%lld:%d Ip A1:1 C420jpeg "
+                    "XCOLORRANGE=LIMITED\n",
+                    width,
+                    height,
+                    static_cast<long long>(integral ? rounded
+                                                    : std::round(m_fps * 1000)),
+                    integral ? 1 : 1000);
+        }
+    }
+    else if (width != m_width || height != m_height)
+    {
+        fprintf(stderr,
+                "Video output is %ux%u; got a %ux%u frame\n",
+                m_width,
+                m_height,
+                width,
+                height);
+        m_failed = true;
+        return false;
+    }
+
+    if (conversions & kReadbackFlipY)
+    {
+        // Already top-down.
+        m_sourceStride = static_cast<ptrdiff_t>(width) * 4;
+        m_sourceTopRow = pixels;
+    }
+    else
+    {
+        // Read the bottom-up readback upright.
+        m_sourceStride = -static_cast<ptrdiff_t>(width) * 4;
+        m_sourceTopRow = pixels + static_cast<size_t>(width) * 4 * (height - 1);
+    }
+    m_sourceBGRA = (conversions & kReadbackSwizzleRB) != 0;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_bandsRemaining = m_bandCount - 1;
+        ++m_generation;
+    }
+    m_workReady.notify_all();
+    convertBand(0);
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_workDone.wait(lock, [this] { return m_bandsRemaining == 0; });
+    }
+
+    if (m_format == VideoFormat::y4m)
+    {
+        fputs("FRAME\n", m_file);
+    }
+    if (fwrite(m_frame.data(), 1, m_frame.size(), m_file) != m_frame.size())
+    {
+        fprintf(stderr, "Video output closed after %llu frames\n",
+                static_cast<unsigned long long>(m_framesWritten));
+        m_failed = true;
+        return false;
+    }
+    ++m_framesWritten;
+    return true;
+}
+
+void VideoWriter::convertBand(int band)
+{
+    // Bands are whole row pairs so no two threads share a chroma row.
+    uint32_t rowPairs = (m_height + 1) / 2;
+    uint32_t begin = rowPairs * band / m_bandCount * 2;
+    uint32_t end = std::min(rowPairs * (band + 1) / m_bandCount * 2, m_height);
+    rgba_to_yuv420(m_sourceTopRow,
+                   m_sourceStride,
+                   m_width,
+                   m_height,
+                   begin,
+                   end,
+                   m_planes,
+                   m_sourceBGRA);
+}
+
+void VideoWriter::workerMain(int band)
+{
+    uint64_t lastGeneration = 0;
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_workReady.wait(lock, [&] {
+                return m_generation != lastGeneration || m_exiting;
+            });
+            if (m_exiting)
+            {
+                return;
+            }
+            lastGeneration = m_generation;
+        }
+        convertBand(band);
+        bool lastBand;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            lastBand = --m_bandsRemaining == 0;
+        }
+        if (lastBand)
+        {
+            m_workDone.notify_one();
+        }
+    }
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "yuv_convert.hpp"
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+enum class VideoFormat
+{
+    y4m,  // YUV4MPEG2 stream with 4:2:0 planar frames (ffmpeg -i -).
+    nv12, // Headerless NV12 frames (ffmpeg -f rawvideo -pix_fmt nv12).
+};
+
+// Streams captured frames as raw video to a file, FIFO or stdout, for an
+// external encoder to consume. One YUV frame buffer is allocated up front
+// and reused; the RGBA->YUV conversion is split by row band across a small
+// set of persistent threads.
+class VideoWriter
+{
+public:
+    // path "-" streams to stdout; normal stdout logging is moved to stderr
+    // so it doesn't corrupt the stream. threadCount <= 0 picks one per core.
+    static std::unique_ptr<VideoWriter> Open(const char* path,
+                                             VideoFormat,
+                                             double fps,
+                                             int threadCount);
+    ~VideoWriter();
+
+    VideoWriter(const VideoWriter&) = delete;
+    VideoWriter& operator=(const VideoWriter&) = delete;
+
+    // Converts and writes one RGBA frame, bottom row first (the layout
+    // FiddleContext reads back). `conversions` describes a frame in another
+    // layout, as in ReadbackFrame: kReadbackFlipY for top-down rows and
+    // kReadbackSwizzleRB for BGRA, both handled during the YUV conversion.
+    // Every frame must be the same size; a frame of another size fails the
+    // stream. Returns false once the stream is broken, e.g. the reader
+    // exited.
+    bool writeFrame(uint32_t width,
+                    uint32_t height,
+                    const uint8_t* pixels,
+                    uint32_t conversions = 0);
+
+    // Flushes and closes the output. Returns false if any frame or the final
+    // flush failed to write. The destructor closes without reporting.
+    bool close();
+
+    uint64_t framesWritten() const { return m_framesWritten; }
+
+private:
+    VideoWriter(FILE*, VideoFormat, double fps, int threadCount);
+
+    void convertBand(int band);
+    void workerMain(int band);
+
+    FILE* m_file;
+    const VideoFormat m_format;
+    const double m_fps;
+    uint32_t m_width = 0;
+    uint32_t m_height = 0;
+    std::vector<uint8_t> m_frame;
+    YUV420Planes m_planes{};
+    uint64_t m_framesWritten = 0;
+    bool m_failed = false;
+
+    // The frame currently being converted, shared with the band workers.
+    const uint8_t* m_sourceTopRow = nullptr;
+    ptrdiff_t m_sourceStride = 0;
+    bool m_sourceBGRA = false;
+
+    const int m_bandCount;
+    std::vector<std::thread> m_workers;
+    std::mutex m_mutex;
+    std::condition_variable m_workReady;
+    std::condition_variable m_workDone;
+    uint64_t m_generation = 0;
+    int m_bandsRemaining = 0;
+    bool m_exiting = false;
+};
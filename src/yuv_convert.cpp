@@ -0,0 +1,355 @@
+#include "yuv_convert.hpp"
+
+#include "cpu_features.hpp"
+
+#include <cstring>
+#include <utility>
+
+// Fixed-point BT.601 limited-range coefficients, scaled by 256. The SIMD
+// kernels use the same integer math, so their output matches the scalar
+// path exactly.
+static uint8_t rgb_to_y(int r, int g, int b)
+{
+    return static_cast<uint8_t>(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+}
+
+static uint8_t rgb_to_u(int r, int g, int b)
+{
+    return static_cast<uint8_t>(((-38 * r - 74 * g + 112 * b + 128) >> 8) +
+                                128);
+}
+
+static uint8_t rgb_to_v(int r, int g, int b)
+{
+    return static_cast<uint8_t>(((112 * r - 94 * g - 18 * b + 128) >> 8) +
+                                128);
+}
+
+// Converts columns [x, width) of one row pair. row1 == row0 for the last row
+// of an odd-height image.
+static void convert_row_pair_scalar(const uint8_t* row0,
+                                    const uint8_t* row1,
+                                    uint32_t x,
+                                    uint32_t width,
+                                    uint8_t* y0,
+                                    uint8_t* y1,
+                                    uint8_t* u,
+                                    uint8_t* v,
+                                    uint32_t uvPixelStep,
+                                    bool swapRB)
+{
+    // Channel offsets of red and blue.
+    const int ri = swapRB ? 2 : 0;
+    const int bi = swapRB ? 0 : 2;
+    for (; x < width; x += 2)
+    {
+        // Replicate the last column of an odd-width image.
+        uint32_t x1 = x + 1 < width ? x + 1 : x;
+        const uint8_t* p[4] = {row0 + x * 4,
+                               row0 + x1 * 4,
+                               row1 + x * 4,
+                               row1 + x1 * 4};
+        y0[x] = rgb_to_y(p[0][ri], p[0][1], p[0][bi]);
+        y1[x] = rgb_to_y(p[2][ri], p[2][1], p[2][bi]);
+        if (x1 != x)
+        {
+            y0[x1] = rgb_to_y(p[1][ri], p[1][1], p[1][bi]);
+            y1[x1] = rgb_to_y(p[3][ri], p[3][1], p[3][bi]);
+        }
+        int r = (p[0][ri] + p[1][ri] + p[2][ri] + p[3][ri] + 2) >> 2;
+        int g = (p[0][1] + p[1][1] + p[2][1] + p[3][1] + 2) >> 2;
+        int b = (p[0][bi] + p[1][bi] + p[2][bi] + p[3][bi] + 2) >> 2;
+        u[(x / 2) * uvPixelStep] = rgb_to_u(r, g, b);
+        v[(x / 2) * uvPixelStep] = rgb_to_v(r, g, b);
+    }
+}
+
+#ifdef LP_X86
+// Splits 8 RGBA pixels into 16-bit R, G and B lanes.
+LP_TARGET_SSE41 static void load_rgb8_sse41(const uint8_t* src,
+                                            __m128i* r,
+                                            __m128i* g,
+                                            __m128i* b)
+{
+    // Gather each channel of 4 pixels into its own 32-bit lane.
+    const __m128i planarize =
+        _mm_setr_epi8(0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15);
+    __m128i lo = _mm_shuffle_epi8(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(src)),
+        planarize);
+    __m128i hi = _mm_shuffle_epi8(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 16)),
+        planarize);
+    __m128i rg = _mm_unpacklo_epi32(lo, hi); // R0-3 R4-7 G0-3 G4-7
+    __m128i ba = _mm_unpackhi_epi32(lo, hi); // B0-3 B4-7 A0-3 A4-7
+    *r = _mm_cvtepu8_epi16(rg);
+    *g = _mm_cvtepu8_epi16(_mm_srli_si128(rg, 8));
+    *b = _mm_cvtepu8_epi16(ba);
+}
+
+LP_TARGET_SSE41 static __m128i rgb_to_y_sse41(__m128i r, __m128i g, __m128i b)
+{
+    // The sum peaks at 56228, so it fits an unsigned 16-bit lane.
+    __m128i sum = _mm_add_epi16(
+        _mm_add_epi16(_mm_mullo_epi16(r, _mm_set1_epi16(66)),
+                      _mm_mullo_epi16(g, _mm_set1_epi16(129))),
+        _mm_add_epi16(_mm_mullo_epi16(b, _mm_set1_epi16(25)),
+                      _mm_set1_epi16(128)));
+    return _mm_add_epi16(_mm_srli_epi16(sum, 8), _mm_set1_epi16(16));
+}
+
+LP_TARGET_SSE41 static __m128i rgb_to_chroma_sse41(__m128i r,
+                                                   __m128i g,
+                                                   __m128i b,
+                                                   int16_t cr,
+                                                   int16_t cg,
+                                                   int16_t cb)
+{
+    // |sum| stays under 2^15, so signed 16-bit math is exact.
+    __m128i sum = _mm_add_epi16(
+        _mm_add_epi16(_mm_mullo_epi16(r, _mm_set1_epi16(cr)),
+                      _mm_mullo_epi16(g, _mm_set1_epi16(cg))),
+        _mm_add_epi16(_mm_mullo_epi16(b, _mm_set1_epi16(cb)),
+                      _mm_set1_epi16(128)));
+    return _mm_add_epi16(_mm_srai_epi16(sum, 8), _mm_set1_epi16(128));
+}
+
+LP_TARGET_SSE41 static void convert_row_pair_sse41(const uint8_t* row0,
+                                                   const uint8_t* row1,
+                                                   uint32_t width,
+                                                   uint8_t* y0,
+                                                   uint8_t* y1,
+                                                   uint8_t* u,
+                                                   uint8_t* v,
+                                                   uint32_t uvPixelStep,
+                                                   bool swapRB)
+{
+    uint32_t x = 0;
+    for (; x + 8 <= width; x += 8)
+    {
+        __m128i r0, g0, b0, r1, g1, b1;
+        if (swapRB)
+        {
+            load_rgb8_sse41(row0 + x * 4, &b0, &g0, &r0);
+            load_rgb8_sse41(row1 + x * 4, &b1, &g1, &r1);
+        }
+        else
+        {
+            load_rgb8_sse41(row0 + x * 4, &r0, &g0, &b0);
+            load_rgb8_sse41(row1 + x * 4, &r1, &g1, &b1);
+        }
+        _mm_storel_epi64(
+            reinterpret_cast<__m128i*>(y0 + x),
+            _mm_packus_epi16(rgb_to_y_sse41(r0, g0, b0), _mm_setzero_si128()));
+        _mm_storel_epi64(
+            reinterpret_cast<__m128i*>(y1 + x),
+            _mm_packus_epi16(rgb_to_y_sse41(r1, g1, b1), _mm_setzero_si128()));
+
+        // Sum each 2x2 block: vertical add, then horizontal pairs.
+        const __m128i two = _mm_set1_epi16(2);
+        __m128i r = _mm_hadd_epi16(_mm_add_epi16(r0, r1), _mm_setzero_si128());
+        __m128i g = _mm_hadd_epi16(_mm_add_epi16(g0, g1), _mm_setzero_si128());
+        __m128i b = _mm_hadd_epi16(_mm_add_epi16(b0, b1), _mm_setzero_si128());
+        r = _mm_srli_epi16(_mm_add_epi16(r, two), 2);
+        g = _mm_srli_epi16(_mm_add_epi16(g, two), 2);
+        b = _mm_srli_epi16(_mm_add_epi16(b, two), 2);
+        __m128i u8 = _mm_packus_epi16(rgb_to_chroma_sse41(r, g, b, -38, -74, 112),
+                                      _mm_setzero_si128());
+        __m128i v8 = _mm_packus_epi16(rgb_to_chroma_sse41(r, g, b, 112, -94, -18),
+                                      _mm_setzero_si128());
+        if (uvPixelStep == 2)
+        {
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(u + x),
+                             _mm_unpacklo_epi8(u8, v8));
+        }
+        else
+        {
+            int u32 = _mm_cvtsi128_si32(u8);
+            int v32 = _mm_cvtsi128_si32(v8);
+            memcpy(u + x / 2, &u32, 4);
+            memcpy(v + x / 2, &v32, 4);
+        }
+    }
+    convert_row_pair_scalar(row0,
+                            row1,
+                            x,
+                            width,
+                            y0,
+                            y1,
+                            u,
+                            v,
+                            uvPixelStep,
+                            swapRB);
+}
+#endif
+
+#ifdef LP_ARM_NEON
+static uint8x8_t rgb_to_y_neon(uint16x8_t r, uint16x8_t g, uint16x8_t b)
+{
+    uint16x8_t sum = vmulq_n_u16(r, 66);
+    sum = vmlaq_n_u16(sum, g, 129);
+    sum = vmlaq_n_u16(sum, b, 25);
+    sum = vaddq_u16(sum, vdupq_n_u16(128));
+    return vmovn_u16(vaddq_u16(vshrq_n_u16(sum, 8), vdupq_n_u16(16)));
+}
+
+static uint8x8_t rgb_to_chroma_neon(int16x8_t r,
+                                    int16x8_t g,
+                                    int16x8_t b,
+                                    int16_t cr,
+                                    int16_t cg,
+                                    int16_t cb)
+{
+    int16x8_t sum = vmulq_n_s16(r, cr);
+    sum = vmlaq_n_s16(sum, g, cg);
+    sum = vmlaq_n_s16(sum, b, cb);
+    sum = vaddq_s16(sum, vdupq_n_s16(128));
+    return vqmovun_s16(vaddq_s16(vshrq_n_s16(sum, 8), vdupq_n_s16(128)));
+}
+
+static void convert_row_pair_neon(const uint8_t* row0,
+                                  const uint8_t* row1,
+                                  uint32_t width,
+                                  uint8_t* y0,
+                                  uint8_t* y1,
+                                  uint8_t* u,
+                                  uint8_t* v,
+                                  uint32_t uvPixelStep,
+                                  bool swapRB)
+{
+    uint32_t x = 0;
+    for (; x + 16 <= width; x += 16)
+    {
+        uint8x16x4_t p0 = vld4q_u8(row0 + x * 4);
+        uint8x16x4_t p1 = vld4q_u8(row1 + x * 4);
+        if (swapRB)
+        {
+            std::swap(p0.val[0], p0.val[2]);
+            std::swap(p1.val[0], p1.val[2]);
+        }
+        for (int half = 0; half < 2; ++half)
+        {
+            auto widen = [half](uint8x16_t c) {
+                return half ? vmovl_high_u8(c) : vmovl_u8(vget_low_u8(c));
+            };
+            vst1_u8(y0 + x + half * 8,
+                    rgb_to_y_neon(widen(p0.val[0]),
+                                  widen(p0.val[1]),
+                                  widen(p0.val[2])));
+            vst1_u8(y1 + x + half * 8,
+                    rgb_to_y_neon(widen(p1.val[0]),
+                                  widen(p1.val[1]),
+                                  widen(p1.val[2])));
+        }
+
+        // Pairwise-add horizontally, then add the two rows, then round.
+        int16x8_t c[3];
+        for (int i = 0; i < 3; ++i)
+        {
+            uint16x8_t sum =
+                vaddq_u16(vpaddlq_u8(p0.val[i]), vpaddlq_u8(p1.val[i]));
+            c[i] = vreinterpretq_s16_u16(
+                vshrq_n_u16(vaddq_u16(sum, vdupq_n_u16(2)), 2));
+        }
+        uint8x8_t u8 = rgb_to_chroma_neon(c[0], c[1], c[2], -38, -74, 112);
+        uint8x8_t v8 = rgb_to_chroma_neon(c[0], c[1], c[2], 112, -94, -18);
+        if (uvPixelStep == 2)
+        {
+            vst2_u8(u + x, (uint8x8x2_t){{u8, v8}});
+        }
+        else
+        {
+            vst1_u8(u + x / 2, u8);
+            vst1_u8(v + x / 2, v8);
+        }
+    }
+    convert_row_pair_scalar(row0,
+                            row1,
+                            x,
+                            width,
+                            y0,
+                            y1,
+                            u,
+                            v,
+                            uvPixelStep,
+                            swapRB);
+}
+#endif
+
+using ConvertRowPairFn = void (*)(const uint8_t* row0,
+                                  const uint8_t* row1,
+                                  uint32_t width,
+                                  uint8_t* y0,
+                                  uint8_t* y1,
+                                  uint8_t* u,
+                                  uint8_t* v,
+                                  uint32_t uvPixelStep,
+                                  bool swapRB);
+
+static void convert_row_pair_scalar_entry(const uint8_t* row0,
+                                          const uint8_t* row1,
+                                          uint32_t width,
+                                          uint8_t* y0,
+                                          uint8_t* y1,
+                                          uint8_t* u,
+                                          uint8_t* v,
+                                          uint32_t uvPixelStep,
+                                          bool swapRB)
+{
+    convert_row_pair_scalar(row0,
+                            row1,
+                            0,
+                            width,
+                            y0,
+                            y1,
+                            u,
+                            v,
+                            uvPixelStep,
+                            swapRB);
+}
+
+static ConvertRowPairFn select_kernel()
+{
+#ifdef LP_X86
+    if (cpu_features().sse41)
+    {
+        return convert_row_pair_sse41;
+    }
+#endif
+#ifdef LP_ARM_NEON
+    if (cpu_features().neon)
+    {
+        return convert_row_pair_neon;
+    }
+#endif
+    return convert_row_pair_scalar_entry;
+}
+
+void rgba_to_yuv420(const uint8_t* rgbaTopRow,
+                    ptrdiff_t rgbaStride,
+                    uint32_t width,
+                    uint32_t height,
+                    uint32_t rowBegin,
+                    uint32_t rowEnd,
+                    const YUV420Planes& planes,
+                    bool swapRB)
+{
+    static const ConvertRowPairFn convertRowPair = select_kernel();
+    for (uint32_t y = rowBegin; y < rowEnd; y += 2)
+    {
+        // Replicate the last row of an odd-height image.
+        uint32_t y1 = y + 1 < height ? y + 1 : y;
+        uint8_t* yRow0 = planes.y + planes.yStride * y;
+        uint8_t* yRow1 = planes.y + planes.yStride * y1;
+        size_t uvOffset = planes.uvStride * (y / 2);
+        convertRowPair(rgbaTopRow + rgbaStride * static_cast<ptrdiff_t>(y),
+                       rgbaTopRow + rgbaStride * static_cast<ptrdiff_t>(y1),
+                       width,
+                       yRow0,
+                       yRow1,
+                       planes.u + uvOffset,
+                       planes.v + uvOffset,
+                       planes.uvPixelStep,
+                       swapRB);
+    }
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// RGBA -> YUV 4:2:0 (BT.601, limited range) for streaming captured frames
+// to video encoders. Chroma is the average of each 2x2 block, which matches
+// Y4M's "C420jpeg" siting.
+struct YUV420Planes
+{
+    uint8_t* y;
+    size_t yStride;
+    // For NV12, u points at the interleaved UV plane and v == u + 1.
+    uint8_t* u;
+    uint8_t* v;
+    size_t uvStride;
+    // 1 for planar I420, 2 for interleaved NV12.
+    uint32_t uvPixelStep;
+};
+
+// Converts source rows [rowBegin, rowEnd) of a width x height RGBA image.
+// rowBegin must be even so each call owns whole chroma rows; this is what
+// lets callers split a frame across threads by row band. Alpha is ignored.
+// rgbaStride may be negative to read a bottom-up image upright, and swapRB
+// reads BGRA instead.
+void rgba_to_yuv420(const uint8_t* rgbaTopRow,
+                    ptrdiff_t rgbaStride,
+                    uint32_t width,
+                    uint32_t height,
+                    uint32_t rowBegin,
+                    uint32_t rowEnd,
+                    const YUV420Planes&,
+                    bool swapRB = false);